@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+// operator new is replaced, malloc(), calloc() and realloc() are wrapped by
+// the linker with --wrap so only calls from our own objects are counted.  The
+// default operator delete frees what malloc() returned, so it stays.
+
+#include "AllocationCounter.h"
+
+#include <new>
+#include <stdlib.h>
+
+
+#if defined(COUNT_ALLOCATIONS)
+
+static allocation_counts sCounts = {0, 0};
+
+
+extern "C" {
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* address, size_t size);
+
+
+void*
+__wrap_malloc(size_t size)
+{
+	sCounts.count++;
+	sCounts.bytes += size;
+	return __real_malloc(size);
+}
+
+
+void*
+__wrap_calloc(size_t count, size_t size)
+{
+	sCounts.count++;
+	sCounts.bytes += count * size;
+	return __real_calloc(count, size);
+}
+
+
+void*
+__wrap_realloc(void* address, size_t size)
+{
+	sCounts.count++;
+	sCounts.bytes += size;
+	return __real_realloc(address, size);
+}
+
+}
+
+
+static void*
+counted_new(size_t size)
+{
+	sCounts.count++;
+	sCounts.bytes += size;
+
+	void* address = __real_malloc(size > 0 ? size : 1);
+	if (address == NULL)
+		throw std::bad_alloc();
+	return address;
+}
+
+
+void*
+operator new(size_t size)
+{
+	return counted_new(size);
+}
+
+
+void*
+operator new[](size_t size)
+{
+	return counted_new(size);
+}
+
+
+void*
+operator new(size_t size, const std::nothrow_t&) throw()
+{
+	sCounts.count++;
+	sCounts.bytes += size;
+	return __real_malloc(size > 0 ? size : 1);
+}
+
+
+void*
+operator new[](size_t size, const std::nothrow_t&) throw()
+{
+	sCounts.count++;
+	sCounts.bytes += size;
+	return __real_malloc(size > 0 ? size : 1);
+}
+
+
+bool
+get_allocation_counts(allocation_counts& counts)
+{
+	counts = sCounts;
+	return true;
+}
+
+#else
+
+bool
+get_allocation_counts(allocation_counts& counts)
+{
+	counts.count = 0;
+	counts.bytes = 0;
+	return false;
+}
+
+#endif
@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _ALLOCATIONCOUNTER_H_
+#define _ALLOCATIONCOUNTER_H_
+
+
+#include <SupportDefs.h>
+
+
+struct allocation_counts {
+	uint64	count;
+	uint64	bytes;
+};
+
+
+// Allocations made by the weather sources and the benchmark itself, system
+// libraries allocating on their own aren't seen.  Returns false when the
+// build can't count them.
+bool	get_allocation_counts(allocation_counts& counts);
+
+#endif // _ALLOCATIONCOUNTER_H_
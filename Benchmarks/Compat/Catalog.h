@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+// The weather codes only mark their descriptions for translation, without a
+// catalog they stay untranslated.
+
+#ifndef _COMPAT_CATALOG_H_
+#define _COMPAT_CATALOG_H_
+
+
+#define B_TRANSLATE_MARK(string)		(string)
+#define B_TRANSLATE_NOCOLLECT(string)	(string)
+
+#endif // _COMPAT_CATALOG_H_
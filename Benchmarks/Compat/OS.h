@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _COMPAT_OS_H_
+#define _COMPAT_OS_H_
+
+
+#include <SupportDefs.h>
+
+#include <time.h>
+
+
+static inline bigtime_t
+system_time()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (bigtime_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+#endif // _COMPAT_OS_H_
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+// Just enough of Haiku's SupportDefs.h to build the portable parts of the
+// weather core on other hosts for benchmarking.
+
+#ifndef _COMPAT_SUPPORTDEFS_H_
+#define _COMPAT_SUPPORTDEFS_H_
+
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+typedef int8_t		int8;
+typedef uint8_t		uint8;
+typedef int16_t		int16;
+typedef uint16_t	uint16;
+typedef int32_t		int32;
+typedef uint32_t	uint32;
+typedef int64_t		int64;
+typedef uint64_t	uint64;
+
+typedef int32		status_t;
+typedef int64		bigtime_t;
+
+#define B_OK				((status_t)0)
+#define B_ERROR				((status_t)-1)
+#define B_NO_MEMORY			((status_t)INT_MIN)
+#define B_IO_ERROR			((status_t)(INT_MIN + 1))
+#define B_BAD_VALUE			((status_t)(INT_MIN + 5))
+#define B_NAME_NOT_FOUND	((status_t)(INT_MIN + 7))
+#define B_NO_INIT			((status_t)(INT_MIN + 13))
+#define B_BUSY				((status_t)(INT_MIN + 14))
+#define B_BAD_DATA			((status_t)(INT_MIN + 16))
+#define B_WOULD_BLOCK		((status_t)(INT_MIN + 11))
+#define B_ENTRY_NOT_FOUND	((status_t)(INT_MIN + 0x6000 + 3))
+#define B_NOT_SUPPORTED		((status_t)(INT_MIN + 0x7000 + 0x56))
+
+#endif // _COMPAT_SUPPORTDEFS_H_
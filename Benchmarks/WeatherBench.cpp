@@ -0,0 +1,774 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+// Measures every stage of a weather refresh, from building the request to the
+// icon, for replies of different sizes and for 1 or 100 locations.  A reply
+// without a forecast only gets the scan cases.
+//
+//	weather_bench [--time ms | --iterations count] [--filter text]
+//		[--save baseline.json] [--baseline baseline.json [--threshold percent]]
+//		[reply.json ...]
+//
+// Without replies the ones in Benchmarks/Payloads are used, see
+// weather_replay for replies captured by the replicant.  Every location gets
+// its own copy of a reply with other values, so the 100 location cases don't
+// run from a warm cache.  The history cases write a year of observations
+// into a temporary history first.  A case is a regression when it is slower
+// than in the baseline by more than the threshold, or when it allocates more.
+
+#include "AllocationCounter.h"
+#include "Condition.h"
+#include "Downsample.h"
+#include "ForecastModel.h"
+#include "ForecastParser.h"
+#include "ForecastSnapshot.h"
+#include "JsonScanner.h"
+#include "ObservationHistory.h"
+#include "WeatherCode.h"
+
+#include <OS.h>
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__HAIKU__)
+#	include "Formatters.h"
+#	include "OpenMeteo.h"
+
+#	include <Bitmap.h>
+#	include <File.h>
+#	include <IconUtils.h>
+#	include <Message.h>
+#	include <Resources.h>
+#	include <String.h>
+#	include <Url.h>
+#	include <private/shared/Json.h>
+#endif
+
+
+static const char* kDefaultPayloads[] = {
+	BENCHMARK_PAYLOAD_DIR "/open-meteo-current.json",
+	BENCHMARK_PAYLOAD_DIR "/open-meteo-1d.json",
+	BENCHMARK_PAYLOAD_DIR "/open-meteo-1d-hourly.json",
+	BENCHMARK_PAYLOAD_DIR "/open-meteo-7d.json",
+	BENCHMARK_PAYLOAD_DIR "/open-meteo-7d-hourly.json",
+	BENCHMARK_PAYLOAD_DIR "/open-meteo-16d.json",
+	BENCHMARK_PAYLOAD_DIR "/open-meteo-16d-hourly.json"
+};
+
+static const int32 kLocationCounts[] = {1, 100};
+static const int32 kMaxLocations = 100;
+static const int32 kMaxCases = 512;
+static const int32 kBatchSize = 64;
+static const int32 kChartSampleWidth = 400;
+static const int32 kHistoryYear = 365 * 24 * 4;
+static const int32 kHistoryInterval = 15 * 60;
+static const uint32 kReplicantFields = kForecastTemperature | kForecastFeelsLike | kForecastWeatherCode
+	| kForecastTodayRange;
+
+
+struct location {
+	char*			data;
+	double			latitude;
+	double			longitude;
+	current_weather	current;
+	ForecastModel	forecast;
+	Condition		condition;
+};
+
+
+struct bench_context {
+	size_t			length;
+	bool			hourly;
+	location*		locations;
+	int32			locationCount;
+
+	ForecastParser	parser;
+	ForecastModel	forecast;
+	current_weather	current;
+	uint64			sink;
+};
+
+
+struct bench_result {
+	char			name[96];
+	double			nanoseconds;
+	double			allocations;
+	double			bytes;
+	double			megabytes;	// of the reply per second, 0 for stages that don't read it
+};
+
+
+typedef void (*stage_function)(bench_context& context, location& place);
+
+
+static bigtime_t sTargetTime = 100000;
+static int64 sIterations = 0;
+static const char* sFilter = NULL;
+static bench_result sResults[kMaxCases];
+static int32 sResultCount = 0;
+static bench_result sBaseline[kMaxCases];
+static int32 sBaselineCount = 0;
+static double sThreshold = 10.0;
+static int32 sRegressions = 0;
+static bool sCountsAllocations = false;
+static history_record* sHistoryRecords = NULL;
+static ObservationHistory* sHistory = NULL;
+static uint8 sHistoryBlock[kHistoryMaxBlockSize];
+static int32 sHistoryNext = 0;
+
+
+static char*
+load_file(const char* path, size_t& length)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return NULL;
+
+	char* data = NULL;
+	if (fseek(file, 0, SEEK_END) == 0) {
+		long size = ftell(file);
+		if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+			data = static_cast<char*>(malloc(size + 1));
+			if (data != NULL && fread(data, 1, size, file) == static_cast<size_t>(size)) {
+				data[size] = '\0';
+				length = size;
+			} else {
+				free(data);
+				data = NULL;
+			}
+		}
+	}
+
+	fclose(file);
+	return data;
+}
+
+
+// "Payloads/open-meteo-7d.json" is "7d"
+static void
+payload_name(const char* path, char* name, size_t size)
+{
+	const char* start = strrchr(path, '/');
+	start = start != NULL ? start + 1 : path;
+	if (strncmp(start, "open-meteo-", 11) == 0)
+		start += 11;
+
+	snprintf(name, size, "%s", start);
+	char* extension = strrchr(name, '.');
+	if (extension != NULL && strcmp(extension, ".json") == 0)
+		*extension = '\0';
+}
+
+
+// another location with the same layout, only the decimals of the numbers differ
+static char*
+make_location(const char* data, size_t length, int32 index)
+{
+	char* copy = static_cast<char*>(malloc(length + 1));
+	if (copy == NULL)
+		return NULL;
+
+	memcpy(copy, data, length + 1);
+	bool fraction = false;
+	for (size_t x = 0; x < length; x++) {
+		char c = copy[x];
+		if (c >= '0' && c <= '9') {
+			if (fraction)
+				copy[x] = '0' + (c - '0' + index) % 10;
+		} else
+			fraction = c == '.';
+	}
+
+	return copy;
+}
+
+
+static const bench_result*
+find_baseline(const char* name)
+{
+	for (int32 x = 0; x < sBaselineCount; x++) {
+		if (strcmp(sBaseline[x].name, name) == 0)
+			return &sBaseline[x];
+	}
+
+	return NULL;
+}
+
+
+static void
+report(const bench_result& result)
+{
+	printf("  %-32s %12.1f", result.name, result.nanoseconds);
+	if (sCountsAllocations)
+		printf(" %10.2f %10.1f", result.allocations, result.bytes);
+	else
+		printf(" %10s %10s", "-", "-");
+
+	if (result.megabytes > 0)
+		printf(" %9.1f", result.megabytes);
+	else
+		printf(" %9s", "-");
+
+	const bench_result* baseline = find_baseline(result.name);
+	if (baseline != NULL && baseline->nanoseconds > 0) {
+		double change = (result.nanoseconds / baseline->nanoseconds - 1) * 100;
+		bool allocates = sCountsAllocations
+			&& (result.allocations > baseline->allocations + 0.005 || result.bytes > baseline->bytes + 0.5);
+		printf(" %+8.1f%%", change);
+		if (change > sThreshold || allocates) {
+			printf("  REGRESSION%s", allocates ? " (allocations)" : "");
+			sRegressions++;
+		}
+	}
+
+	printf("\n");
+}
+
+
+static void
+measure(const char* stage, const char* payload, bench_context& context, stage_function function)
+{
+	if (sResultCount == kMaxCases)
+		return;
+
+	bench_result& result = sResults[sResultCount];
+	snprintf(result.name, sizeof(result.name), "%s/%s/x%d", stage, payload,
+		static_cast<int>(context.locationCount));
+	if (sFilter != NULL && strstr(result.name, sFilter) == NULL)
+		return;
+
+	// once through every location to warm up
+	for (int32 x = 0; x < context.locationCount; x++)
+		function(context, context.locations[x]);
+
+	allocation_counts before, after;
+	get_allocation_counts(before);
+
+	int64 operations = 0;
+	int32 next = 0;
+	bigtime_t start = system_time();
+	bigtime_t elapsed;
+	do {
+		for (int32 x = 0; x < kBatchSize; x++) {
+			function(context, context.locations[next]);
+			if (++next == context.locationCount)
+				next = 0;
+		}
+		operations += kBatchSize;
+		elapsed = system_time() - start;
+	} while (sIterations > 0 ? operations < sIterations : elapsed < sTargetTime);
+
+	get_allocation_counts(after);
+
+	result.nanoseconds = elapsed * 1000.0 / operations;
+	result.allocations = static_cast<double>(after.count - before.count) / operations;
+	result.bytes = static_cast<double>(after.bytes - before.bytes) / operations;
+	result.megabytes = 0;
+	if (strncmp(stage, "scan-", 5) == 0 || strcmp(stage, "parse") == 0 || strcmp(stage, "bjson") == 0)
+		result.megabytes = context.length * 1000000000.0 / (1024 * 1024) / result.nanoseconds;
+	sResultCount++;
+
+	report(result);
+}
+
+
+//	#pragma mark - stages
+
+
+static void
+stage_scan(bench_context& context, location& place)
+{
+	context.parser.Scanner().Scan(place.data, context.length);
+}
+
+
+static void
+stage_parse(bench_context& context, location& place)
+{
+	context.parser.Parse(place.data, context.length, kMaxForecastDays, context.hourly, kForecastAllFields,
+		context.current, context.forecast);
+}
+
+
+// a background refresh with only the replicant and its tooltip to update
+static void
+stage_parse_replicant(bench_context& context, location& place)
+{
+	context.parser.Parse(place.data, context.length, kMaxForecastDays, context.hourly, kReplicantFields,
+		context.current, context.forecast);
+}
+
+
+// a new model for every reply instead of reusing one
+static void
+stage_model(bench_context& context, location& place)
+{
+	ForecastModel* forecast = new ForecastModel();
+	context.parser.Parse(place.data, context.length, kMaxForecastDays, context.hourly, kForecastAllFields,
+		context.current, *forecast);
+	context.sink += forecast->CountHours();
+	delete forecast;
+}
+
+
+static uint64
+map_code(int32 value)
+{
+	weather_code code = to_weather_code(value);
+	return weather_code_severity(code) + weather_code_precipitation(code)
+		+ static_cast<uint8>(weather_code_description(code)[0]);
+}
+
+
+static void
+stage_codes(bench_context& context, location& place)
+{
+	const ForecastModel& forecast = place.forecast;
+	uint64 sum = map_code(place.current.weatherCode);
+	for (int32 x = 0; x < forecast.CountDays(); x++)
+		sum += map_code(forecast.DayCodes()[x]);
+	for (int32 x = 0; x < forecast.CountHours(); x++)
+		sum += map_code(forecast.HourlyCodes()[x]);
+
+	context.sink += sum;
+}
+
+
+// what the replicant and the forecast window take from a parsed reply
+static void
+stage_publish(bench_context& context, location& place)
+{
+	place.condition.SetTo(place.current);
+
+	forecast_snapshot snapshot;
+	build_forecast_snapshot(snapshot, place.condition, place.forecast, false);
+	uint64 sum = snapshot.current.iTemp();
+	for (int32 x = 0; x < snapshot.dayCount; x++)
+		sum += snapshot.days[x].iHigh() + snapshot.rain[x];
+
+	context.sink += sum;
+}
+
+
+// what the forecast window chart draws of the hourly temperatures at its usual width
+static void
+stage_downsample(bench_context& context, location& place)
+{
+	int32 selected[kMaxForecastHours];
+	int32 count = downsample_lttb(place.forecast.HourlyTemperatures(), place.forecast.CountHours(),
+		kChartSampleWidth, selected);
+	for (int32 x = 0; x < count; x++)
+		context.sink += selected[x];
+}
+
+
+static void
+stage_icon(bench_context& context, location& place)
+{
+	uint64 sum = static_cast<uint8>(place.condition.Icon()[0]);
+	for (int32 x = 0; x < place.forecast.CountDays(); x++)
+		sum += static_cast<uint8>(weather_code_icon(to_weather_code(place.forecast.DayCodes()[x]))[0]);
+
+	context.sink += sum;
+}
+
+
+// seals a block of a day and a half into the format that's written to disk
+static void
+stage_history_encode(bench_context& context, location& /*place*/)
+{
+	sHistoryNext = (sHistoryNext + kHistoryBlockCount) % (kHistoryYear - kHistoryBlockCount);
+	context.sink += encode_history_block(sHistoryRecords + sHistoryNext, kHistoryBlockCount, sHistoryBlock);
+}
+
+
+static void
+query_history(bench_context& context, int32 length)
+{
+	static time_t times[kHistoryYear];
+	static float values[kHistoryYear];
+
+	sHistoryNext = (sHistoryNext + 97) % (kHistoryYear - length);
+	time_t start = sHistoryRecords[sHistoryNext].time;
+	int32 count = sHistory->Read(start, start + (length - 1) * kHistoryInterval, kHistoryTemperature, false,
+		times, values, kHistoryYear);
+	for (int32 x = 0; x < count; x++)
+		context.sink += static_cast<int32>(values[x]);
+}
+
+
+// what a chart of the last day or week of a location would read
+static void
+stage_history_day(bench_context& context, location& /*place*/)
+{
+	query_history(context, 24 * 4);
+}
+
+
+static void
+stage_history_week(bench_context& context, location& /*place*/)
+{
+	query_history(context, 7 * 24 * 4);
+}
+
+
+#if defined(__HAIKU__)
+
+static void
+stage_url(bench_context& context, location& place)
+{
+	BString url;
+	OpenMeteo::BuildRequestUrl(url, place.latitude, place.longitude, false, kMaxForecastDays, context.hourly);
+#	if B_HAIKU_VERSION > B_HAIKU_VERSION_1_BETA_5
+	BUrl request(url, true);
+#	else
+	BUrl request(url);
+#	endif
+	context.sink += request.IsValid();
+}
+
+
+static void
+stage_format(bench_context& context, location& place)
+{
+	BString updated;
+	format_date_time(updated, place.condition.Day(), B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT);
+
+	BString tooltip;
+	format_tooltip(tooltip, "Berlin, Land Berlin", place.condition, false, updated.String());
+	BString notification;
+	format_notification(notification, "Berlin, Land Berlin", place.condition);
+
+	context.sink += tooltip.Length() + notification.Length();
+}
+
+
+// what IconCache does once for every icon and size, on the resources of the replicant
+static void
+stage_icon_bitmap(bench_context& context, location& place)
+{
+	BBitmap bitmap(BRect(0, 0, 15, 15), B_RGBA32);
+	BFile file(BENCHMARK_APP_PATH, B_READ_ONLY);
+	BResources resources(&file);
+
+	size_t size;
+	const void* data = resources.LoadResource(B_VECTOR_ICON_TYPE, place.condition.Icon(), &size);
+	if (data != NULL)
+		context.sink += BIconUtils::GetVectorIcon(static_cast<const uint8*>(data), size, &bitmap) == B_OK;
+}
+
+
+// what the replicant used before it had its own parser
+static void
+stage_bjson(bench_context& context, location& place)
+{
+	BMessage message;
+	BPrivate::BJson::Parse(place.data, message);
+	context.sink += message.CountNames(B_ANY_TYPE);
+}
+
+#endif
+
+
+//	#pragma mark -
+
+
+static void
+run(const char* path)
+{
+	size_t length = 0;
+	char* data = load_file(path, length);
+	if (data == NULL) {
+		fprintf(stderr, "could not read %s\n", path);
+		return;
+	}
+
+	char name[64];
+	payload_name(path, name, sizeof(name));
+
+	bench_context* context = new bench_context;
+	context->length = length;
+	context->hourly = strstr(data, "\"hourly\"") != NULL;
+	context->sink = 0;
+	context->locations = new location[kMaxLocations];
+	context->locationCount = 0;
+
+	// a reply without a forecast, like one for the current conditions only, is only scanned
+	bool valid = true;
+	bool forecast = true;
+	for (int32 x = 0; x < kMaxLocations; x++) {
+		location& place = context->locations[x];
+		place.data = make_location(data, length, x);
+		place.latitude = 52.52 - x * 0.37;
+		place.longitude = 13.41 + x * 0.53;
+		if (place.data == NULL)
+			valid = false;
+		else if (forecast && context->parser.Parse(place.data, length, kMaxForecastDays, context->hourly,
+				kForecastAllFields, place.current, place.forecast) == B_OK)
+			place.condition.SetTo(place.current);
+		else
+			forecast = false;
+	}
+
+	if (valid && !forecast)
+		valid = context->parser.Scanner().Scan(data, length) == B_OK;
+
+	if (!valid)
+		fprintf(stderr, "%s is not a valid reply\n", path);
+	else {
+		printf("%s (%lu bytes%s)\n", path, static_cast<unsigned long>(length), forecast ? "" : ", scan only");
+
+		for (size_t count = 0; count < sizeof(kLocationCounts) / sizeof(kLocationCounts[0]); count++) {
+			context->locationCount = kLocationCounts[count];
+
+			// the structural scan alone, once for every method this CPU has
+			if (context->locationCount == 1) {
+				JsonScanner& scanner = context->parser.Scanner();
+				for (int32 method = JSON_SCAN_SCALAR; method <= JSON_SCAN_AVX2; method++) {
+					if (scanner.SetMethod(static_cast<json_scan_method>(method)) != B_OK)
+						continue;
+
+					char stage[32];
+					snprintf(stage, sizeof(stage), "scan-%s", JsonScanner::MethodName(scanner.Method()));
+					measure(stage, name, *context, &stage_scan);
+				}
+				scanner.SetMethod(JSON_SCAN_AUTO);
+			}
+
+			if (!forecast)
+				break;
+
+#if defined(__HAIKU__)
+			measure("url", name, *context, &stage_url);
+#endif
+			measure("parse", name, *context, &stage_parse);
+			measure("parse-replicant", name, *context, &stage_parse_replicant);
+			measure("model", name, *context, &stage_model);
+			measure("codes", name, *context, &stage_codes);
+			measure("publish", name, *context, &stage_publish);
+			if (context->hourly)
+				measure("downsample", name, *context, &stage_downsample);
+			measure("icon", name, *context, &stage_icon);
+#if defined(__HAIKU__)
+			measure("format", name, *context, &stage_format);
+			measure("icon-bitmap", name, *context, &stage_icon_bitmap);
+			measure("bjson", name, *context, &stage_bjson);
+#endif
+		}
+	}
+
+	for (int32 x = 0; x < kMaxLocations; x++)
+		free(context->locations[x].data);
+	delete[] context->locations;
+	delete context;
+	free(data);
+}
+
+
+// a year of observations every 15 minutes, rounded like the replies
+static void
+make_history(history_record* records, int32 count)
+{
+	uint32 random = 1;
+	float direction = 180;
+	float cloud = 50;
+	int16 code = 0;
+	for (int32 x = 0; x < count; x++) {
+		random = random * 1103515245 + 12345;
+		float noise = ((random >> 16) & 0x3ff) / 1024.0f - 0.5f;
+		float day = x / 96.0f;
+		float temperature = 9 - 10 * cosf(day * 2 * M_PI / 365) - 5 * cosf(day * 2 * M_PI) + noise;
+		float wind = 12 + 8 * sinf(day * 0.7f) + noise * 4;
+
+		direction = fmodf(direction + noise * 20 + 360, 360);
+		cloud = fminf(fmaxf(cloud + noise * 10, 0), 100);
+		if ((random >> 8) % 64 == 0)
+			code = cloud > 80 ? 61 : cloud > 50 ? 3 : cloud > 20 ? 2 : 0;
+
+		history_record& record = records[x];
+		record.time = 1704067200 + static_cast<int64>(x) * kHistoryInterval;
+		record.values[kHistoryTemperature] = roundf(temperature * 10) / 10;
+		record.values[kHistoryFeelsLike] = roundf((temperature - wind * 0.1f) * 10) / 10;
+		record.values[kHistoryHumidity] = roundf(75 + 15 * cosf(day * 2 * M_PI) + noise * 10);
+		record.values[kHistoryWindSpeed] = roundf(wind * 10) / 10;
+		record.values[kHistoryWindDirection] = roundf(direction);
+		record.values[kHistoryCloudCover] = roundf(cloud);
+		record.values[kHistoryWeatherCode] = code;
+		record.flags = 0;
+	}
+}
+
+
+static void
+run_history()
+{
+	char path[PATH_MAX];
+	const char* directory = getenv("TMPDIR");
+	snprintf(path, sizeof(path), "%s/weather_bench-%d.history", directory != NULL ? directory : "/tmp",
+		static_cast<int>(getpid()));
+	char tailPath[PATH_MAX + 8];
+	snprintf(tailPath, sizeof(tailPath), "%s.tail", path);
+
+	sHistoryRecords = new history_record[kHistoryYear];
+	make_history(sHistoryRecords, kHistoryYear);
+
+	sHistory = new ObservationHistory();
+	status_t status = sHistory->Open(path);
+	for (int32 x = 0; status == B_OK && x < kHistoryYear; x++)
+		status = sHistory->Append(sHistoryRecords[x]);
+
+	if (status != B_OK)
+		fprintf(stderr, "could not write the history %s\n", path);
+	else {
+		int64 size = sHistory->DiskSize();
+		printf("history (%d observations in %lld bytes, %.1f bytes each)\n",
+			static_cast<int>(sHistory->CountObservations()), static_cast<long long>(size),
+			static_cast<double>(size) / sHistory->CountObservations());
+
+		bench_context* context = new bench_context;
+		context->sink = 0;
+		context->locations = new location[1];
+		context->locationCount = 1;
+		context->locations[0].data = NULL;
+
+		measure("history-encode", "year", *context, &stage_history_encode);
+		measure("history-query-day", "year", *context, &stage_history_day);
+		measure("history-query-week", "year", *context, &stage_history_week);
+
+		delete[] context->locations;
+		delete context;
+	}
+
+	delete sHistory;
+	sHistory = NULL;
+	delete[] sHistoryRecords;
+	sHistoryRecords = NULL;
+	unlink(path);
+	unlink(tailPath);
+}
+
+
+static status_t
+save_results(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return B_IO_ERROR;
+
+	fprintf(file, "{\n\t\"version\": 1,\n\t\"cases\": [\n");
+	for (int32 x = 0; x < sResultCount; x++) {
+		fprintf(file, "\t\t{\"name\": \"%s\", \"ns\": %.1f, \"allocs\": %.2f, \"bytes\": %.1f, \"mbs\": %.1f}%s\n",
+			sResults[x].name, sResults[x].nanoseconds, sResults[x].allocations, sResults[x].bytes,
+			sResults[x].megabytes, x + 1 < sResultCount ? "," : "");
+	}
+	fprintf(file, "\t]\n}\n");
+
+	return fclose(file) == 0 ? B_OK : B_IO_ERROR;
+}
+
+
+// only reads what save_results() writes, one case per line
+static status_t
+load_baseline(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	char line[256];
+	while (sBaselineCount < kMaxCases && fgets(line, sizeof(line), file) != NULL) {
+		const char* start = strstr(line, "{\"name\"");
+		if (start == NULL)
+			continue;
+
+		bench_result& result = sBaseline[sBaselineCount];
+		// the throughput is left out, it follows from the time
+		if (sscanf(start, "{\"name\": \"%95[^\"]\", \"ns\": %lf, \"allocs\": %lf, \"bytes\": %lf", result.name,
+				&result.nanoseconds, &result.allocations, &result.bytes) == 4)
+			sBaselineCount++;
+	}
+
+	fclose(file);
+	return sBaselineCount > 0 ? B_OK : B_BAD_DATA;
+}
+
+
+static void
+usage(const char* name)
+{
+	fprintf(stderr, "usage: %s [--time ms | --iterations count] [--filter text]\n"
+		"\t[--save baseline.json] [--baseline baseline.json [--threshold percent]] [reply.json ...]\n", name);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const char* savePath = NULL;
+	const char* baselinePath = NULL;
+
+	int32 first = 1;
+	for (; first + 1 < argc && strncmp(argv[first], "--", 2) == 0; first += 2) {
+		const char* value = argv[first + 1];
+		if (strcmp(argv[first], "--time") == 0)
+			sTargetTime = atoi(value) * 1000LL;
+		else if (strcmp(argv[first], "--iterations") == 0)
+			sIterations = atoll(value);
+		else if (strcmp(argv[first], "--filter") == 0)
+			sFilter = value;
+		else if (strcmp(argv[first], "--save") == 0)
+			savePath = value;
+		else if (strcmp(argv[first], "--baseline") == 0)
+			baselinePath = value;
+		else if (strcmp(argv[first], "--threshold") == 0)
+			sThreshold = atof(value);
+		else
+			break;
+	}
+
+	if ((first < argc && strncmp(argv[first], "--", 2) == 0) || sTargetTime <= 0 || sIterations < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (baselinePath != NULL && load_baseline(baselinePath) != B_OK) {
+		fprintf(stderr, "could not read the baseline %s\n", baselinePath);
+		return 1;
+	}
+
+	allocation_counts counts;
+	sCountsAllocations = get_allocation_counts(counts);
+
+	// what a location costs before the forecast itself
+	printf("Condition %lu bytes, forecast_snapshot %lu bytes\n", static_cast<unsigned long>(sizeof(Condition)),
+		static_cast<unsigned long>(sizeof(forecast_snapshot)));
+	printf("  %-32s %12s %10s %10s %9s%s\n", "case", "ns/op", "allocs/op", "bytes/op", "MB/s",
+		sBaselineCount > 0 ? "    change" : "");
+
+	if (first >= argc) {
+		for (size_t x = 0; x < sizeof(kDefaultPayloads) / sizeof(kDefaultPayloads[0]); x++)
+			run(kDefaultPayloads[x]);
+	} else {
+		for (int32 x = first; x < argc; x++)
+			run(argv[x]);
+	}
+
+	run_history();
+
+	if (savePath != NULL && save_results(savePath) != B_OK) {
+		fprintf(stderr, "could not write %s\n", savePath);
+		return 1;
+	}
+
+	if (sRegressions > 0) {
+		printf("%d regressions against %s\n", static_cast<int>(sRegressions), baselinePath);
+		return 2;
+	}
+
+	return 0;
+}
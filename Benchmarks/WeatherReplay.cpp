@@ -0,0 +1,387 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+// Replays a capture archive through the transport and the forecast parser the
+// way the replicant refreshes, one request after the other, and measures how
+// long every refresh takes from the request until the forecast is ready.
+//
+//	weather_replay [--latency ms] [--bandwidth KiB/s] [--repeat count] [--trace trace.json] archive
+//	weather_replay --import archive reply.json ...
+//
+// Archives are captured with "DeskbarWeather --capture", --import wraps
+// saved replies into an archive.  --trace writes a timeline of the replay
+// that chrome://tracing and Perfetto can show.
+
+#include "CaptureArchive.h"
+#include "ForecastModel.h"
+#include "ForecastParser.h"
+#include "ReplayTransport.h"
+#include "RequestStats.h"
+#include "Trace.h"
+
+#include <OS.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static const char* kOpenMeteoHost = "api.open-meteo.com";
+
+
+// does with a reply what OpenMeteo::ParseResult() does
+class RefreshListener : public TransportListener {
+public:
+	RefreshListener()
+		:
+		fReply(NULL),
+		fReplySize(0),
+		fDone(false),
+		fStatus(B_OK),
+		fParseTime(0),
+		fBytes(0)
+	{
+		pthread_mutex_init(&fLock, NULL);
+		pthread_cond_init(&fCondition, NULL);
+	}
+
+
+	virtual
+	~RefreshListener()
+	{
+		free(fReply);
+		pthread_cond_destroy(&fCondition);
+		pthread_mutex_destroy(&fLock);
+	}
+
+
+	virtual void
+	ExchangeCompleted(const transport_exchange& exchange)
+	{
+		status_t status = B_OK;
+		bigtime_t parseTime = 0;
+
+		if (strstr(exchange.url, kOpenMeteoHost) != NULL) {
+			fStats.AddExchange(exchange);
+			if (exchange.status < 200 || exchange.status > 299)
+				status = B_ERROR;
+			else {
+				bigtime_t start = system_time();
+				status = _Parse(exchange);
+				parseTime = system_time() - start;
+				fStats.AddPhase(kPhaseParse, parseTime);
+			}
+		}
+
+		pthread_mutex_lock(&fLock);
+		fStatus = status;
+		fParseTime = parseTime;
+		fBytes = exchange.bodySize;
+		fDone = true;
+		pthread_cond_signal(&fCondition);
+		pthread_mutex_unlock(&fLock);
+	}
+
+
+	status_t
+	Wait(bigtime_t& parseTime, size_t& bytes)
+	{
+		pthread_mutex_lock(&fLock);
+		while (!fDone)
+			pthread_cond_wait(&fCondition, &fLock);
+
+		fDone = false;
+		status_t status = fStatus;
+		parseTime = fParseTime;
+		bytes = fBytes;
+		pthread_mutex_unlock(&fLock);
+
+		return status;
+	}
+
+
+	RequestStats&
+	Stats()
+	{
+		return fStats;
+	}
+
+private:
+	status_t
+	_Parse(const transport_exchange& exchange)
+	{
+		TRACE_SCOPE("ParseResult");
+		if (exchange.bodySize > fReplySize) {
+			char* reply = static_cast<char*>(realloc(fReply, exchange.bodySize));
+			if (reply == NULL)
+				return B_NO_MEMORY;
+
+			fReply = reply;
+			fReplySize = exchange.bodySize;
+		}
+		memcpy(fReply, exchange.body, exchange.bodySize);
+
+		// the request tells how much of the forecast to expect
+		int32 days = 1;
+		const char* forecastDays = strstr(exchange.url, "forecast_days=");
+		if (forecastDays != NULL)
+			days = atoi(forecastDays + strlen("forecast_days="));
+		bool hourly = strstr(exchange.url, "&hourly=") != NULL;
+
+		return fParser.Parse(fReply, exchange.bodySize, days, hourly, kForecastAllFields, fCurrent, fForecast);
+	}
+
+	ForecastParser		fParser;
+	RequestStats		fStats;
+	ForecastModel		fForecast;
+	current_weather		fCurrent;
+	char*				fReply;
+	size_t				fReplySize;
+
+	pthread_mutex_t		fLock;
+	pthread_cond_t		fCondition;
+	bool				fDone;
+	status_t			fStatus;
+	bigtime_t			fParseTime;
+	size_t				fBytes;
+};
+
+
+static int
+compare_times(const void* first, const void* second)
+{
+	bigtime_t a = *static_cast<const bigtime_t*>(first);
+	bigtime_t b = *static_cast<const bigtime_t*>(second);
+	return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+
+static char*
+load_file(const char* path, size_t& length)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return NULL;
+
+	char* data = NULL;
+	if (fseek(file, 0, SEEK_END) == 0) {
+		long size = ftell(file);
+		if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+			data = static_cast<char*>(malloc(size + 1));
+			if (data != NULL && fread(data, 1, size, file) == static_cast<size_t>(size)) {
+				data[size] = '\0';
+				length = size;
+			} else {
+				free(data);
+				data = NULL;
+			}
+		}
+	}
+
+	fclose(file);
+	return data;
+}
+
+
+// the days of the daily forecast, 0 for a reply without one
+static int32
+count_days(ForecastParser& parser, const char* data, size_t length)
+{
+	current_weather current;
+	ForecastModel forecast;
+	if (parser.Parse(data, length, kMaxForecastDays, false, kForecastDaily, current, forecast) != B_OK)
+		return 0;
+
+	return forecast.CountDays();
+}
+
+
+static int
+import(const char* archive, int32 count, char** paths)
+{
+	ForecastParser parser;
+	CaptureRecorder recorder;
+	if (recorder.Open(archive) != B_OK) {
+		fprintf(stderr, "could not create %s\n", archive);
+		return 1;
+	}
+
+	for (int32 x = 0; x < count; x++) {
+		size_t length = 0;
+		char* data = load_file(paths[x], length);
+		if (data == NULL) {
+			fprintf(stderr, "could not read %s\n", paths[x]);
+			continue;
+		}
+
+		// a request the reply could have come from
+		char url[256];
+		snprintf(url, sizeof(url), "https://%s/v1/forecast?reply=%d&forecast_days=%d%s", kOpenMeteoHost,
+			static_cast<int>(x), static_cast<int>(count_days(parser, data, length)),
+			strstr(data, "\"hourly\"") != NULL ? "&hourly=temperature_2m" : "");
+
+		transport_exchange exchange;
+		exchange.url = url;
+		exchange.status = 200;
+		exchange.statusText = "OK";
+		exchange.body = data;
+		exchange.bodySize = length;
+		exchange.time = static_cast<bigtime_t>(::time(NULL)) * 1000000;
+		exchange.duration = 0;
+		exchange.resolveTime = exchange.connectTime = exchange.waitTime = exchange.transferTime = -1;
+
+		if (recorder.Record(exchange) != B_OK)
+			fprintf(stderr, "could not record %s\n", paths[x]);
+		free(data);
+	}
+
+	uint32 recorded = recorder.CountRecorded();
+	if (recorder.Close() != B_OK) {
+		fprintf(stderr, "could not write %s\n", archive);
+		return 1;
+	}
+
+	printf("%u replies in %s\n", static_cast<unsigned>(recorded), archive);
+	return 0;
+}
+
+
+static int
+replay(const char* archive, bigtime_t latency, int64 bandwidth, int32 repeat, const char* tracePath)
+{
+	ReplayTransport transport;
+	if (transport.Load(archive) != B_OK) {
+		fprintf(stderr, "%s is not a capture archive\n", archive);
+		return 1;
+	}
+
+	int32 count = transport.Archive().CountExchanges();
+	if (count == 0) {
+		fprintf(stderr, "%s is empty\n", archive);
+		return 1;
+	}
+
+	transport.SetLatency(latency);
+	transport.SetBandwidth(bandwidth);
+
+	bigtime_t* times = static_cast<bigtime_t*>(malloc(count * repeat * sizeof(bigtime_t)));
+	if (times == NULL)
+		return 1;
+
+	RefreshListener listener;
+	bigtime_t parseTime = 0;
+	uint64 bytes = 0;
+	int32 failed = 0;
+	int32 refreshes = 0;
+
+	if (tracePath != NULL)
+		Trace::Start();
+
+	bigtime_t start = system_time();
+	for (int32 round = 0; round < repeat; round++) {
+		for (int32 x = 0; x < count; x++) {
+			TRACE_SCOPE("refresh");
+			bigtime_t requested = system_time();
+			if (transport.Fetch(transport.Archive().ExchangeAt(x).url, &listener) != B_OK) {
+				failed++;
+				continue;
+			}
+
+			bigtime_t replyParseTime;
+			size_t replyBytes;
+			if (listener.Wait(replyParseTime, replyBytes) != B_OK)
+				failed++;
+
+			times[refreshes++] = system_time() - requested;
+			parseTime += replyParseTime;
+			bytes += replyBytes;
+		}
+	}
+	bigtime_t elapsed = system_time() - start;
+
+	if (tracePath != NULL) {
+		Trace::Stop();
+		if (Trace::Dump(tracePath) != B_OK)
+			fprintf(stderr, "could not write %s\n", tracePath);
+	}
+
+	if (refreshes == 0) {
+		free(times);
+		return 1;
+	}
+
+	qsort(times, refreshes, sizeof(bigtime_t), &compare_times);
+
+	printf("%s: %d replies, %d refreshes, %d failed\n", archive, static_cast<int>(count),
+		static_cast<int>(refreshes), static_cast<int>(failed));
+	printf("  refresh     min %lld us, median %lld us, p95 %lld us, max %lld us\n",
+		static_cast<long long>(times[0]), static_cast<long long>(times[refreshes / 2]),
+		static_cast<long long>(times[(refreshes * 95) / 100]),
+		static_cast<long long>(times[refreshes - 1]));
+	printf("  parse       %.2f us/refresh\n", static_cast<double>(parseTime) / refreshes);
+	printf("  throughput  %.1f refreshes/s, %.1f KiB/s\n",
+		refreshes / (elapsed / 1000000.0), bytes / 1024.0 / (elapsed / 1000000.0));
+
+	// the same histograms the replicant keeps for --stats
+	request_stats stats;
+	listener.Stats().Get(stats);
+	for (int32 phase = 0; phase < kPhaseCount; phase++) {
+		const Histogram& histogram = stats.phases[phase];
+		if (histogram.Count() == 0)
+			continue;
+
+		printf("  %-10s  median %llu us, p95 %llu us, max %llu us\n",
+			RequestStats::PhaseName(static_cast<request_phase>(phase)),
+			static_cast<unsigned long long>(histogram.Percentile(50)),
+			static_cast<unsigned long long>(histogram.Percentile(95)),
+			static_cast<unsigned long long>(histogram.Max()));
+	}
+
+	free(times);
+	return 0;
+}
+
+
+static void
+usage(const char* name)
+{
+	fprintf(stderr, "usage: %s [--latency ms] [--bandwidth KiB/s] [--repeat count] [--trace trace.json] archive\n",
+		name);
+	fprintf(stderr, "       %s --import archive reply.json ...\n", name);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc > 3 && strcmp(argv[1], "--import") == 0)
+		return import(argv[2], argc - 3, argv + 3);
+
+	bigtime_t latency = -1;
+	int64 bandwidth = 0;
+	int32 repeat = 1;
+	const char* tracePath = NULL;
+
+	int32 x = 1;
+	for (; x + 1 < argc && strncmp(argv[x], "--", 2) == 0; x += 2) {
+		if (strcmp(argv[x], "--latency") == 0)
+			latency = atoi(argv[x + 1]) * 1000LL;
+		else if (strcmp(argv[x], "--bandwidth") == 0)
+			bandwidth = atoi(argv[x + 1]) * 1024LL;
+		else if (strcmp(argv[x], "--repeat") == 0)
+			repeat = atoi(argv[x + 1]);
+		else if (strcmp(argv[x], "--trace") == 0)
+			tracePath = argv[x + 1];
+		else
+			break;
+	}
+
+	if (x != argc - 1 || repeat <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	return replay(argv[x], latency, bandwidth, repeat, tracePath);
+}
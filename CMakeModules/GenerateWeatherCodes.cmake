@@ -0,0 +1,89 @@
+#=============================================================================
+# SPDX-FileCopyrightText: 2021 Chris Roberts
+#
+# SPDX-License-Identifier: MIT
+#=============================================================================
+
+#
+# - Generate the weather code lookup table
+#
+#	cmake -DINPUT=WeatherCodes.txt -DOUTPUT=WeatherCodeTable.h -P GenerateWeatherCodes.cmake
+#
+# Every WMO code from 0 to 99 gets an entry so codes can be used as an index,
+# codes missing from the input are marked unknown.
+#
+
+if(NOT INPUT OR NOT OUTPUT)
+	message(FATAL_ERROR "INPUT and OUTPUT must be set")
+endif()
+
+set(codeCount 100)
+
+file(STRINGS "${INPUT}" lines ENCODING UTF-8)
+
+set(icons "unknown")
+foreach(line IN LISTS lines)
+	if(line MATCHES "^#" OR line STREQUAL "")
+		continue()
+	endif()
+
+	if(NOT line MATCHES "^([0-9]+)\t([a-z]+)\t([0-9])\t([a-z]+)\t(.+)$")
+		message(FATAL_ERROR "Invalid line in ${INPUT}: ${line}")
+	endif()
+
+	set(code ${CMAKE_MATCH_1})
+	set(iconName ${CMAKE_MATCH_2})
+	set(severity ${CMAKE_MATCH_3})
+	set(precipitation ${CMAKE_MATCH_4})
+	string(REPLACE "\"" "\\\"" description "${CMAKE_MATCH_5}")
+
+	if(code GREATER_EQUAL codeCount)
+		message(FATAL_ERROR "Weather code ${code} is out of range")
+	endif()
+	if(DEFINED entry_${code})
+		message(FATAL_ERROR "Weather code ${code} is listed twice")
+	endif()
+
+	list(FIND icons ${iconName} icon)
+	if(icon EQUAL -1)
+		list(LENGTH icons icon)
+		list(APPEND icons ${iconName})
+	endif()
+
+	if(NOT precipitation MATCHES "^(none|drizzle|rain|freezing|snow|hail)$")
+		message(FATAL_ERROR "Unknown precipitation class ${precipitation} for weather code ${code}")
+	endif()
+	string(SUBSTRING ${precipitation} 0 1 first)
+	string(SUBSTRING ${precipitation} 1 -1 rest)
+	string(TOUPPER ${first} first)
+
+	set(entry_${code} "{${icon}, ${severity}, kPrecipitation${first}${rest}, B_TRANSLATE_MARK(\"${description}\")}")
+endforeach()
+
+set(content "// Generated from WeatherCodes.txt by GenerateWeatherCodes.cmake, do not edit.\n\n")
+string(APPEND content "static const int32 kWeatherCodeCount = ${codeCount};\n\n")
+
+string(APPEND content "static const char* const kWeatherIconNames[] = {\n")
+foreach(name IN LISTS icons)
+	string(APPEND content "\t\"${name}\",\n")
+endforeach()
+string(APPEND content "};\n\n")
+
+string(APPEND content "static WEATHER_TABLE_CONST weather_code_info kWeatherCodes[kWeatherCodeCount] = {\n")
+math(EXPR last "${codeCount} - 1")
+foreach(code RANGE ${last})
+	if(DEFINED entry_${code})
+		string(APPEND content "\t${entry_${code}}, // ${code}\n")
+	else()
+		string(APPEND content "\t{0, 0, kPrecipitationNone, NULL}, // ${code}\n")
+	endif()
+endforeach()
+string(APPEND content "};\n")
+
+# only touch the output when it changes so dependent sources aren't rebuilt
+if(EXISTS "${OUTPUT}")
+	file(READ "${OUTPUT}" previous)
+endif()
+if(NOT previous STREQUAL content)
+	file(WRITE "${OUTPUT}" "${content}")
+endif()
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "AppImage.h"
+
+#include <OS.h>
+
+
+status_t
+get_app_image(image_info& image)
+{
+	int32 cookie = 0;
+	while (get_next_image_info(B_CURRENT_TEAM, &cookie, &image) == B_OK) {
+		if ((char*)get_app_image >= (char*)image.text && (char*)get_app_image <= (char*)image.text + image.text_size)
+			return B_OK;
+	}
+
+	return B_ERROR;
+}
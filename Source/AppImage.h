@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _APPIMAGE_H_
+#define _APPIMAGE_H_
+
+
+#include <image.h>
+
+
+// the image the replicant code was loaded from, the app or the Deskbar add-on,
+// where its resources and data files are found
+status_t	get_app_image(image_info& image);
+
+#endif // _APPIMAGE_H_
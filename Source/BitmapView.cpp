@@ -6,29 +6,24 @@
 #include <Bitmap.h>
 
 
-BitmapView::BitmapView(const char* name, BBitmap* bitmap)
+BitmapView::BitmapView(const char* name)
 	:
 	BView(name, B_WILL_DRAW),
-	fBitmap(bitmap)
+	fBitmap(NULL),
+	fSize(0)
 {
 	SetViewUIColor(B_PANEL_BACKGROUND_COLOR);
 	SetDrawingMode(B_OP_ALPHA);
 }
 
 
-BitmapView::~BitmapView()
-{
-	delete fBitmap;
-}
-
-
 void
 BitmapView::Draw(BRect updateRect)
 {
 	BView::Draw(updateRect);
 
 	if (fBitmap != NULL)
-		DrawBitmap(fBitmap);
+		DrawBitmap(fBitmap, fBitmap->Bounds(), BRect(0, 0, fSize, fSize), B_FILTER_BITMAP_BILINEAR);
 }
 
 
@@ -43,8 +38,24 @@ BitmapView::GetPreferredSize(float* width, float* height)
 		return;
 	}
 
+	// the size it's drawn at, not the one the bitmap happens to have
 	if (width != NULL)
-		*width = fBitmap->Bounds().Width();
+		*width = fSize;
 	if (height != NULL)
-		*height = fBitmap->Bounds().Height();
+		*height = fSize;
+}
+
+
+void
+BitmapView::SetBitmap(const BBitmap* bitmap, int32 size)
+{
+	if (bitmap == fBitmap && size == fSize)
+		return;
+
+	if (size != fSize || (bitmap == NULL) != (fBitmap == NULL))
+		InvalidateLayout();
+
+	fBitmap = bitmap;
+	fSize = size;
+	Invalidate();
 }
@@ -12,14 +12,19 @@ class BBitmap;
 
 class BitmapView : public BView {
 public:
-					BitmapView(const char* name, BBitmap* bitmap);
-					~BitmapView();
+					BitmapView(const char* name);
 
 	virtual void	Draw(BRect updateRect);
 	virtual void	GetPreferredSize(float* width, float* height);
 
+			const BBitmap*	Bitmap() const { return fBitmap; }
+			// the bitmap belongs to the caller, and is scaled when it wasn't
+			// rasterized for size pixels
+			void	SetBitmap(const BBitmap* bitmap, int32 size);
+
 private:
-	BBitmap*		fBitmap;
+	const BBitmap*	fBitmap;
+	int32			fSize;
 };
 
 #endif // _BITMAPVIEW_H_
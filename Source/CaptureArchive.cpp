@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "CaptureArchive.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char kCaptureMagic[4] = {'D', 'W', 'C', 'A'};
+static const size_t kFileHeaderSize = 8;
+static const size_t kRecordHeaderSize = 32;
+
+
+static size_t
+string_size(const char* string)
+{
+	return string != NULL ? strlen(string) + 1 : 1;
+}
+
+
+CaptureArchive::CaptureArchive()
+	:
+	fData(NULL),
+	fExchanges(NULL),
+	fCount(0)
+{}
+
+
+CaptureArchive::~CaptureArchive()
+{
+	Unset();
+}
+
+
+status_t
+CaptureArchive::Load(const char* path)
+{
+	Unset();
+
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	long size = -1;
+	if (fseek(file, 0, SEEK_END) == 0)
+		size = ftell(file);
+
+	if (size < static_cast<long>(kFileHeaderSize) || fseek(file, 0, SEEK_SET) != 0) {
+		fclose(file);
+		return B_BAD_DATA;
+	}
+
+	fData = static_cast<char*>(malloc(size));
+	if (fData == NULL) {
+		fclose(file);
+		return B_NO_MEMORY;
+	}
+
+	size_t length = fread(fData, 1, size, file);
+	fclose(file);
+
+	uint32 version = 0;
+	memcpy(&version, fData + 4, sizeof(version));
+	if (length != static_cast<size_t>(size) || memcmp(fData, kCaptureMagic, sizeof(kCaptureMagic)) != 0
+		|| version != kCaptureArchiveVersion) {
+		Unset();
+		return B_BAD_DATA;
+	}
+
+	// count the records first, a damaged tail is left out
+	size_t position = kFileHeaderSize;
+	int32 count = 0;
+	while (length - position >= kRecordHeaderSize) {
+		uint32 recordSize;
+		memcpy(&recordSize, fData + position, sizeof(recordSize));
+		if (recordSize < kRecordHeaderSize || recordSize > length - position)
+			break;
+
+		position += recordSize;
+		count++;
+	}
+
+	if (count > 0) {
+		fExchanges = static_cast<transport_exchange*>(malloc(count * sizeof(transport_exchange)));
+		if (fExchanges == NULL) {
+			Unset();
+			return B_NO_MEMORY;
+		}
+	}
+
+	position = kFileHeaderSize;
+	for (int32 x = 0; x < count; x++) {
+		const char* record = fData + position;
+		uint32 recordSize, bodySize;
+		uint16 urlLength, statusTextLength;
+		transport_exchange& exchange = fExchanges[fCount];
+
+		memcpy(&recordSize, record, 4);
+		memcpy(&urlLength, record + 4, 2);
+		memcpy(&statusTextLength, record + 6, 2);
+		memcpy(&exchange.status, record + 8, 4);
+		memcpy(&bodySize, record + 12, 4);
+		memcpy(&exchange.time, record + 16, 8);
+		memcpy(&exchange.duration, record + 24, 8);
+		exchange.resolveTime = exchange.connectTime = exchange.waitTime = exchange.transferTime = -1;
+		position += recordSize;
+
+		const char* strings = record + kRecordHeaderSize;
+		if (urlLength == 0 || statusTextLength == 0
+			|| static_cast<size_t>(urlLength) + statusTextLength + bodySize != recordSize - kRecordHeaderSize
+			|| strings[urlLength - 1] != '\0' || strings[urlLength + statusTextLength - 1] != '\0')
+			continue;
+
+		exchange.url = strings;
+		exchange.statusText = strings + urlLength;
+		exchange.body = strings + urlLength + statusTextLength;
+		exchange.bodySize = bodySize;
+		fCount++;
+	}
+
+	return B_OK;
+}
+
+
+void
+CaptureArchive::Unset()
+{
+	free(fExchanges);
+	free(fData);
+	fExchanges = NULL;
+	fData = NULL;
+	fCount = 0;
+}
+
+
+//	#pragma mark - CaptureRecorder
+
+
+CaptureRecorder::CaptureRecorder(size_t bufferSize)
+	:
+	fFile(NULL),
+	fBuffer(NULL),
+	fBufferSize(bufferSize),
+	fReadPosition(0),
+	fUsed(0),
+	fRecorded(0),
+	fDropped(0),
+	fError(B_OK),
+	fRunning(false),
+	fQuit(false)
+{
+	pthread_mutex_init(&fLock, NULL);
+	pthread_cond_init(&fCondition, NULL);
+}
+
+
+CaptureRecorder::~CaptureRecorder()
+{
+	Close();
+	free(fBuffer);
+	pthread_cond_destroy(&fCondition);
+	pthread_mutex_destroy(&fLock);
+}
+
+
+status_t
+CaptureRecorder::Open(const char* path)
+{
+	Close();
+
+	if (fBuffer == NULL) {
+		fBuffer = static_cast<char*>(malloc(fBufferSize));
+		if (fBuffer == NULL)
+			return B_NO_MEMORY;
+	}
+
+	fFile = fopen(path, "wb");
+	if (fFile == NULL)
+		return B_IO_ERROR;
+
+	uint32 version = kCaptureArchiveVersion;
+	if (fwrite(kCaptureMagic, sizeof(kCaptureMagic), 1, fFile) != 1
+		|| fwrite(&version, sizeof(version), 1, fFile) != 1) {
+		fclose(fFile);
+		fFile = NULL;
+		return B_IO_ERROR;
+	}
+
+	fReadPosition = 0;
+	fUsed = 0;
+	fRecorded = 0;
+	fDropped = 0;
+	fError = B_OK;
+	fQuit = false;
+
+	if (pthread_create(&fThread, NULL, &_WriterThread, this) != 0) {
+		fclose(fFile);
+		fFile = NULL;
+		return B_ERROR;
+	}
+
+	fRunning = true;
+	return B_OK;
+}
+
+
+status_t
+CaptureRecorder::Close()
+{
+	if (!fRunning)
+		return B_OK;
+
+	pthread_mutex_lock(&fLock);
+	fQuit = true;
+	pthread_cond_signal(&fCondition);
+	pthread_mutex_unlock(&fLock);
+
+	pthread_join(fThread, NULL);
+	fRunning = false;
+
+	if (fclose(fFile) != 0 && fError == B_OK)
+		fError = B_IO_ERROR;
+	fFile = NULL;
+
+	return fError;
+}
+
+
+status_t
+CaptureRecorder::Record(const transport_exchange& exchange)
+{
+	uint32 urlLength = string_size(exchange.url);
+	uint32 statusTextLength = string_size(exchange.statusText);
+	size_t size = kRecordHeaderSize + urlLength + statusTextLength + exchange.bodySize;
+	if (urlLength > 0xffff || statusTextLength > 0xffff || size > 0xffffffff)
+		return B_BAD_VALUE;
+
+	char header[kRecordHeaderSize];
+	uint32 recordSize = size;
+	uint16 length16 = urlLength;
+	uint32 bodySize = exchange.bodySize;
+	memcpy(header, &recordSize, 4);
+	memcpy(header + 4, &length16, 2);
+	length16 = statusTextLength;
+	memcpy(header + 6, &length16, 2);
+	memcpy(header + 8, &exchange.status, 4);
+	memcpy(header + 12, &bodySize, 4);
+	memcpy(header + 16, &exchange.time, 8);
+	memcpy(header + 24, &exchange.duration, 8);
+
+	pthread_mutex_lock(&fLock);
+	if (!fRunning || fQuit || fBufferSize - fUsed < size) {
+		fDropped++;
+		pthread_mutex_unlock(&fLock);
+		return fRunning ? B_WOULD_BLOCK : B_NO_INIT;
+	}
+
+	size_t position = (fReadPosition + fUsed) % fBufferSize;
+	_Put(position, header, kRecordHeaderSize);
+	_Put(position, exchange.url != NULL ? exchange.url : "", urlLength);
+	_Put(position, exchange.statusText != NULL ? exchange.statusText : "", statusTextLength);
+	_Put(position, exchange.body, exchange.bodySize);
+	fUsed += size;
+	fRecorded++;
+
+	pthread_cond_signal(&fCondition);
+	pthread_mutex_unlock(&fLock);
+
+	return B_OK;
+}
+
+
+uint32
+CaptureRecorder::CountRecorded()
+{
+	pthread_mutex_lock(&fLock);
+	uint32 count = fRecorded;
+	pthread_mutex_unlock(&fLock);
+	return count;
+}
+
+
+uint32
+CaptureRecorder::CountDropped()
+{
+	pthread_mutex_lock(&fLock);
+	uint32 count = fDropped;
+	pthread_mutex_unlock(&fLock);
+	return count;
+}
+
+
+void*
+CaptureRecorder::_WriterThread(void* data)
+{
+	static_cast<CaptureRecorder*>(data)->_Write();
+	return NULL;
+}
+
+
+void
+CaptureRecorder::_Write()
+{
+	pthread_mutex_lock(&fLock);
+	while (true) {
+		while (fUsed == 0 && !fQuit)
+			pthread_cond_wait(&fCondition, &fLock);
+
+		if (fUsed == 0)
+			break;
+
+		// Record() only appends behind the used part, so it can be written unlocked
+		size_t position = fReadPosition;
+		size_t used = fUsed;
+		pthread_mutex_unlock(&fLock);
+
+		size_t first = fBufferSize - position < used ? fBufferSize - position : used;
+		bool failed = fwrite(fBuffer + position, 1, first, fFile) != first;
+		if (!failed && used > first)
+			failed = fwrite(fBuffer, 1, used - first, fFile) != used - first;
+		// keep the archive usable while the capture is still running
+		if (!failed)
+			failed = fflush(fFile) != 0;
+
+		pthread_mutex_lock(&fLock);
+		if (failed)
+			fError = B_IO_ERROR;
+		fReadPosition = (position + used) % fBufferSize;
+		fUsed -= used;
+	}
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+CaptureRecorder::_Put(size_t& position, const void* data, size_t size)
+{
+	if (size == 0)
+		return;
+
+	const char* bytes = static_cast<const char*>(data);
+	size_t first = fBufferSize - position < size ? fBufferSize - position : size;
+	memcpy(fBuffer + position, bytes, first);
+	memcpy(fBuffer, bytes + first, size - first);
+	position = (position + size) % fBufferSize;
+}
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _CAPTUREARCHIVE_H_
+#define _CAPTUREARCHIVE_H_
+
+
+#include "Transport.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+
+// A capture archive is an 8 byte header ("DWCA" and a version) followed by one
+// record for each exchange in host byte order:
+//
+//	uint32	size of the whole record
+//	uint16	url length, uint16 status text length, both with the terminating NUL
+//	int32	status code
+//	uint32	body size
+//	int64	start time, int64 duration
+//	url, status text and body
+//
+// The threads are pthreads so the archive can be used by the benchmarks on
+// other hosts as well.
+
+static const uint32 kCaptureArchiveVersion = 1;
+static const size_t kCaptureBufferSize = 1024 * 1024;
+
+
+// the exchanges of a whole archive, read into memory at once
+class CaptureArchive {
+public:
+								CaptureArchive();
+								~CaptureArchive();
+
+			status_t			Load(const char* path);
+			void				Unset();
+
+			int32				CountExchanges() const { return fCount; }
+			const transport_exchange& ExchangeAt(int32 index) const { return fExchanges[index]; }
+
+private:
+			char*				fData;
+			transport_exchange*	fExchanges;
+			int32				fCount;
+};
+
+
+// Appends exchanges to an archive without waiting for the disk.  Record()
+// copies the exchange into a ring buffer and a writer thread empties it, when
+// the buffer is full the exchange is dropped instead.
+class CaptureRecorder {
+public:
+								CaptureRecorder(size_t bufferSize = kCaptureBufferSize);
+								~CaptureRecorder();
+
+			status_t			Open(const char* path);
+			// waits until everything recorded so far is written
+			status_t			Close();
+
+			status_t			Record(const transport_exchange& exchange);
+			uint32				CountRecorded();
+			uint32				CountDropped();
+
+private:
+	static	void*				_WriterThread(void* data);
+			void				_Write();
+			void				_Put(size_t& position, const void* data, size_t size);
+
+			FILE*				fFile;
+			char*				fBuffer;
+			size_t				fBufferSize;
+			size_t				fReadPosition;
+			size_t				fUsed;
+			uint32				fRecorded;
+			uint32				fDropped;
+			status_t			fError;
+			bool				fRunning;
+			bool				fQuit;
+			pthread_t			fThread;
+			pthread_mutex_t		fLock;
+			pthread_cond_t		fCondition;
+};
+
+#endif // _CAPTUREARCHIVE_H_
@@ -2,46 +2,90 @@
 // SPDX-FileCopyrightText: 2021 Chris Roberts
 
 #include "Condition.h"
+#include "ForecastModel.h"
+#include "ForecastParser.h"
 
-#include <NumberFormat.h>
-#include <String.h>
 #include <math.h>
 
 
+static float
+value_or_missing(float value)
+{
+	return isnan(value) ? kMissingCondition : value;
+}
+
+
 Condition::Condition()
 	:
-	fForecast(new BString()),
-	fHumidity(new BString()),
-	fIcon(new BString("unknown")),
 	fDay(-999),
-	fTemp(-999),
-	fLowTemp(-999),
-	fHighTemp(-999),
-	fWind(-999),
-	fWindDirection(-999),
-	fCloudCover(-999)
+	fTemp(kMissingCondition),
+	fFeelsLike(kMissingCondition),
+	fLowTemp(kMissingCondition),
+	fHighTemp(kMissingCondition),
+	fHumidity(kMissingCondition),
+	fWind(kMissingCondition),
+	fWindDirection(kMissingCondition),
+	fCloudCover(kMissingCondition),
+	fWeatherCode(kWeatherUnknown)
 {}
 
 
-Condition::~Condition()
+Condition::Condition(const ForecastModel& model, int32 day)
+	:
+	fDay(model.DayTimes()[day]),
+	fTemp(kMissingCondition),
+	fFeelsLike(kMissingCondition),
+	fLowTemp(value_or_missing(model.DayLows()[day])),
+	fHighTemp(value_or_missing(model.DayHighs()[day])),
+	fHumidity(kMissingCondition),
+	fWind(kMissingCondition),
+	fWindDirection(kMissingCondition),
+	fCloudCover(kMissingCondition),
+	fWeatherCode(to_weather_code(model.DayCodes()[day]))
+{}
+
+
+void
+Condition::SetTo(const current_weather& current)
 {
-	delete fForecast;
-	delete fHumidity;
-	delete fIcon;
+	fDay = current.time;
+	fTemp = value_or_missing(current.temperature);
+	fFeelsLike = value_or_missing(current.apparentTemperature);
+	fLowTemp = value_or_missing(current.lowTemperature);
+	fHighTemp = value_or_missing(current.highTemperature);
+	fHumidity = isnan(current.humidity) ? kMissingCondition : current.humidity / 100;
+	fWind = value_or_missing(current.windSpeed);
+	fWindDirection = value_or_missing(current.windDirection);
+	fCloudCover = value_or_missing(current.cloudCover);
+	fWeatherCode = to_weather_code(current.weatherCode);
 }
 
 
 void
-Condition::SetForecast(const char* forecast)
+Condition::SetWeatherCode(int32 code)
 {
-	fForecast->SetTo(forecast);
+	fWeatherCode = to_weather_code(code);
 }
 
 
-BString*
+weather_code
+Condition::WeatherCode()
+{
+	return static_cast<weather_code>(fWeatherCode);
+}
+
+
+const char*
 Condition::Forecast()
 {
-	return fForecast;
+	return weather_code_description(WeatherCode());
+}
+
+
+const char*
+Condition::Icon()
+{
+	return weather_code_icon(WeatherCode());
 }
 
 
@@ -111,21 +155,14 @@ Condition::iHigh()
 }
 
 
-void
-Condition::SetHumidity(const char* humidity)
-{
-	fHumidity->SetTo(humidity);
-}
-
-
 void
 Condition::SetHumidity(double humidity)
 {
-	BNumberFormat().FormatPercent(*fHumidity, humidity);
+	fHumidity = humidity;
 }
 
 
-BString*
+double
 Condition::Humidity()
 {
 	return fHumidity;
@@ -174,19 +211,6 @@ Condition::CloudCover()
 }
 
 
-void
-Condition::SetIcon(const char* icon)
-{
-	fIcon->SetTo(icon);
-}
-
-
-BString*
-Condition::Icon()
-{
-	return fIcon;
-}
-
 
 void
 Condition::SetDay(time_t t)
@@ -7,18 +7,32 @@
 
 #include <SupportDefs.h>
 
+#include "WeatherCode.h"
 
-class BString;
 
+class ForecastModel;
+struct current_weather;
 
+
+// a value missing from the reply, shown as nothing or a dash
+static const float kMissingCondition = -999;
+
+
+// The current conditions, or a copy of one day of a ForecastModel.  Only
+// plain numbers are stored and text is looked up or formatted when it is
+// displayed, so a condition never allocates.
 class Condition {
 
 public:
 						Condition();
-						~Condition();
+						Condition(const ForecastModel& model, int32 day);
 
-			void		SetForecast(const char* forecast);
-			BString*	Forecast();
+			void		SetTo(const current_weather& current);
+
+			void		SetWeatherCode(int32 code);
+			weather_code	WeatherCode();
+			const char*	Forecast();
+			const char*	Icon();
 
 			void		SetTemp(double temp, bool feelsLike = false);
 			double		Temp(bool feelsLike = false);
@@ -32,9 +46,8 @@ public:
 			double		High();
 			int32		iHigh();
 
-			void		SetHumidity(const char* humidity);
 			void		SetHumidity(double humidity);
-			BString*	Humidity();
+			double		Humidity();
 
 			void		SetWind(double wind);
 			double		Wind();
@@ -45,24 +58,22 @@ public:
 			void		SetCloudCover(double cloud);
 			double		CloudCover();
 
-			void		SetIcon(const char* icon);
-			BString*	Icon();
-
 			void		SetDay(time_t t);
 			time_t		Day();
 
+	static	bool		IsMissing(double value) { return value == kMissingCondition; }
+
 private:
-			BString*	fForecast;
-			BString*	fHumidity;
-			BString*	fIcon;
 			time_t		fDay;
-			double		fTemp;
-			double		fFeelsLike;
-			double		fLowTemp;
-			double		fHighTemp;
-			double		fWind;
-			double		fWindDirection;
-			double		fCloudCover;
+			float		fTemp;
+			float		fFeelsLike;
+			float		fLowTemp;
+			float		fHighTemp;
+			float		fHumidity;
+			float		fWind;
+			float		fWindDirection;
+			float		fCloudCover;
+			int16		fWeatherCode;
 };
 
 #endif // _CONDITION_H_
@@ -6,9 +6,11 @@
 #include <Alert.h>
 #include <Application.h>
 #include <Deskbar.h>
+#include <Path.h>
 #include <Roster.h>
 #include <String.h>
 #include <iostream>
+#include <stdlib.h>
 
 
 class DeskbarWeatherApp : public BApplication {
@@ -25,11 +27,27 @@ private:
 		std::cout << "\t--forecast\t\tShow forecast window" << std::endl;
 		std::cout << "\t--refresh\t\tRefresh weather" << std::endl;
 		std::cout << "\t--geolookup\t\tRefresh geolocation" << std::endl;
+		std::cout << "\t--capture <archive>\tRecord the replies of the network into a capture archive" << std::endl;
+		std::cout << "\t--replay <archive> [latency ms] [bandwidth KiB/s]" << std::endl;
+		std::cout << "\t\t\t\tReplay a capture archive instead of using the network" << std::endl;
+		std::cout << "\t--live\t\t\tUse the network again" << std::endl;
+		std::cout << "\t--stats\t\t\tShow the timings of the requests" << std::endl;
+		std::cout << "\t--budget <ms>\t\tWarn about messages that block the Deskbar for longer" << std::endl;
+		std::cout << "\t--trace start|stop\tStart or stop tracing the refreshes" << std::endl;
+		std::cout << "\t--trace dump <file>\tWrite the trace for chrome://tracing or Perfetto" << std::endl;
 	}
 
 
 	status_t
 	_SendReplicantMessage(uint32 what)
+	{
+		BMessage message(what);
+		return _SendReplicantMessage(message);
+	}
+
+
+	status_t
+	_SendReplicantMessage(BMessage& message, BMessage* replicantReply = NULL)
 	{
 		BMessage query(B_GET_PROPERTY);
 		query.AddSpecifier("Messenger");
@@ -53,10 +71,12 @@ private:
 			return B_ERROR;
 		}
 
-		BMessage message(what);
-		if (replicantMessenger.SendMessage(what, &reply) != B_OK) {
+		if (replicantReply == NULL)
+			replicantReply = &reply;
+
+		if (replicantMessenger.SendMessage(&message, replicantReply) != B_OK) {
 			std::cout << "Error: couldn't send command to replicant messenger" << std::endl;
-			reply.PrintToStream();
+			replicantReply->PrintToStream();
 			return B_ERROR;
 		}
 
@@ -64,11 +84,76 @@ private:
 	}
 
 
+	// the replicant runs in the Deskbar, which has another working directory
+	BString
+	_AbsolutePath(const char* path)
+	{
+		BPath absolute;
+		if (absolute.SetTo(path, NULL, true) != B_OK)
+			return BString(path);
+
+		return BString(absolute.Path());
+	}
+
+
 public:
 	virtual void
 	ArgvReceived(int argc, char** argv)
 	{
-		if (argc > 2) {
+		if (argc > 2 && strcmp(argv[1], "--capture") == 0) {
+			if (argc > 3) {
+				std::cout << "Error: too many arguments" << std::endl;
+				_DisplayUsage(argv[0]);
+			} else {
+				BMessage message(kTransportMessage);
+				message.AddString("capture", _AbsolutePath(argv[2]));
+				_SendReplicantMessage(message);
+			}
+		} else if (argc > 2 && strcmp(argv[1], "--replay") == 0) {
+			if (argc > 5) {
+				std::cout << "Error: too many arguments" << std::endl;
+				_DisplayUsage(argv[0]);
+			} else {
+				// without a latency the recorded durations are replayed
+				BMessage message(kTransportMessage);
+				message.AddString("replay", _AbsolutePath(argv[2]));
+				if (argc > 3)
+					message.AddInt32("latency", atoi(argv[3]));
+				if (argc > 4)
+					message.AddInt32("bandwidth", atoi(argv[4]));
+				_SendReplicantMessage(message);
+			}
+		} else if (argc > 2 && strcmp(argv[1], "--budget") == 0) {
+			if (argc > 3 || atoi(argv[2]) <= 0) {
+				std::cout << "Error: argument not understood" << std::endl;
+				_DisplayUsage(argv[0]);
+			} else {
+				BMessage message(kBudgetMessage);
+				message.AddInt32("budget", atoi(argv[2]));
+				_SendReplicantMessage(message);
+			}
+		} else if (argc > 2 && strcmp(argv[1], "--trace") == 0) {
+			BMessage message(kTraceMessage);
+			if (argc == 3 && strcmp(argv[2], "start") == 0)
+				message.AddBool("enable", true);
+			else if (argc == 3 && strcmp(argv[2], "stop") == 0)
+				message.AddBool("enable", false);
+			else if (argc == 4 && strcmp(argv[2], "dump") == 0)
+				message.AddString("dump", _AbsolutePath(argv[3]));
+			else {
+				std::cout << "Error: argument not understood" << std::endl;
+				_DisplayUsage(argv[0]);
+				Quit();
+				return;
+			}
+
+			BMessage reply;
+			if (_SendReplicantMessage(message, &reply) == B_OK) {
+				status_t status = reply.GetInt32("status", B_OK);
+				if (status != B_OK)
+					std::cout << "Error: " << strerror(status) << std::endl;
+			}
+		} else if (argc > 2) {
 			std::cout << "Error: too many arguments" << std::endl;
 			_DisplayUsage(argv[0]);
 		} else if (argc == 2) {
@@ -78,6 +163,13 @@ public:
 				_SendReplicantMessage('FrGw');
 			} else if (strcmp(argv[1], "--geolookup") == 0) {
 				_SendReplicantMessage('GfGw');
+			} else if (strcmp(argv[1], "--live") == 0) {
+				_SendReplicantMessage(kTransportMessage);
+			} else if (strcmp(argv[1], "--stats") == 0) {
+				BMessage message(kStatsMessage);
+				BMessage reply;
+				if (_SendReplicantMessage(message, &reply) == B_OK)
+					std::cout << reply.GetString("stats", "Error: no stats in the replicant reply") << std::endl;
 			} else {
 				std::cout << "Error: argument not understood" << std::endl;
 				_DisplayUsage(argv[0]);
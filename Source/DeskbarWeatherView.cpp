@@ -2,27 +2,47 @@
 // SPDX-FileCopyrightText: 2021 Chris Roberts
 
 #include "DeskbarWeatherView.h"
+#include "AppImage.h"
 #include "Condition.h"
+#include "ForecastStripView.h"
 #include "ForecastWindow.h"
+#include "Formatters.h"
+#include "HttpTransport.h"
+#include "IconCache.h"
 #include "IpApiLocationProvider.h"
+#include "LooperWatchdog.h"
+#include "NetworkMonitor.h"
+#include "ObservationHistory.h"
 #include "OpenMeteo.h"
+#include "PlaceIndex.h"
+#include "ReplayTransport.h"
+#include "RequestStats.h"
 #include "SettingsWindow.h"
+#include "TextWidthCache.h"
+#include "TimeZoneLocation.h"
+#include "Trace.h"
+#include "WeatherCode.h"
 #include "WeatherSettings.h"
 
 #include <Alert.h>
 #include <Application.h>
 #include <Bitmap.h>
 #include <Deskbar.h>
-#include <IconUtils.h>
+#include <FindDirectory.h>
 #include <Invoker.h>
 #include <LayoutBuilder.h>
 #include <MenuItem.h>
 #include <MessageRunner.h>
 #include <Notification.h>
+#include <Path.h>
 #include <PopUpMenu.h>
-#include <Resources.h>
 #include <Roster.h>
 
+#include <OS.h>
+
+#include <math.h>
+#include <time.h>
+
 // use full paths to make clang autocompletion happy
 #include <private/interface/AboutWindow.h>
 #include <private/netservices/HttpRequest.h>
@@ -34,6 +54,50 @@ using namespace BPrivate::Network;
 
 const char* kGithubURL = "https://github.com/augiedoggie/DeskbarWeather/";
 
+// wait for the network configuration to settle before checking it
+const bigtime_t kNetworkSettleDelay = 5000000;
+
+// shown until the first refresh
+const char* kUnknownIcon = "unknown";
+const char* kGeoLookupIcon = "geolookup";
+const float kNotificationIconSize = 32;
+
+// how long each location stays in the Deskbar
+const bigtime_t kTickerInterval = 5000000;
+// nobody is looking after this long without input, or the screen is locked
+const bigtime_t kTickerIdleTime = 120000000;
+// how often to check if somebody is back
+const bigtime_t kTickerIdleInterval = 30000000;
+
+// the current conditions of every location are kept in its history
+const uint32 kHistoryFields = kForecastCurrentFields | kForecastTime;
+const int32 kMaxHistories = kMaxSavedLocations + 1;
+const char* kHistoryDirectory = "DeskbarWeather History";
+
+
+// the city is enough to tell the locations apart in the Deskbar
+static void
+short_location_name(BString& output, const char* location)
+{
+	output = location;
+	int32 comma = output.FindFirst(',');
+	if (comma > 0)
+		output.Truncate(comma);
+	output.TruncateChars(12);
+}
+
+
+// when a message was posted, input events carry it already
+static bigtime_t
+message_sent_time(BMessage* message)
+{
+	bigtime_t sent;
+	if (message->FindInt64(kMessageSentKey, &sent) == B_OK || message->FindInt64("when", &sent) == B_OK)
+		return sent;
+
+	return -1;
+}
+
 
 extern "C" _EXPORT BView*
 instantiate_deskbar_item(float /* maxWidth */, float maxHeight)
@@ -53,12 +117,15 @@ instantiate_deskbar_item(float /* maxWidth */, float maxHeight)
 		return NULL;
 	}
 
-	// calculate our maximum possible width
-	float width = maxHeight;
-	if (settings->ImperialUnits())
-		width += font.StringWidth("-99°");
-	else
-		width += font.StringWidth("-99.9°");
+	// start as wide as the widest text of the display mode, the view fits itself to the text later
+	Condition sample;
+	sample.SetTemp(-88.8);
+	sample.SetTemp(-88.8, true);
+	sample.SetHigh(-88);
+	sample.SetLow(-88);
+	BString text;
+	format_replicant(text, settings->DisplayMode(), sample, settings->ImperialUnits(), settings->ShowFeelsLike(), 100);
+	float width = ceilf(maxHeight + font.StringWidth(text));
 
 	return new DeskbarWeatherView(BRect(0, 0, width, maxHeight - 1), settings); // 129 x 16 max?
 }
@@ -68,11 +135,28 @@ DeskbarWeatherView::DeskbarWeatherView(BRect frame, WeatherSettings* settings)
 	:
 	BView(frame, kViewName, B_FOLLOW_NONE, B_WILL_DRAW),
 	fIcon(NULL),
+	fCache(NULL),
+	fCacheValid(false),
+	fTicker(NULL),
+	fTickerCount(0),
+	fTickerIndex(0),
+	fTickerSerial(0),
+	fTickerRunner(NULL),
+	fTickerIdle(false),
+	fHistory(NULL),
+	fWidths(NULL),
+	fForecastPrebuilt(false),
+	fOpenStats(NULL),
 	fLocationProvider(NULL),
 	fLock("weather data lock"),
 	fMessageRunner(NULL),
+	fNetworkRunner(NULL),
+	fWatchdog(NULL),
 	fSettings(settings),
-	fWeather(NULL)
+	fTransport(NULL),
+	fWeather(NULL),
+	fWeatherStats(NULL),
+	fLocationStats(NULL)
 {
 	_Init();
 }
@@ -82,11 +166,28 @@ DeskbarWeatherView::DeskbarWeatherView(BMessage* message)
 	:
 	BView(message),
 	fIcon(NULL),
+	fCache(NULL),
+	fCacheValid(false),
+	fTicker(NULL),
+	fTickerCount(0),
+	fTickerIndex(0),
+	fTickerSerial(0),
+	fTickerRunner(NULL),
+	fTickerIdle(false),
+	fHistory(NULL),
+	fWidths(NULL),
+	fForecastPrebuilt(false),
+	fOpenStats(NULL),
 	fLocationProvider(NULL),
 	fLock("weather data lock"),
 	fMessageRunner(NULL),
+	fNetworkRunner(NULL),
+	fWatchdog(NULL),
 	fSettings(NULL),
-	fWeather(NULL)
+	fTransport(NULL),
+	fWeather(NULL),
+	fWeatherStats(NULL),
+	fLocationStats(NULL)
 {
 	_Init();
 }
@@ -106,10 +207,26 @@ DeskbarWeatherView::~DeskbarWeatherView()
 			window->Quit();
 	}
 
-	delete fIcon;
+	delete fTickerRunner;
+	for (int32 x = 0; x < fTickerCount; x++) {
+		delete fTicker[x].weather;
+		delete fTicker[x].frame;
+	}
+	delete[] fTicker;
+
+	delete fHistory;
+
+	delete fCache;
+	delete fWidths;
 	delete fMessageRunner;
+	delete fNetworkRunner;
+	delete fWatchdog;
 	delete fWeather;
 	delete fLocationProvider;
+	delete fTransport;
+	delete fWeatherStats;
+	delete fLocationStats;
+	delete fOpenStats;
 	delete fSettings;
 }
 
@@ -144,18 +261,61 @@ DeskbarWeatherView::AttachedToWindow()
 		SetViewUIColor(B_PANEL_BACKGROUND_COLOR);
 
 	SetLowColor(ViewColor());
+	fCacheValid = false;
+
+	IconCache::Default()->AddWatcher(BMessenger(this));
 
 	AutoLocker<WeatherSettings> slocker(fSettings);
+
+	fWatchdog->SetBudget(fSettings->HandlerBudget() * 1000LL);
+
+	// first run, start from the time zone instead of the default location until we know better
+	bool coarseLocation = false;
+	if (!fSettings->HasCoordinates()) {
+		BString location;
+		double latitude, longitude;
+		if (get_default_time_zone_location(location, latitude, longitude) == B_OK) {
+			fSettings->SetLocation(latitude, longitude);
+			fSettings->SetLocation(location);
+			coarseLocation = true;
+		}
+	}
+
+	fTransport = new HttpTransport();
 	fWeather = new OpenMeteo(fSettings->Latitude(), fSettings->Longitude(), fSettings->ImperialUnits(),
-		fSettings->ForecastDays(), new BInvoker(new BMessage(kRefreshMessage), this));
+		fSettings->ForecastDays(), _HourlyForecast(), new BInvoker(new BMessage(kRefreshMessage), this),
+		fTransport, fWeatherStats);
+	_UpdateFields();
+	_UpdateDisplay();
+	_UpdateTicker();
 
 	_CheckMessageRunner();
 
 	if (fSettings->UseGeoLocation()) {
-		fLocationProvider = new IpApiLocationProvider(new BInvoker(new BMessage(kGeoLocationMessage), this));
-		fLocationProvider->Run(); // will force a weather refresh when the reply message arrives
-	} else
+		_StartGeoLocation(); // will force a weather refresh when the reply message arrives
+
+		// don't wait for the lookup to show something for the time zone location
+		if (coarseLocation)
+			BMessenger(this).SendMessage(kForceRefreshMessage);
+	} else {
+		// name manually entered coordinates from the bundled place index
+		BString location;
+		if (!fSettings->HasLocation()
+			&& PlaceIndex::Default()->GetPlaceName(fSettings->Latitude(), fSettings->Longitude(), location) == B_OK)
+			fSettings->SetLocation(location);
+
 		BMessenger(this).SendMessage(kForceRefreshMessage);
+	}
+}
+
+
+void
+DeskbarWeatherView::DetachedFromWindow()
+{
+	_StopGeoLocation();
+	IconCache::Default()->RemoveWatcher(BMessenger(this));
+
+	BView::DetachedFromWindow();
 }
 
 
@@ -166,6 +326,8 @@ DeskbarWeatherView::MouseDown(BPoint point)
 	if (message == NULL || message->what != B_MOUSE_DOWN)
 		return;
 
+	WatchdogScope watch(fWatchdog, "MouseDown", message->what, message_sent_time(message));
+
 	int32 buttons;
 
 	if (message->FindInt32("buttons", &buttons) != B_OK)
@@ -183,6 +345,8 @@ DeskbarWeatherView::MouseDown(BPoint point)
 void
 DeskbarWeatherView::MessageReceived(BMessage* message)
 {
+	WatchdogScope watch(fWatchdog, "MessageReceived", message->what, message_sent_time(message));
+
 	switch (message->what) {
 		case kForecastWindowMessage:
 			_ShowForecastWindow();
@@ -196,19 +360,40 @@ DeskbarWeatherView::MessageReceived(BMessage* message)
 			AutoLocker<WeatherSettings> slocker(fSettings);
 			if (!message->HasBool("skiprefresh")) {
 				// something changed and we need a new location/weather request
-				//TODO check for geolocation status change
-				fWeather->RebuildRequestUrl(fSettings->Latitude(), fSettings->Longitude(), fSettings->ImperialUnits(), fSettings->ForecastDays());
+				if (fSettings->UseGeoLocation() && fLocationProvider == NULL)
+					_StartGeoLocation();
+				else if (!fSettings->UseGeoLocation() && fLocationProvider != NULL)
+					_StopGeoLocation();
+
+				fWeather->RebuildRequestUrl(fSettings->Latitude(), fSettings->Longitude(), fSettings->ImperialUnits(),
+					fSettings->ForecastDays(), _HourlyForecast());
 				_CheckMessageRunner();
+
+				// a location picked in the settings shouldn't wait for the next refresh
+				if (message->HasBool("forcerefresh"))
+					_ForceRefresh();
 			}
 
+			if (fLocationProvider != NULL)
+				fLocationProvider->SetCacheLifetime(fSettings->GeoCacheLifetime());
+
+			_UpdateFields();
+
 			// check if our current BView font is different
 			BFont newFont, oldFont;
 			fSettings->GetFont(newFont);
 			GetFont(&oldFont);
 			if (oldFont != newFont) {
 				SetFont(&newFont);
+				fCacheValid = false;
+				_ComposeTickerFrames();
 			}
-			Invalidate();
+
+			_UpdateTicker();
+			_PrewarmIcons();
+
+			// only invalidates when the text, the icon or the font changed
+			_UpdateDisplay();
 			break;
 		}
 		case kForceRefreshMessage:
@@ -217,6 +402,27 @@ DeskbarWeatherView::MessageReceived(BMessage* message)
 		case kRefreshMessage:
 			_RefreshComplete(message);
 			break;
+		case kTickerRefreshMessage:
+			_TickerRefreshComplete(message);
+			break;
+		case kTickerMessage:
+			_Tick();
+			break;
+		case kIconsChangedMessage:
+		{
+			// the resolution for the current scale is ready
+			AutoLocker<BLocker> locker(fLock);
+			AutoLocker<WeatherSettings> slocker(fSettings);
+			for (int32 x = 0; x < fTickerCount; x++) {
+				if (fTicker[x].iconName != NULL)
+					fTicker[x].icon = IconCache::Default()->Get(fTicker[x].iconName, _IconSize());
+			}
+			_ComposeTickerFrames();
+			_UpdateDisplay();
+			if (fTickerIndex > 0)
+				Invalidate();
+			break;
+		}
 		case kForceGeoLocationMessage:
 		{
 			if (fLocationProvider != NULL)
@@ -226,6 +432,55 @@ DeskbarWeatherView::MessageReceived(BMessage* message)
 		case kGeoLocationMessage:
 			_GeoLookupComplete(message);
 			break;
+		case kTransportMessage:
+			_SetTransport(message);
+			break;
+		case kTraceMessage:
+		{
+			BMessage reply(B_REPLY);
+			reply.AddInt32("status", _Trace(message));
+			message->SendReply(&reply);
+			break;
+		}
+		case kBudgetMessage:
+		{
+			int32 budget;
+			if (message->FindInt32("budget", &budget) == B_OK && budget > 0) {
+				AutoLocker<WeatherSettings> slocker(fSettings);
+				fSettings->SetHandlerBudget(budget);
+				fWatchdog->SetBudget(budget * 1000LL);
+			}
+			break;
+		}
+		case kForecastShownMessage:
+		{
+			bigtime_t latency = message->GetInt64("latency", -1);
+			if (latency < 0)
+				break;
+
+			if (message->GetBool("warm"))
+				fOpenStats->warm.Add(latency);
+			else
+				fOpenStats->cold.Add(latency);
+			fOpenStats->heldBytes = message->GetInt64("bytes", 0);
+			fOpenStats->iconBytes = message->GetInt64("icon bytes", 0);
+			break;
+		}
+		case kStatsMessage:
+		{
+			BString stats;
+			_GetStats(stats);
+			BMessage reply(B_REPLY);
+			reply.AddString("stats", stats);
+			message->SendReply(&reply);
+			break;
+		}
+		case kNetworkSettledMessage:
+			delete fNetworkRunner;
+			fNetworkRunner = NULL;
+			if (fLocationProvider != NULL)
+				fLocationProvider->NetworkChanged();
+			break;
 		case kGithubMessage:
 		{
 			const char* args[] = {kGithubURL, NULL};
@@ -246,7 +501,10 @@ DeskbarWeatherView::MessageReceived(BMessage* message)
 			_AboutRequested();
 			break;
 		default:
-			BView::MessageReceived(message);
+			if (fLocationProvider != NULL && fLocationProvider->Monitor()->IsChangeMessage(message))
+				_NetworkChanged();
+			else
+				BView::MessageReceived(message);
 	}
 }
 
@@ -254,41 +512,22 @@ DeskbarWeatherView::MessageReceived(BMessage* message)
 void
 DeskbarWeatherView::Draw(BRect updateRect)
 {
-	AutoLocker<BLocker> locker(fLock);
-	AutoLocker<WeatherSettings> slocker(fSettings);
-
-	float maxHeight = Bounds().Height();
+	TRACE_SCOPE("Draw");
+	WatchdogScope watch(fWatchdog, "Draw");
 
-	if (fIcon != NULL) {
-		SetDrawingMode(B_OP_ALPHA);
-		DrawBitmap(fIcon);
-		SetDrawingMode(B_OP_OVER);
-	} else {
-		BRect iconRect(0, 0, maxHeight - 1, maxHeight - 1);
-		rgb_color origColor = HighColor();
-		SetHighColor(0, 100, 255, 255);
-		FillRect(iconRect);
-		SetHighColor(origColor);
+	if (fTickerIndex > 0 && fTicker[fTickerIndex - 1].frame != NULL) {
+		DrawBitmap(fTicker[fTickerIndex - 1].frame, updateRect, updateRect);
+		BView::Draw(updateRect);
+		return;
 	}
 
-	BString tempString;
-	if (fWeather != NULL && fWeather->Current() != NULL)
-		if (fSettings->ImperialUnits())
-			tempString << fWeather->Current()->iTemp(fSettings->ShowFeelsLike() ? true : false) << "°";
-		else
-			tempString.SetToFormat("%.1f°", fWeather->Current()->Temp(fSettings->ShowFeelsLike() ? true : false));
-	else
-		tempString << "??°";
-
-	font_height fontHeight;
-	GetFontHeight(&fontHeight);
-
-	float textX = maxHeight + 1;
-	//FIXME textY calculation isn't quite right
-	float textY = (maxHeight / 2) + ((fontHeight.ascent - fontHeight.descent) / 2);
-	MovePenTo(textX, textY);
+	if (!fCacheValid)
+		_RenderCache();
 
-	DrawString(tempString.String());
+	if (fCache != NULL)
+		DrawBitmap(fCache, updateRect, updateRect);
+	else
+		_DrawContent(this, fIcon, fText);
 
 	BView::Draw(updateRect);
 }
@@ -308,6 +547,10 @@ DeskbarWeatherView::_AboutRequested()
 
 	//TODO show git hash in the version
 
+	BString stats("Request timings\n\n");
+	_GetStats(stats);
+	window->AddExtraInfo(stats);
+
 	window->Show();
 }
 
@@ -319,6 +562,23 @@ DeskbarWeatherView::_Init()
 		(new BAlert("Error", "Data lock failed InitCheck()!", "Ok", NULL, NULL, B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go();
 	//TODO exit app
 
+	// kept across transport and geolocation changes
+	fWeatherStats = new RequestStats();
+	fLocationStats = new RequestStats();
+	fWatchdog = new LooperWatchdog();
+	fOpenStats = new forecast_open_stats();
+	fOpenStats->heldBytes = 0;
+	fOpenStats->iconBytes = 0;
+	fWidths = new TextWidthCache();
+	fTicker = new ticker_location[kMaxSavedLocations];
+
+	// written on a thread of its own, the directory is only looked up once
+	fHistory = new HistoryRecorder(kMaxHistories);
+	BPath historyPath;
+	if (find_directory(B_USER_SETTINGS_DIRECTORY, &historyPath) == B_OK
+		&& historyPath.Append(kHistoryDirectory) == B_OK)
+		fHistory->Open(historyPath.Path());
+
 	if (fSettings == NULL) {
 		fSettings = new WeatherSettings();
 		if (fSettings->InitCheck() != B_OK) {
@@ -327,7 +587,10 @@ DeskbarWeatherView::_Init()
 		}
 	}
 
-	fIcon = LoadResourceBitmap("unknown", Bounds().Height());
+	// the first refresh finds them ready
+	_PrewarmIcons();
+	fIcon = IconCache::Default()->Get(kUnknownIcon, _IconSize());
+	fText = "??°";
 
 	BFont font;
 	if (fSettings->GetFont(font) == B_OK)
@@ -372,25 +635,74 @@ DeskbarWeatherView::_CheckMessageRunner()
 void
 DeskbarWeatherView::_ShowForecastWindow(bool toggle)
 {
-	// check if we have an existing forecast window and activate it
-	for (int32 x = 0; x < be_app->CountWindows(); x++) {
-		ForecastWindow* window = dynamic_cast<ForecastWindow*>(be_app->WindowAt(x));
-		if (window != NULL) {
-			if (toggle && window->IsActive())
-				// only quit if we're already the frontmost window
-				window->Quit();
-			else
-				window->Activate();
+	WatchdogScope watch(fWatchdog, "ShowForecastWindow");
 
+	bigtime_t requested = system_time();
+	AutoLocker<BLocker> locker(fLock);
+	AutoLocker<WeatherSettings> slocker(fSettings);
+
+	// an existing window shows or activates itself, even when it's hidden
+	if (fForecastWindow.IsValid()) {
+		BMessage message(kForecastToggleMessage);
+		message.AddBool("toggle", toggle);
+		message.AddBool("keep", fSettings->KeepForecastWindow());
+		message.AddInt64(kMessageSentKey, requested);
+		if (fForecastWindow.SendMessage(&message) == B_OK)
 			return;
-		}
 	}
 
-	AutoLocker<BLocker> locker(fLock);
-	AutoLocker<WeatherSettings> slocker(fSettings);
-	if (fWeather != NULL && fWeather->Current() != NULL)
+	if (fWeather != NULL && fWeather->Current() != NULL) {
+		// decode the rest of the last reply, and keep it coming while the window is open
+		fWeather->SetFields(kConsumerForecastWindow, kForecastWindowFields);
+		fWeather->Require(kConsumerForecastWindow);
+
+		forecast_snapshot snapshot;
+		build_forecast_snapshot(snapshot, *fWeather->Current(), *fWeather->Forecast(), fWeather->IsImperial());
+
 		//TODO save/restore window position
-		new ForecastWindow(fWeather, BRect(100, 100, 500, 300), fSettings->Location(), fSettings->CompactForecast());
+		ForecastWindow* window = new ForecastWindow(snapshot, BRect(100, 100, 500, 300), fSettings->Location(),
+			fSettings->CompactForecast(), BMessenger(this), fSettings->KeepForecastWindow(), false, requested);
+		fForecastWindow = BMessenger(window);
+	}
+}
+
+
+// builds a hidden window after the first refresh, so a click only has to show it
+void
+DeskbarWeatherView::_PrebuildForecastWindow()
+{
+	if (fForecastPrebuilt || !fSettings->KeepForecastWindow() || fForecastWindow.IsValid())
+		return;
+
+	fForecastPrebuilt = true;
+
+	fWeather->SetFields(kConsumerForecastWindow, kForecastWindowFields);
+	fWeather->Require(kConsumerForecastWindow);
+
+	forecast_snapshot snapshot;
+	build_forecast_snapshot(snapshot, *fWeather->Current(), *fWeather->Forecast(), fWeather->IsImperial());
+
+	ForecastWindow* window = new ForecastWindow(snapshot, BRect(100, 100, 500, 300), fSettings->Location(),
+		fSettings->CompactForecast(), BMessenger(this), true, true);
+	fForecastWindow = BMessenger(window);
+}
+
+
+// sends the new conditions to an open forecast window, which updates what changed
+void
+DeskbarWeatherView::_PublishSnapshot()
+{
+	if (!fForecastWindow.IsValid())
+		return;
+
+	forecast_snapshot snapshot;
+	build_forecast_snapshot(snapshot, *fWeather->Current(), *fWeather->Forecast(), fWeather->IsImperial());
+
+	BMessage message(kForecastSnapshotMessage);
+	message.AddData("snapshot", B_RAW_TYPE, &snapshot, sizeof(snapshot));
+	message.AddString("location", fSettings->Location());
+	message.AddBool("keep", fSettings->KeepForecastWindow());
+	fForecastWindow.SendMessage(&message);
 }
 
 
@@ -413,6 +725,8 @@ DeskbarWeatherView::_ShowSettingsWindow()
 void
 DeskbarWeatherView::_ForceRefresh()
 {
+	TRACE_SCOPE("ForceRefresh");
+	WatchdogScope watch(fWatchdog, "ForceRefresh");
 	AutoLocker<WeatherSettings> slocker(fSettings);
 
 	//TODO check if we have a valid location(latitude/longitude)
@@ -421,50 +735,573 @@ DeskbarWeatherView::_ForceRefresh()
 		_CheckMessageRunner();
 
 	fWeather->Refresh();
+	for (int32 x = 0; x < fTickerCount; x++)
+		fTicker[x].weather->Refresh();
 }
 
 
+// switches between the network, optionally capturing the replies, and the
+// replay of a capture archive
+void
+DeskbarWeatherView::_SetTransport(BMessage* message)
+{
+	WatchdogScope watch(fWatchdog, "SetTransport");
+	AutoLocker<BLocker> locker(fLock);
+
+	Transport* transport = NULL;
+	BString path;
+	status_t status = B_OK;
+	if (message->FindString("replay", &path) == B_OK) {
+		ReplayTransport* replay = new ReplayTransport();
+		status = replay->Load(path);
+
+		int32 value;
+		if (message->FindInt32("latency", &value) == B_OK)
+			replay->SetLatency(value * 1000LL);
+		if (message->FindInt32("bandwidth", &value) == B_OK)
+			replay->SetBandwidth(value * 1024LL);
+
+		transport = replay;
+	} else {
+		HttpTransport* http = new HttpTransport();
+		if (message->FindString("capture", &path) == B_OK)
+			status = http->StartCapture(path);
+
+		transport = http;
+	}
+
+	if (status != B_OK) {
+		BString content;
+		content.SetToFormat("%s\n\n%s", path.String(), strerror(status));
+		_ShowErrorNotification("Capture Archive Error", content);
+		delete transport;
+		return;
+	}
+
+	fWeather->SetTransport(transport);
+	for (int32 x = 0; x < fTickerCount; x++)
+		fTicker[x].weather->SetTransport(transport);
+	if (fLocationProvider != NULL)
+		fLocationProvider->SetTransport(transport);
+	delete fTransport;
+	fTransport = transport;
+
+	// go through the whole refresh again, a lookup is followed by a weather refresh
+	if (fLocationProvider != NULL)
+		fLocationProvider->Run(true);
+	else
+		_ForceRefresh();
+}
+
+
+// starts or stops tracing, or writes what was traced so far
 status_t
-DeskbarWeatherView::GetAppImage(image_info& image)
+DeskbarWeatherView::_Trace(BMessage* message)
 {
-	int32 cookie = 0;
-	while (get_next_image_info(B_CURRENT_TEAM, &cookie, &image) == B_OK) {
-		if ((char*)DeskbarWeatherView::GetAppImage >= (char*)image.text
-			&& (char*)DeskbarWeatherView::GetAppImage <= (char*)image.text + image.text_size)
-			return B_OK;
+	bool enable;
+	if (message->FindBool("enable", &enable) == B_OK) {
+		if (enable)
+			Trace::Start();
+		else
+			Trace::Stop();
 	}
 
-	return B_ERROR;
+	BString path;
+	if (message->FindString("dump", &path) == B_OK)
+		return Trace::Dump(path);
+
+	return B_OK;
+}
+
+
+void
+DeskbarWeatherView::_GetStats(BString& output)
+{
+	request_stats stats;
+	fWeatherStats->Get(stats);
+	format_request_stats(output, "Weather", stats);
+
+	output << "\n";
+	fLocationStats->Get(stats);
+	format_request_stats(output, "Location", stats);
+
+	output << "\n";
+	watchdog_stats watchdog;
+	fWatchdog->GetStats(watchdog);
+	format_watchdog_stats(output, watchdog);
+
+	output << "\n";
+	format_open_stats(output, *fOpenStats);
+
+	output << "\n";
+	icon_cache_stats icons;
+	IconCache::Default()->GetStats(icons);
+	format_icon_stats(output, icons);
+
+	int32 histories;
+	int32 observations;
+	int64 historyBytes;
+	fHistory->GetStats(histories, observations, historyBytes);
+	format_history_stats(output, histories, observations, historyBytes);
+}
+
+
+// only the fields that are shown get decoded from a reply
+void
+DeskbarWeatherView::_UpdateFields()
+{
+	if (fWeather == NULL)
+		return;
+
+	uint32 replicantFields = kForecastWeatherCode
+		| (fSettings->ShowFeelsLike() ? kForecastFeelsLike : kForecastTemperature);
+	if (fSettings->DisplayMode() == kDisplayHighLow)
+		replicantFields |= kForecastTodayRange;
+	else if (fSettings->DisplayMode() == kDisplayRain)
+		replicantFields |= kForecastHourly;
+	fWeather->SetFields(kConsumerReplicant, replicantFields);
+	fWeather->SetFields(kConsumerToolTip,
+		kForecastWeatherCode | kForecastTemperature | kForecastFeelsLike | kForecastTodayRange);
+	fWeather->SetFields(kConsumerNotification,
+		fSettings->UseNotification() ? kForecastWeatherCode | kForecastTemperature : 0);
+
+	fWeather->SetFields(kConsumerForecastWindow, fForecastWindow.IsValid() ? kForecastWindowFields : 0);
+	fWeather->SetFields(kConsumerHistory, kHistoryFields);
+}
+
+
+// what the replicant shows, a refresh that doesn't change it draws nothing
+void
+DeskbarWeatherView::_UpdateDisplay()
+{
+	// the feels like setting might have changed since the last refresh
+	if (fWeather != NULL)
+		fWeather->Require(kConsumerReplicant);
+
+	BString text;
+	const char* iconName = kUnknownIcon;
+	if (fWeather != NULL && fWeather->Current() != NULL) {
+		Condition* current = fWeather->Current();
+		format_replicant(text, fSettings->DisplayMode(), *current, fSettings->ImperialUnits(),
+			fSettings->ShowFeelsLike(), _CurrentRain());
+		iconName = current->Icon();
+	} else
+		text << "??°";
+
+	// tell the current location apart from the saved ones
+	if (fTickerCount > 0) {
+		BString name;
+		short_location_name(name, fSettings->Location());
+		text << " " << name;
+	}
+
+	// another resolution when the scale changed, or when it's ready
+	IconCache::Default()->UpdateScale();
+	BBitmap* icon = IconCache::Default()->Get(iconName, _IconSize());
+	if (icon != fIcon) {
+		fIcon = icon;
+		fCacheValid = false;
+	}
+
+	if (text != fText) {
+		fText = text;
+		fCacheValid = false;
+	}
+
+	_FitWidth();
+
+	if (!fCacheValid && fTickerIndex == 0)
+		Invalidate();
+}
+
+
+// grows or shrinks with the widest text, its shape rarely changes between refreshes
+void
+DeskbarWeatherView::_FitWidth()
+{
+	BFont font;
+	GetFont(&font);
+	float textWidth = fWidths->Width(font, fText);
+	for (int32 x = 0; x < fTickerCount; x++)
+		textWidth = fmaxf(textWidth, fWidths->Width(font, fTicker[x].text));
+
+	float width = ceilf(Bounds().Height() + 1 + textWidth);
+	if (width == Bounds().Width())
+		return;
+
+	ResizeTo(width, Bounds().Height());
+	fCacheValid = false;
+	_ComposeTickerFrames();
+	Invalidate();
+}
+
+
+// every icon at every size the settings can show, on the workers of the cache
+void
+DeskbarWeatherView::_PrewarmIcons()
+{
+	const char* names[kIconCacheIcons];
+	int32 nameCount = 0;
+	for (int32 x = 0; x < count_weather_icons() && nameCount < kIconCacheIcons; x++)
+		names[nameCount++] = weather_icon_name(x);
+
+	bool compact = fSettings->CompactForecast();
+	float sizes[5];
+	int32 sizeCount = 0;
+	sizes[sizeCount++] = _IconSize();
+	sizes[sizeCount++] = compact ? kCompactForecastIconSize : kForecastIconSize;
+	sizes[sizeCount++] = compact ? kStripCompactDayIconSize : kStripDayIconSize;
+	if (_HourlyForecast())
+		sizes[sizeCount++] = compact ? kStripCompactHourIconSize : kStripHourIconSize;
+	if (fSettings->UseNotification())
+		sizes[sizeCount++] = kNotificationIconSize;
+
+	IconCache::Default()->Prewarm(names, nameCount, sizes, sizeCount);
+
+	if (fSettings->UseGeoNotification())
+		IconCache::Default()->Prewarm(&kGeoLookupIcon, 1, &kNotificationIconSize, 1);
+}
+
+
+// the chance of rain in the replicant comes from the hourly forecast
+bool
+DeskbarWeatherView::_HourlyForecast()
+{
+	return fSettings->HourlyForecast() || fSettings->DisplayMode() == kDisplayRain;
+}
+
+
+// the Deskbar decides how high the replicant is, in physical pixels
+float
+DeskbarWeatherView::_IconSize()
+{
+	return Bounds().Height() / IconCache::Default()->Scale();
+}
+
+
+// the chance of rain in the current hour, when the hourly forecast was downloaded
+int16
+DeskbarWeatherView::_CurrentRain()
+{
+	ForecastModel* forecast = fWeather->Forecast();
+	int32 hour = forecast != NULL ? forecast->HourIndex(time(NULL)) : -1;
+	if (hour < 0)
+		return kMissingValue;
+
+	return forecast->HourlyPrecipitation()[hour];
+}
+
+
+// composes the icon and the text once for all the exposes that follow
+void
+DeskbarWeatherView::_RenderCache()
+{
+	TRACE_SCOPE("RenderCache");
+	fCacheValid = _ComposeFrame(fCache, fIcon, fText);
+}
+
+
+bool
+DeskbarWeatherView::_ComposeFrame(BBitmap*& frame, BBitmap* icon, const char* text)
+{
+	BRect bounds = Bounds();
+	if (frame != NULL && frame->Bounds() != bounds) {
+		delete frame;
+		frame = NULL;
+	}
+
+	if (frame == NULL) {
+		frame = new BBitmap(bounds, B_BITMAP_ACCEPTS_VIEWS, B_RGBA32);
+		if (frame->InitCheck() != B_OK) {
+			// Draw() does without
+			delete frame;
+			frame = NULL;
+			return false;
+		}
+
+		frame->Lock();
+		frame->AddChild(new BView(bounds, "cache", B_FOLLOW_NONE, 0));
+		frame->Unlock();
+	}
+
+	frame->Lock();
+	BView* view = frame->ChildAt(0);
+	BFont font;
+	GetFont(&font);
+	view->SetFont(&font);
+	view->SetHighColor(HighColor());
+	view->SetLowColor(ViewColor());
+	view->SetDrawingMode(B_OP_COPY);
+	view->FillRect(bounds, B_SOLID_LOW);
+	_DrawContent(view, icon, text);
+	view->Sync();
+	frame->Unlock();
+
+	return true;
+}
+
+
+void
+DeskbarWeatherView::_DrawContent(BView* view, BBitmap* icon, const char* text)
+{
+	float maxHeight = Bounds().Height();
+
+	if (icon != NULL) {
+		// the cache might only have another resolution for now
+		view->SetDrawingMode(B_OP_ALPHA);
+		view->DrawBitmap(icon, icon->Bounds(), BRect(0, 0, maxHeight, maxHeight), B_FILTER_BITMAP_BILINEAR);
+		view->SetDrawingMode(B_OP_OVER);
+	} else {
+		BRect iconRect(0, 0, maxHeight - 1, maxHeight - 1);
+		rgb_color origColor = view->HighColor();
+		view->SetHighColor(0, 100, 255, 255);
+		view->FillRect(iconRect);
+		view->SetHighColor(origColor);
+	}
+
+	font_height fontHeight;
+	view->GetFontHeight(&fontHeight);
+
+	float textX = maxHeight + 1;
+	//FIXME textY calculation isn't quite right
+	float textY = (maxHeight / 2) + ((fontHeight.ascent - fontHeight.descent) / 2);
+	view->MovePenTo(textX, textY);
+
+	view->DrawString(text);
+}
+
+
+// keeps the locations that are still saved, and their last reply
+void
+DeskbarWeatherView::_UpdateTicker()
+{
+	if (fWeather == NULL)
+		return;
+
+	ticker_location old[kMaxSavedLocations];
+	int32 oldCount = fTickerCount;
+	for (int32 x = 0; x < oldCount; x++)
+		old[x] = fTicker[x];
+
+	int32 count = fSettings->Ticker() ? fSettings->CountSavedLocations() : 0;
+	fTickerCount = 0;
+	for (int32 x = 0; x < count; x++) {
+		ticker_location& location = fTicker[fTickerCount];
+		if (fSettings->GetSavedLocation(x, location.name, location.latitude, location.longitude) != B_OK)
+			continue;
+
+		location.weather = NULL;
+		for (int32 y = 0; y < oldCount; y++) {
+			if (old[y].weather != NULL && old[y].latitude == location.latitude
+				&& old[y].longitude == location.longitude) {
+				location.serial = old[y].serial;
+				location.weather = old[y].weather;
+				location.text = old[y].text;
+				location.iconName = old[y].iconName;
+				location.icon = old[y].icon;
+				location.frame = old[y].frame;
+				old[y].weather = NULL;
+				break;
+			}
+		}
+
+		if (location.weather == NULL) {
+			BMessage* message = new BMessage(kTickerRefreshMessage);
+			location.serial = fTickerSerial++;
+			message->AddInt32("serial", location.serial);
+			// only the current conditions, the forecast is never shown
+			location.weather = new OpenMeteo(location.latitude, location.longitude, fSettings->ImperialUnits(), 0,
+				false, new BInvoker(message, this), fTransport, NULL);
+			location.text = "";
+			location.iconName = NULL;
+			location.icon = NULL;
+			location.frame = NULL;
+			location.weather->Refresh();
+		} else
+			location.weather->RebuildRequestUrl(location.latitude, location.longitude, fSettings->ImperialUnits(), 0,
+				false);
+
+		location.weather->SetFields(kConsumerReplicant, kForecastWeatherCode
+			| (fSettings->ShowFeelsLike() ? kForecastFeelsLike : kForecastTemperature));
+		location.weather->SetFields(kConsumerHistory, kHistoryFields);
+		fTickerCount++;
+	}
+
+	for (int32 x = 0; x < oldCount; x++) {
+		if (old[x].weather == NULL)
+			continue;
+
+		delete old[x].weather;
+		delete old[x].frame;
+	}
+
+	if (fTickerIndex > fTickerCount) {
+		fTickerIndex = 0;
+		Invalidate();
+	}
+
+	if (fTickerCount == 0) {
+		delete fTickerRunner;
+		fTickerRunner = NULL;
+		return;
+	}
+
+	if (fTickerRunner == NULL) {
+		BMessage tick(kTickerMessage);
+		fTickerRunner = new BMessageRunner(BMessenger(this), &tick, kTickerInterval, -1);
+		fTickerIdle = false;
+	}
+}
+
+
+void
+DeskbarWeatherView::_TickerRefreshComplete(BMessage* message)
+{
+	TRACE_SCOPE("TickerRefreshComplete");
+	WatchdogScope watch(fWatchdog, "TickerRefreshComplete");
+	AutoLocker<BLocker> locker(fLock);
+	AutoLocker<WeatherSettings> slocker(fSettings);
+
+	int32 serial = message->GetInt32("serial", -1);
+	int32 index = 0;
+	while (index < fTickerCount && fTicker[index].serial != serial)
+		index++;
+
+	// removed while the request was running
+	if (index == fTickerCount)
+		return;
+
+	// a saved location failing stays quiet, the current one reports it
+	ticker_location& location = fTicker[index];
+	if (!BHttpRequest::IsSuccessStatusCode(message->GetInt32("re:code", -1))
+		|| location.weather->ParseResult(*message) != B_OK)
+		return;
+
+	_RecordHistory(location.latitude, location.longitude, location.weather);
+
+	BString text;
+	format_replicant(text, kDisplayTemperature, *location.weather->Current(), fSettings->ImperialUnits(),
+		fSettings->ShowFeelsLike(), kMissingValue);
+	BString name;
+	short_location_name(name, location.name);
+	text << " " << name;
+
+	const char* iconName = location.weather->Current()->Icon();
+	if (text == location.text && iconName == location.iconName && location.frame != NULL)
+		return;
+
+	location.iconName = iconName;
+	location.icon = IconCache::Default()->Get(iconName, _IconSize());
+	location.text = text;
+
+	// the first reply also adds the name to the current location
+	_UpdateDisplay();
+	_ComposeFrame(location.frame, location.icon, location.text);
+
+	if (fTickerIndex == index + 1)
+		Invalidate();
+}
+
+
+// after the size, the font or the colors changed
+void
+DeskbarWeatherView::_ComposeTickerFrames()
+{
+	for (int32 x = 0; x < fTickerCount; x++) {
+		if (fTicker[x].iconName != NULL)
+			_ComposeFrame(fTicker[x].frame, fTicker[x].icon, fTicker[x].text);
+	}
+}
+
+
+// queues the current conditions, the recorder writes them on its own thread
+void
+DeskbarWeatherView::_RecordHistory(double latitude, double longitude, OpenMeteo* weather)
+{
+	const current_weather* current = weather->CurrentWeather();
+	if (current == NULL)
+		return;
+
+	history_record record;
+	make_history_record(*current, weather->IsImperial(), record);
+
+	// about a kilometer, so geolocation moving around a little stays in one history
+	char name[kHistoryNameLength];
+	snprintf(name, sizeof(name), "%.2f,%.2f", latitude, longitude);
+	fHistory->Record(name, record);
+}
+
+
+// only blits the next frame, nothing is drawn while nobody is looking
+void
+DeskbarWeatherView::_Tick()
+{
+	if (fTickerCount == 0 || fTickerRunner == NULL)
+		return;
+
+	if (idle_time() > kTickerIdleTime) {
+		if (!fTickerIdle) {
+			fTickerIdle = true;
+			fTickerRunner->SetInterval(kTickerIdleInterval);
+			if (fTickerIndex != 0) {
+				fTickerIndex = 0;
+				Invalidate();
+			}
+		}
+		return;
+	}
+
+	if (fTickerIdle) {
+		fTickerIdle = false;
+		fTickerRunner->SetInterval(kTickerInterval);
+	}
+
+	// skip the locations without a reply yet
+	int32 index = fTickerIndex;
+	do {
+		index = (index + 1) % (fTickerCount + 1);
+	} while (index != 0 && fTicker[index - 1].frame == NULL);
+
+	if (index != fTickerIndex) {
+		fTickerIndex = index;
+		Invalidate();
+	}
 }
 
 
 void
 DeskbarWeatherView::_RefreshComplete(BMessage* message)
 {
+	TRACE_SCOPE("RefreshComplete");
+	WatchdogScope watch(fWatchdog, "RefreshComplete");
 	AutoLocker<BLocker> locker(fLock);
 	AutoLocker<WeatherSettings> slocker(fSettings);
 	int32 status = message->GetInt32("re:code", -1);
 	BString response(message->GetString("re:message", "BMessage Error"));
+	bigtime_t applyStart = 0;
 
 	if (BHttpRequest::IsSuccessStatusCode(status)) {
+		_UpdateFields();
 		if (fWeather->ParseResult(*message) != B_OK) {
 			//TODO add a more descriptive error message
 			_ShowErrorNotification("Json Parse Error", "There was an error parsing the returned weather data!");
 			return;
-		} else if (fSettings->UseNotification()) {
+		}
+
+		applyStart = system_time();
+		_RecordHistory(fSettings->Latitude(), fSettings->Longitude(), fWeather);
+		if (fSettings->UseNotification()) {
 			BNotification notification(B_INFORMATION_NOTIFICATION);
 			if (notification.InitCheck() == B_OK) {
 				notification.SetGroup("DeskbarWeather");
 				notification.SetTitle("Weather Refresh Complete");
-				BString content(fSettings->Location());
-				//TODO configurable notification information
-				content << "\n\n" << fWeather->Current()->Forecast()->String() << "\n\n" << fWeather->Current()->Temp() << "°";
+				BString content;
+				format_notification(content, fSettings->Location(), *fWeather->Current());
 				notification.SetContent(content);
-				BBitmap* bitmap = LoadResourceBitmap(fWeather->Current()->Icon()->String(), 32);
-				if (bitmap != NULL) {
+				// the notification keeps a copy
+				BBitmap* bitmap = IconCache::Default()->Get(fWeather->Current()->Icon(), kNotificationIconSize);
+				if (bitmap != NULL)
 					notification.SetIcon(bitmap);
-					delete bitmap;
-				}
 				if (fSettings->NotificationClick()) {
 					notification.SetOnClickApp(kAppMimetype);
 					notification.AddOnClickArg("--forecast");
@@ -477,33 +1314,30 @@ DeskbarWeatherView::_RefreshComplete(BMessage* message)
 		return;
 	}
 
-	delete fIcon;
-	fIcon = LoadResourceBitmap(fWeather->Current()->Icon()->String(), Bounds().Height());
+	_UpdateDisplay();
 
 	BString updateStr;
 	fWeather->LastUpdate(updateStr);
-	//TODO configurable tooltip information
 	BString tooltip;
-	tooltip << fSettings->Location() << "\n";
-	tooltip << fWeather->Current()->Forecast()->String() << "\n";
-	// if we're showing "Feels Like" in the Deskbar then show actual temp in the tooltip
-	if (fSettings->ShowFeelsLike())
-		tooltip << "Current: " << fWeather->Current()->Temp() << "°\n";
-	else
-		tooltip << "Feels Like: " << fWeather->Current()->Temp(true) << "°\n";
-
-	tooltip << "High: " << fWeather->Current()->iHigh() << "°\n";
-	tooltip << "Low: " << fWeather->Current()->iLow() << "°\n";
-	tooltip << "Updated: " << updateStr;
+	format_tooltip(tooltip, fSettings->Location(), *fWeather->Current(), fSettings->ShowFeelsLike(), updateStr.String());
 	SetToolTip(tooltip);
 
-	Invalidate();
+	_PublishSnapshot();
+	_PrebuildForecastWindow();
+
+	fWeatherStats->AddPhase(kPhaseApply, system_time() - applyStart);
 }
 
 
 void
 DeskbarWeatherView::_GeoLookupComplete(BMessage* message)
 {
+	WatchdogScope watch(fWatchdog, "GeoLookupComplete");
+
+	// geolocation might have been turned off while the lookup was running
+	if (fLocationProvider == NULL)
+		return;
+
 	int32 status = message->GetInt32("re:code", -1);
 	BString response(message->GetString("re:message", "BMessage Error"));
 
@@ -521,6 +1355,12 @@ DeskbarWeatherView::_GeoLookupComplete(BMessage* message)
 		return;
 	}
 
+	bigtime_t applyStart = system_time();
+
+	// the lookup service doesn't always know a city name, fall back to the nearest known place
+	if (location.IsEmpty())
+		PlaceIndex::Default()->GetPlaceName(latitude, longitude, location);
+
 	AutoLocker<WeatherSettings> slocker(fSettings);
 
 	fSettings->SetLocation(latitude, longitude);
@@ -532,11 +1372,9 @@ DeskbarWeatherView::_GeoLookupComplete(BMessage* message)
 		BNotification notification(B_INFORMATION_NOTIFICATION);
 		notification.SetGroup("DeskbarWeather");
 		notification.SetTitle("GeoLocation Refresh Complete");
-		BBitmap* bitmap = LoadResourceBitmap("geolookup", 32);
-		if (bitmap != NULL) {
+		BBitmap* bitmap = IconCache::Default()->Get(kGeoLookupIcon, kNotificationIconSize);
+		if (bitmap != NULL)
 			notification.SetIcon(bitmap);
-			delete bitmap;
-		}
 		BString content;
 		content.SetToFormat("%s\n\nLatitude: %.4f\n\nLongitude: %.4f", location.String(), latitude, longitude);
 		if (message->HasBool(kGeoLookupCacheKey))
@@ -545,11 +1383,51 @@ DeskbarWeatherView::_GeoLookupComplete(BMessage* message)
 		notification.Send();
 	}
 
+	// answers from the cache never made a request
+	if (!message->HasBool(kGeoLookupCacheKey))
+		fLocationStats->AddPhase(kPhaseApply, system_time() - applyStart);
+
 	//TODO only force if we're not in manual refresh mode?
 	_ForceRefresh();
 }
 
 
+void
+DeskbarWeatherView::_StartGeoLocation()
+{
+	fLocationProvider = new IpApiLocationProvider(new BInvoker(new BMessage(kGeoLocationMessage), this), fTransport,
+		new InterfaceNetworkMonitor(), fLocationStats);
+	fLocationProvider->SetCacheLifetime(fSettings->GeoCacheLifetime());
+	fLocationProvider->Monitor()->StartWatching(BMessenger(this));
+	fLocationProvider->Run();
+}
+
+
+void
+DeskbarWeatherView::_StopGeoLocation()
+{
+	if (fLocationProvider == NULL)
+		return;
+
+	fLocationProvider->Monitor()->StopWatching(BMessenger(this));
+	delete fLocationProvider;
+	fLocationProvider = NULL;
+
+	delete fNetworkRunner;
+	fNetworkRunner = NULL;
+}
+
+
+void
+DeskbarWeatherView::_NetworkChanged()
+{
+	// interfaces and routes change in bursts, restart the timer on every notification
+	delete fNetworkRunner;
+	BMessage settledMessage(kNetworkSettledMessage);
+	fNetworkRunner = new BMessageRunner(BMessenger(this), &settledMessage, kNetworkSettleDelay, 1);
+}
+
+
 void
 DeskbarWeatherView::_RemoveFromDeskbar()
 {
@@ -626,7 +1504,7 @@ DeskbarWeatherView::_OpenUserGuide()
 	indexLocation.SetTo(PACKAGE_DOCUMENTATION_DIR);
 #else
 	image_info image;
-	if (DeskbarWeatherView::GetAppImage(image) != B_OK)
+	if (get_app_image(image) != B_OK)
 		return;
 
 	BPath exePath(image.name);
@@ -641,34 +1519,3 @@ DeskbarWeatherView::_OpenUserGuide()
 	if (rc != B_OK && rc != B_ALREADY_RUNNING)
 		(new BAlert("Error", "Failed to launch URL", "Ok", NULL, NULL, B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go();
 }
-
-
-BBitmap*
-DeskbarWeatherView::LoadResourceBitmap(const char* name, int32 size)
-{
-	BBitmap* bitmap = new BBitmap(BRect(0, 0, size, size), B_RGBA32);
-	if (bitmap == NULL)
-		return NULL;
-
-	if (bitmap->InitCheck() != B_OK) {
-		delete bitmap;
-		return NULL;
-	}
-
-	image_info image;
-	if (DeskbarWeatherView::GetAppImage(image) != B_OK)
-		return bitmap;
-
-	BFile file(image.name, B_READ_ONLY);
-	if (file.InitCheck() < B_OK)
-		return bitmap;
-
-	BResources resources(&file);
-
-	size_t datasize;
-	const void* data = resources.LoadResource(B_VECTOR_ICON_TYPE, name, &datasize);
-	if (data != NULL)
-		BIconUtils::GetVectorIcon(static_cast<const uint8*>(data), datasize, bitmap);
-
-	return bitmap;
-}
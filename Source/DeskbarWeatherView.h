@@ -6,6 +6,8 @@
 
 
 #include <Locker.h>
+#include <Messenger.h>
+#include <String.h>
 #include <View.h>
 
 enum {
@@ -18,7 +20,14 @@ enum {
 	kForceRefreshMessage = 'FrGw',
 	kSettingsChangeMessage = 'ScGw',
 	kGeoLocationMessage = 'GlGw',
-	kForceGeoLocationMessage = 'GfGw'
+	kForceGeoLocationMessage = 'GfGw',
+	kNetworkSettledMessage = 'NsGw',
+	kTransportMessage = 'TrGw',
+	kStatsMessage = 'StGw',
+	kTraceMessage = 'TcGw',
+	kBudgetMessage = 'BgGw',
+	kTickerMessage = 'TkGw',
+	kTickerRefreshMessage = 'TlGw'
 };
 
 #ifdef __GNUC__
@@ -37,8 +46,14 @@ class BBitmap;
 class BMessageRunner;
 
 class IpApiLocationProvider;
+class LooperWatchdog;
+class HistoryRecorder;
 class OpenMeteo;
+class RequestStats;
+class TextWidthCache;
+class Transport;
 class WeatherSettings;
+struct forecast_open_stats;
 
 
 class DeskbarWeatherView : public BView {
@@ -49,36 +64,89 @@ public:
 						~DeskbarWeatherView();
 
 	static	DeskbarWeatherView*	Instantiate(BMessage* message);
-	static	status_t	GetAppImage(image_info& image);
 
 	virtual	status_t	Archive(BMessage* message, bool deep = true) const;
 	virtual	void		AttachedToWindow();
+	virtual	void		DetachedFromWindow();
 	virtual	void		Draw(BRect updateRect);
 	virtual	void		MouseDown(BPoint point);
 	virtual	void		MessageReceived(BMessage* message);
 
-	static	BBitmap*	LoadResourceBitmap(const char* name, int32 size);
-
 private:
+	// a saved location shown in turn with the current one
+	struct ticker_location {
+		OpenMeteo*	weather;
+		int32		serial;		// finds the location again when its reply arrives
+		double		latitude;
+		double		longitude;
+		BString		name;
+		BString		text;
+		const char*	iconName;
+		BBitmap*	icon;		// belongs to the icon cache
+		BBitmap*	frame;		// composed when the text or the icon changed, shown with a single blit
+	};
+
 			void		_AboutRequested();
 			void		_Init();
 			status_t	_CheckMessageRunner();
 			void		_RefreshComplete(BMessage* message);
 			void		_GeoLookupComplete(BMessage* message);
+			void		_NetworkChanged();
+			void		_StartGeoLocation();
+			void		_StopGeoLocation();
 			void		_RemoveFromDeskbar();
 			void		_ShowPopUpMenu(BPoint point);
 			void		_OpenUserGuide();
 			void		_ShowErrorNotification(const char* title, const char* content);
 			void		_ShowForecastWindow(bool toggle = false);
+			void		_PrebuildForecastWindow();
+			void		_PublishSnapshot();
 			void		_ShowSettingsWindow();
 			void		_ForceRefresh();
-
-	BBitmap*				fIcon;
+			void		_SetTransport(BMessage* message);
+			status_t	_Trace(BMessage* message);
+			void		_GetStats(BString& output);
+			void		_UpdateFields();
+			void		_UpdateDisplay();
+			void		_RenderCache();
+			bool		_ComposeFrame(BBitmap*& frame, BBitmap* icon, const char* text);
+			void		_DrawContent(BView* view, BBitmap* icon, const char* text);
+			void		_FitWidth();
+			void		_PrewarmIcons();
+			bool		_HourlyForecast();
+			float		_IconSize();
+			int16		_CurrentRain();
+			void		_UpdateTicker();
+			void		_TickerRefreshComplete(BMessage* message);
+			void		_ComposeTickerFrames();
+			void		_Tick();
+			void		_RecordHistory(double latitude, double longitude, OpenMeteo* weather);
+
+	BBitmap*				fIcon;		// belongs to the icon cache
+	BString					fText;
+	BBitmap*				fCache;		// the icon and the text, so an expose is a single blit
+	bool					fCacheValid;
+	ticker_location*		fTicker;
+	int32					fTickerCount;
+	int32					fTickerIndex;	// 0 shows the current location
+	int32					fTickerSerial;
+	BMessageRunner*			fTickerRunner;
+	bool					fTickerIdle;
+	HistoryRecorder*		fHistory;
+	TextWidthCache*			fWidths;
+	BMessenger				fForecastWindow;
+	bool					fForecastPrebuilt;
+	forecast_open_stats*	fOpenStats;
 	IpApiLocationProvider*	fLocationProvider;
 	BLocker					fLock;
 	BMessageRunner*			fMessageRunner;
+	BMessageRunner*			fNetworkRunner;
+	LooperWatchdog*			fWatchdog;
 	WeatherSettings*		fSettings;
+	Transport*				fTransport;
 	OpenMeteo*				fWeather;
+	RequestStats*			fWeatherStats;
+	RequestStats*			fLocationStats;
 };
 
 
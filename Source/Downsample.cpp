@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "Downsample.h"
+
+#include <math.h>
+
+
+int32
+downsample_lttb(const float* values, int32 count, int32 threshold, int32* selected)
+{
+	int32 first = 0;
+	while (first < count && isnan(values[first]))
+		first++;
+	if (first == count)
+		return 0;
+
+	int32 last = count - 1;
+	while (isnan(values[last]))
+		last--;
+
+	int32 selectedCount = 0;
+	int32 span = last - first + 1;
+	if (threshold >= span || threshold < 3) {
+		for (int32 x = first; x <= last; x++) {
+			if (!isnan(values[x]))
+				selected[selectedCount++] = x;
+		}
+		return selectedCount;
+	}
+
+	// the first and last value are always kept, the rest is split into buckets
+	double bucketSize = static_cast<double>(span - 2) / (threshold - 2);
+	int32 previous = first;
+	selected[selectedCount++] = first;
+
+	for (int32 bucket = 0; bucket < threshold - 2; bucket++) {
+		int32 start = first + 1 + static_cast<int32>(bucket * bucketSize);
+		int32 end = first + 1 + static_cast<int32>((bucket + 1) * bucketSize);
+		int32 nextEnd = first + 1 + static_cast<int32>((bucket + 2) * bucketSize);
+		if (nextEnd > last + 1)
+			nextEnd = last + 1;
+
+		double averageX = 0;
+		double averageY = 0;
+		int32 averageCount = 0;
+		for (int32 x = end; x < nextEnd; x++) {
+			if (isnan(values[x]))
+				continue;
+			averageX += x;
+			averageY += values[x];
+			averageCount++;
+		}
+
+		if (averageCount > 0) {
+			averageX /= averageCount;
+			averageY /= averageCount;
+		} else {
+			averageX = last;
+			averageY = values[last];
+		}
+
+		double previousY = values[previous];
+		double largest = -1;
+		int32 picked = -1;
+		for (int32 x = start; x < end; x++) {
+			if (isnan(values[x]))
+				continue;
+
+			// twice the area, which is just as good for comparing
+			double area = fabs((previous - averageX) * (values[x] - previousY)
+				- (previous - x) * (averageY - previousY));
+			if (area > largest) {
+				largest = area;
+				picked = x;
+			}
+		}
+
+		if (picked >= 0) {
+			selected[selectedCount++] = picked;
+			previous = picked;
+		}
+	}
+
+	selected[selectedCount++] = last;
+	return selectedCount;
+}
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _DOWNSAMPLE_H_
+#define _DOWNSAMPLE_H_
+
+
+#include <SupportDefs.h>
+
+
+// Picks at most threshold of the evenly spaced values that keep the shape of
+// the line, with largest-triangle-three-buckets: the first and last value,
+// and from every bucket in between the one that spans the largest triangle
+// with the value picked before and the average of the next bucket.  NaN
+// values are never picked, a bucket with nothing else is left out.  Writes
+// the picked indices in ascending order and returns how many there are.
+int32	downsample_lttb(const float* values, int32 count, int32 threshold, int32* selected);
+
+#endif // _DOWNSAMPLE_H_
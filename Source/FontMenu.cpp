@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "FontMenu.h"
+
+#include <MenuItem.h>
+#include <String.h>
+
+#include <string.h>
+
+
+// sizes around the one of the plain font, in half points
+static const int32 kSizeCount = 17;
+
+
+// the sizes of a style, added when it's opened
+class FontStyleMenu : public BMenu {
+public:
+	FontStyleMenu(FontMenu* owner, const char* family, const char* style)
+		:
+		BMenu(style),
+		fOwner(owner),
+		fFamily(family)
+	{
+		SetRadioMode(false);
+	}
+
+
+	virtual bool
+	AddDynamicItem(add_state state)
+	{
+		if (state != B_INITIAL_ADD || CountItems() > 0)
+			return false;
+
+		for (int32 x = 0; x < kSizeCount; x++) {
+			float size = fOwner->_SizeAt(x);
+			BString label;
+			label.SetToFormat("%g", size);
+
+			BMessage* message = new BMessage(fOwner->fWhat);
+			message->AddString("FontFamily", fFamily);
+			message->AddString("FontStyle", Name());
+			message->AddDouble("FontSize", size);
+			AddItem(new BMenuItem(label, message));
+		}
+
+		fOwner->_StyleBuilt(this);
+		return false;
+	}
+
+private:
+	FontMenu*	fOwner;
+	BString		fFamily;
+};
+
+
+// the styles of a family, added when it's opened
+class FontFamilyMenu : public BMenu {
+public:
+	FontFamilyMenu(FontMenu* owner, const char* family)
+		:
+		BMenu(family),
+		fOwner(owner)
+	{
+		SetRadioMode(false);
+	}
+
+
+	virtual bool
+	AddDynamicItem(add_state state)
+	{
+		if (state != B_INITIAL_ADD || CountItems() > 0)
+			return false;
+
+		font_style style;
+		int32 count = count_font_styles(const_cast<char*>(Name()));
+		for (int32 x = 0; x < count; x++) {
+			if (get_font_style(const_cast<char*>(Name()), x, &style) == B_OK)
+				AddItem(new FontStyleMenu(fOwner, Name(), style));
+		}
+
+		fOwner->_FamilyBuilt(this);
+		return false;
+	}
+
+private:
+	FontMenu*	fOwner;
+};
+
+
+FontMenu::FontMenu(const char* label, uint32 what)
+	:
+	BPopUpMenu(label, false, false),
+	fWhat(what),
+	fBaseSize(be_plain_font->Size()),
+	fSize(0)
+{
+	SetLabelFromMarked(false);
+	fFamily[0] = '\0';
+	fStyle[0] = '\0';
+	for (int32 x = 0; x < kMarkedCount; x++)
+		fMarked[x] = NULL;
+
+	font_family family;
+	int32 count = count_font_families();
+	for (int32 x = 0; x < count; x++) {
+		if (get_font_family(x, &family) == B_OK)
+			AddItem(new FontFamilyMenu(this, family));
+	}
+}
+
+
+// marks the family, and the style and size when their menus were opened already
+void
+FontMenu::Select(const char* family, const char* style, float size)
+{
+	strlcpy(fFamily, family, sizeof(fFamily));
+	strlcpy(fStyle, style, sizeof(fStyle));
+	fSize = size;
+
+	for (int32 x = 0; x < kMarkedCount; x++)
+		_Mark(x, NULL);
+
+	for (int32 x = 0; x < CountItems(); x++) {
+		BMenuItem* familyItem = ItemAt(x);
+		if (strcmp(familyItem->Label(), family) == 0) {
+			_Mark(kMarkedFamily, familyItem);
+			_FamilyBuilt(familyItem->Submenu());
+			return;
+		}
+	}
+}
+
+
+void
+FontMenu::_FamilyBuilt(BMenu* familyMenu)
+{
+	if (familyMenu == NULL || strcmp(familyMenu->Name(), fFamily) != 0)
+		return;
+
+	for (int32 x = 0; x < familyMenu->CountItems(); x++) {
+		BMenuItem* styleItem = familyMenu->ItemAt(x);
+		if (strcmp(styleItem->Label(), fStyle) == 0) {
+			_Mark(kMarkedStyle, styleItem);
+			_StyleBuilt(styleItem->Submenu());
+			return;
+		}
+	}
+}
+
+
+void
+FontMenu::_StyleBuilt(BMenu* styleMenu)
+{
+	if (styleMenu == NULL || fMarked[kMarkedStyle] == NULL
+		|| styleMenu != fMarked[kMarkedStyle]->Submenu())
+		return;
+
+	_Mark(kMarkedSize, styleMenu->ItemAt(_SizeIndex(fSize)));
+}
+
+
+float
+FontMenu::_SizeAt(int32 index) const
+{
+	return fBaseSize - 4 + index * 0.5f;
+}
+
+
+// -1 for a size that isn't in the menu
+int32
+FontMenu::_SizeIndex(float size) const
+{
+	int32 index = static_cast<int32>((size - (fBaseSize - 4)) * 2);
+	if (index < 0 || index >= kSizeCount || _SizeAt(index) != size)
+		return -1;
+
+	return index;
+}
+
+
+void
+FontMenu::_Mark(int32 level, BMenuItem* item)
+{
+	if (fMarked[level] == item)
+		return;
+
+	if (fMarked[level] != NULL)
+		fMarked[level]->SetMarked(false);
+
+	fMarked[level] = item;
+	if (item != NULL)
+		item->SetMarked(true);
+}
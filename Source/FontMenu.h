@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _FONTMENU_H_
+#define _FONTMENU_H_
+
+
+#include <Font.h>
+#include <PopUpMenu.h>
+
+
+class BMenuItem;
+
+
+// Lists the font families, a family lists its styles and a style its sizes
+// only once it's opened, so building the menu costs one item per family.
+// Choosing a size sends a message with "FontFamily", "FontStyle" and
+// "FontSize".  The marked items are remembered, so marking another font only
+// touches those and the items of the new font that were built already.
+class FontMenu : public BPopUpMenu {
+public:
+							FontMenu(const char* label, uint32 what);
+
+			void			Select(const char* family, const char* style, float size);
+
+private:
+	friend class FontFamilyMenu;
+	friend class FontStyleMenu;
+
+	enum {
+		kMarkedFamily,
+		kMarkedStyle,
+		kMarkedSize,
+		kMarkedCount
+	};
+
+			void			_FamilyBuilt(BMenu* familyMenu);
+			void			_StyleBuilt(BMenu* styleMenu);
+			float			_SizeAt(int32 index) const;
+			int32			_SizeIndex(float size) const;
+			void			_Mark(int32 level, BMenuItem* item);
+
+			uint32			fWhat;
+			float			fBaseSize;
+			font_family		fFamily;
+			font_style		fStyle;
+			float			fSize;
+			BMenuItem*		fMarked[kMarkedCount];
+};
+
+
+#endif // _FONTMENU_H_
@@ -0,0 +1,661 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "ForecastChartView.h"
+#include "Downsample.h"
+#include "Trace.h"
+
+#include <Bitmap.h>
+#include <LayoutUtils.h>
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+
+// the layers grow in steps, so resizing the window doesn't allocate them every frame
+static const int32 kLayerGranularity = 64;
+static const int32 kMinPlotWidth = 48;
+static const int32 kPreferredPlotWidth = 240;
+static const float kTemperatureSteps[] = {1, 2, 5, 10, 20, 50};
+static const int32 kMaxTemperatureLines = 4;
+
+static const rgb_color kTemperatureColor = {220, 70, 40, 255};
+static const rgb_color kFeelsLikeColor = {240, 170, 50, 255};
+static const rgb_color kRainColor = {60, 120, 220, 255};
+static const uint8 kRainFillAlpha = 72;
+
+
+ForecastChartView::ForecastChartView(const char* name, bool compact)
+	:
+	BView(name, B_WILL_DRAW | B_FRAME_EVENTS),
+	fCompact(compact),
+	fHourCount(0),
+	fHourlyStart(0),
+	fDayStartCount(0),
+	fMin(0),
+	fMax(1),
+	fStep(1),
+	fWidth(-1),
+	fHeight(-1),
+	fHover(-1),
+	fLineHeight(0),
+	fAscent(0),
+	fInset(0),
+	fLeftMargin(0),
+	fRightMargin(0)
+{
+	fWeekdayFormat.SetDateTimeFormat(B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT, B_DATE_ELEMENT_WEEKDAY);
+
+	for (int32 x = 0; x < kChartLayerCount; x++) {
+		fLayers[x].bitmap = NULL;
+		fLayers[x].view = NULL;
+		fLayers[x].valid = false;
+	}
+	fComposite.bitmap = NULL;
+	fComposite.view = NULL;
+	fComposite.valid = false;
+
+	// the composed layers cover everything
+	SetViewColor(B_TRANSPARENT_COLOR);
+	SetLowUIColor(B_PANEL_BACKGROUND_COLOR);
+	SetHighUIColor(B_PANEL_TEXT_COLOR);
+
+	_UpdateMetrics();
+}
+
+
+ForecastChartView::~ForecastChartView()
+{
+	_FreeLayers();
+}
+
+
+void
+ForecastChartView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+
+	// the font might be a different one now
+	_UpdateMetrics();
+	_InvalidateLayers();
+}
+
+
+void
+ForecastChartView::Draw(BRect updateRect)
+{
+	TRACE_SCOPE("ForecastChartView::Draw");
+	if (!_PrepareLayers()) {
+		FillRect(updateRect, B_SOLID_LOW);
+		return;
+	}
+
+	// the layers start at the origin of the view, which never scrolls
+	DrawBitmap(fComposite.bitmap, updateRect, updateRect);
+
+	if (fHover >= 0 && updateRect.Intersects(fCrosshairFrame))
+		_DrawCrosshair();
+}
+
+
+void
+ForecastChartView::FrameResized(float width, float height)
+{
+	BView::FrameResized(width, height);
+
+	// the hours moved, the mouse will tell where it is now
+	fHover = -1;
+	Invalidate();
+}
+
+
+void
+ForecastChartView::MouseMoved(BPoint where, uint32 transit, const BMessage* /*dragMessage*/)
+{
+	int32 hover = transit == B_EXITED_VIEW || transit == B_OUTSIDE_VIEW ? -1 : _HourAt(where.x);
+	if (hover == fHover)
+		return;
+
+	if (fHover >= 0)
+		Invalidate(fCrosshairFrame);
+
+	fHover = hover;
+	if (fHover >= 0) {
+		fCrosshairFrame = _CrosshairFrame(fHover);
+		Invalidate(fCrosshairFrame);
+	}
+}
+
+
+BSize
+ForecastChartView::MinSize()
+{
+	return BLayoutUtils::ComposeSize(ExplicitMinSize(),
+		BSize(fLeftMargin + fRightMargin + kMinPlotWidth, fLineHeight * 5));
+}
+
+
+BSize
+ForecastChartView::MaxSize()
+{
+	return BLayoutUtils::ComposeSize(ExplicitMaxSize(), BSize(B_SIZE_UNLIMITED, PreferredSize().height));
+}
+
+
+BSize
+ForecastChartView::PreferredSize()
+{
+	return BLayoutUtils::ComposeSize(ExplicitPreferredSize(),
+		BSize(fLeftMargin + fRightMargin + kPreferredPlotWidth, fLineHeight * (fCompact ? 6 : 8)));
+}
+
+
+void
+ForecastChartView::SetSnapshot(const forecast_snapshot& snapshot)
+{
+	TRACE_SCOPE("ForecastChartView::SetSnapshot");
+	int32 count = snapshot.hourCount;
+	bool hoursMoved = count != fHourCount || snapshot.hourlyStart != fHourlyStart;
+
+	// compared bitwise, so missing values are equal
+	bool changed = hoursMoved
+		|| memcmp(fSeries[kSeriesTemperature], snapshot.hourlyTemps, count * sizeof(float)) != 0
+		|| memcmp(fSeries[kSeriesFeelsLike], snapshot.hourlyFeelsLike, count * sizeof(float)) != 0;
+	for (int32 x = 0; x < count && !changed; x++) {
+		float rain = snapshot.hourlyRain[x] != kMissingValue ? snapshot.hourlyRain[x] : NAN;
+		changed = memcmp(&rain, &fSeries[kSeriesRain][x], sizeof(float)) != 0;
+	}
+
+	if (!changed)
+		return;
+
+	fHourCount = count;
+	fHourlyStart = snapshot.hourlyStart;
+	memcpy(fSeries[kSeriesTemperature], snapshot.hourlyTemps, count * sizeof(float));
+	memcpy(fSeries[kSeriesFeelsLike], snapshot.hourlyFeelsLike, count * sizeof(float));
+	for (int32 x = 0; x < count; x++)
+		fSeries[kSeriesRain][x] = snapshot.hourlyRain[x] != kMissingValue ? snapshot.hourlyRain[x] : NAN;
+
+	// the grid and the axes only change with the hours or the range
+	if (_UpdateRange() || hoursMoved) {
+		_UpdateDays();
+		fLayers[kChartGrid].valid = false;
+		fLayers[kChartAxes].valid = false;
+	}
+	fLayers[kChartSeries].valid = false;
+	fComposite.valid = false;
+
+	if (fHover >= fHourCount)
+		fHover = -1;
+	if (fHover >= 0)
+		fCrosshairFrame = _CrosshairFrame(fHover);
+
+	Invalidate();
+}
+
+
+int64
+ForecastChartView::HeldBytes() const
+{
+	int64 bytes = fComposite.bitmap != NULL ? fComposite.bitmap->BitsLength() : 0;
+	for (int32 x = 0; x < kChartLayerCount; x++) {
+		if (fLayers[x].bitmap != NULL)
+			bytes += fLayers[x].bitmap->BitsLength();
+	}
+
+	return bytes;
+}
+
+
+void
+ForecastChartView::_UpdateMetrics()
+{
+	font_height height;
+	GetFontHeight(&height);
+	fAscent = ceilf(height.ascent);
+	fLineHeight = ceilf(height.ascent + height.descent + height.leading);
+	fInset = ceilf(fLineHeight / (fCompact ? 4 : 2));
+
+	fLeftMargin = ceilf(StringWidth("-88°") + fInset * 2);
+	fRightMargin = ceilf(StringWidth("100%") + fInset * 2);
+}
+
+
+// rounds the range of both temperatures out to the steps of the grid,
+// returns if it changed
+bool
+ForecastChartView::_UpdateRange()
+{
+	float min = 0;
+	float max = 0;
+	float feelsMin, feelsMax;
+	bool found = ForecastModel::GetRange(fSeries[kSeriesTemperature], fHourCount, min, max);
+	if (ForecastModel::GetRange(fSeries[kSeriesFeelsLike], fHourCount, feelsMin, feelsMax)) {
+		min = found ? min_c(min, feelsMin) : feelsMin;
+		max = found ? max_c(max, feelsMax) : feelsMax;
+	}
+
+	float step = kTemperatureSteps[0];
+	for (size_t x = 0; x < sizeof(kTemperatureSteps) / sizeof(kTemperatureSteps[0]); x++) {
+		step = kTemperatureSteps[x];
+		if ((max - min) / step <= kMaxTemperatureLines)
+			break;
+	}
+
+	min = floorf(min / step) * step;
+	max = ceilf(max / step) * step;
+	if (max <= min)
+		max = min + step;
+
+	if (min == fMin && max == fMax && step == fStep)
+		return false;
+
+	fMin = min;
+	fMax = max;
+	fStep = step;
+	return true;
+}
+
+
+// once for every snapshot instead of every frame, the local midnights move with daylight saving time
+void
+ForecastChartView::_UpdateDays()
+{
+	fDayStartCount = 0;
+	for (int32 index = 0; index < fHourCount && fDayStartCount <= kMaxForecastDays; index++) {
+		time_t time = fHourlyStart + static_cast<time_t>(index) * kHourlyInterval;
+		struct tm local;
+		localtime_r(&time, &local);
+		if (local.tm_hour == 0)
+			fDayStarts[fDayStartCount++] = index;
+	}
+}
+
+
+// draws the layers that changed and composes them again, false when there's nothing to draw
+bool
+ForecastChartView::_PrepareLayers()
+{
+	float width = Bounds().Width() + 1;
+	float height = Bounds().Height() + 1;
+	if (fHourCount < 2 || width < 1 || height < 1)
+		return false;
+
+	if (width != fWidth || height != fHeight) {
+		if (!_AllocateLayers(width, height))
+			return false;
+
+		fWidth = width;
+		fHeight = height;
+		fPlot.Set(fLeftMargin, fInset + ceilf(fAscent / 2), width - 1 - fRightMargin,
+			height - 1 - fLineHeight - fInset);
+		_InvalidateLayers();
+	}
+
+	if (fPlot.Width() < 2 || fPlot.Height() < 2)
+		return false;
+
+	void (ForecastChartView::*render[kChartLayerCount])(BView*) = {
+		&ForecastChartView::_RenderGrid, &ForecastChartView::_RenderSeries, &ForecastChartView::_RenderAxes
+	};
+
+	for (int32 x = 0; x < kChartLayerCount; x++) {
+		layer& target = fLayers[x];
+		if (target.valid)
+			continue;
+
+		target.bitmap->Lock();
+		// only the grid is opaque, the others are composed over it
+		if (x != kChartGrid)
+			memset(target.bitmap->Bits(), 0, target.bitmap->BitsLength());
+		(this->*render[x])(target.view);
+		target.view->Sync();
+		target.bitmap->Unlock();
+
+		target.valid = true;
+		fComposite.valid = false;
+	}
+
+	if (!fComposite.valid)
+		_Compose();
+
+	return true;
+}
+
+
+// keeps the layers when they're large enough already
+bool
+ForecastChartView::_AllocateLayers(float width, float height)
+{
+	if (fComposite.bitmap != NULL && fComposite.bitmap->Bounds().Width() + 1 >= width
+		&& fComposite.bitmap->Bounds().Height() + 1 >= height)
+		return true;
+
+	_FreeLayers();
+
+	int32 layerWidth = (static_cast<int32>(width) + kLayerGranularity - 1) / kLayerGranularity * kLayerGranularity;
+	BRect frame(0, 0, layerWidth - 1, height - 1);
+
+	BFont font;
+	GetFont(&font);
+
+	for (int32 x = 0; x <= kChartLayerCount; x++) {
+		layer& target = x < kChartLayerCount ? fLayers[x] : fComposite;
+		target.bitmap = new BBitmap(frame, B_BITMAP_ACCEPTS_VIEWS, B_RGBA32);
+		if (target.bitmap->InitCheck() != B_OK) {
+			_FreeLayers();
+			return false;
+		}
+
+		target.view = new BView(frame, "layer", B_FOLLOW_NONE, 0);
+		target.bitmap->Lock();
+		target.bitmap->AddChild(target.view);
+		target.view->SetFont(&font);
+		if (x != kChartGrid && x != kChartLayerCount) {
+			target.view->SetDrawingMode(B_OP_ALPHA);
+			target.view->SetBlendingMode(B_PIXEL_ALPHA, B_ALPHA_COMPOSITE);
+		}
+		target.bitmap->Unlock();
+		target.valid = false;
+	}
+
+	return true;
+}
+
+
+void
+ForecastChartView::_FreeLayers()
+{
+	// the views belong to their bitmaps
+	for (int32 x = 0; x <= kChartLayerCount; x++) {
+		layer& target = x < kChartLayerCount ? fLayers[x] : fComposite;
+		delete target.bitmap;
+		target.bitmap = NULL;
+		target.view = NULL;
+		target.valid = false;
+	}
+
+	fWidth = fHeight = -1;
+}
+
+
+void
+ForecastChartView::_InvalidateLayers()
+{
+	for (int32 x = 0; x < kChartLayerCount; x++)
+		fLayers[x].valid = false;
+	fComposite.valid = false;
+
+	Invalidate();
+}
+
+
+void
+ForecastChartView::_RenderGrid(BView* view)
+{
+	TRACE_SCOPE("ForecastChartView::_RenderGrid");
+	view->SetHighColor(LowColor());
+	view->FillRect(view->Bounds());
+
+	view->SetHighColor(tint_color(LowColor(), B_DARKEN_1_TINT));
+	for (float value = fMin; value <= fMax; value += fStep) {
+		float y = roundf(_Y(kSeriesTemperature, value));
+		view->StrokeLine(BPoint(fPlot.left, y), BPoint(fPlot.right, y));
+	}
+
+	view->SetHighColor(tint_color(LowColor(), B_DARKEN_2_TINT));
+	for (int32 x = 0; x < fDayStartCount; x++) {
+		float left = roundf(_X(fDayStarts[x]));
+		view->StrokeLine(BPoint(left, fPlot.top), BPoint(left, fPlot.bottom));
+	}
+}
+
+
+void
+ForecastChartView::_RenderSeries(BView* view)
+{
+	TRACE_SCOPE("ForecastChartView::_RenderSeries");
+	view->SetPenSize(1);
+	rgb_color rain = kRainColor;
+	rain.alpha = kRainFillAlpha;
+	_DrawSeries(view, kSeriesRain, rain, true);
+	_DrawSeries(view, kSeriesRain, kRainColor, false);
+
+	view->SetPenSize(fCompact ? 1 : 2);
+	_DrawSeries(view, kSeriesFeelsLike, kFeelsLikeColor, false);
+	_DrawSeries(view, kSeriesTemperature, kTemperatureColor, false);
+	view->SetPenSize(1);
+}
+
+
+void
+ForecastChartView::_RenderAxes(BView* view)
+{
+	TRACE_SCOPE("ForecastChartView::_RenderAxes");
+	view->SetHighColor(tint_color(LowColor(), B_DARKEN_3_TINT));
+	view->StrokeLine(BPoint(fPlot.left, fPlot.bottom), BPoint(fPlot.right, fPlot.bottom));
+	view->StrokeLine(BPoint(fPlot.left, fPlot.top), BPoint(fPlot.left, fPlot.bottom));
+	view->StrokeLine(BPoint(fPlot.right, fPlot.top), BPoint(fPlot.right, fPlot.bottom));
+
+	view->SetHighColor(HighColor());
+	float baseline = floorf(fAscent / 2);
+	BString label;
+	for (float value = fMin; value <= fMax; value += fStep) {
+		label.SetToFormat("%.0f°", value);
+		float y = roundf(_Y(kSeriesTemperature, value)) + baseline;
+		view->DrawString(label, BPoint(fPlot.left - fInset - view->StringWidth(label), y));
+	}
+
+	for (int32 value = 0; value <= 100; value += 50) {
+		label.SetToFormat("%" B_PRId32 "%%", value);
+		view->DrawString(label, BPoint(fPlot.right + fInset, roundf(_Y(kSeriesRain, value)) + baseline));
+	}
+
+	// the weekdays between the midnights, where they fit
+	float y = fPlot.bottom + fInset + fAscent;
+	for (int32 x = -1; x < fDayStartCount; x++) {
+		int32 start = x < 0 ? 0 : fDayStarts[x];
+		int32 end = x + 1 < fDayStartCount ? fDayStarts[x + 1] : fHourCount - 1;
+		if (end <= start)
+			continue;
+
+		label.Truncate(0);
+		fWeekdayFormat.Format(label, fHourlyStart + static_cast<time_t>(start) * kHourlyInterval,
+			B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT);
+		float width = view->StringWidth(label);
+		float left = _X(start);
+		float right = _X(end);
+		if (right - left >= width + fInset)
+			view->DrawString(label, BPoint(floorf((left + right - width) / 2), y));
+	}
+}
+
+
+void
+ForecastChartView::_Compose()
+{
+	TRACE_SCOPE("ForecastChartView::_Compose");
+	BView* view = fComposite.view;
+	fComposite.bitmap->Lock();
+
+	view->SetDrawingMode(B_OP_COPY);
+	view->DrawBitmap(fLayers[kChartGrid].bitmap, BPoint(0, 0));
+	view->SetDrawingMode(B_OP_ALPHA);
+	view->SetBlendingMode(B_PIXEL_ALPHA, B_ALPHA_OVERLAY);
+	view->DrawBitmap(fLayers[kChartSeries].bitmap, BPoint(0, 0));
+	view->DrawBitmap(fLayers[kChartAxes].bitmap, BPoint(0, 0));
+	view->Sync();
+
+	fComposite.bitmap->Unlock();
+	fComposite.valid = true;
+}
+
+
+// the line through the downsampled values, broken where values are missing
+void
+ForecastChartView::_DrawSeries(BView* view, int32 series, rgb_color color, bool fill)
+{
+	const float* values = fSeries[series];
+	int32 count = downsample_lttb(values, fHourCount, static_cast<int32>(fPlot.Width()) + 1, fSelected);
+
+	view->SetHighColor(color);
+	int32 pointCount = 0;
+	for (int32 x = 0; x < count; x++) {
+		int32 index = fSelected[x];
+		if (x > 0) {
+			// downsampling never picks a missing value, so a gap is between two picked ones
+			for (int32 between = fSelected[x - 1] + 1; between < index; between++) {
+				if (isnan(values[between])) {
+					_DrawRun(view, pointCount, fill);
+					pointCount = 0;
+					break;
+				}
+			}
+		}
+
+		fPoints[pointCount++] = BPoint(_X(index), _Y(series, values[index]));
+	}
+
+	_DrawRun(view, pointCount, fill);
+}
+
+
+void
+ForecastChartView::_DrawRun(BView* view, int32 count, bool fill)
+{
+	if (count < 2)
+		return;
+
+	if (!fill) {
+		view->StrokePolygon(fPoints, count, false);
+		return;
+	}
+
+	fPoints[count] = BPoint(fPoints[count - 1].x, fPlot.bottom);
+	fPoints[count + 1] = BPoint(fPoints[0].x, fPlot.bottom);
+	view->FillPolygon(fPoints, count + 2);
+}
+
+
+void
+ForecastChartView::_DrawCrosshair()
+{
+	TRACE_SCOPE("ForecastChartView::_DrawCrosshair");
+	float x = roundf(_X(fHover));
+	SetHighColor(tint_color(LowColor(), B_DARKEN_4_TINT));
+	StrokeLine(BPoint(x, fPlot.top), BPoint(x, fPlot.bottom));
+
+	const rgb_color colors[kSeriesCount] = {kTemperatureColor, kFeelsLikeColor, kRainColor};
+	for (int32 series = 0; series < kSeriesCount; series++) {
+		float value = fSeries[series][fHover];
+		if (isnan(value))
+			continue;
+
+		SetHighColor(colors[series]);
+		FillEllipse(BPoint(x, _Y(series, value)), 3, 3);
+	}
+
+	BString texts[3];
+	_CrosshairTexts(fHover, texts);
+
+	// the box is what's left of the frame next to the line
+	BRect box = fCrosshairFrame;
+	if (box.right > x + 4)
+		box.left = x + 4;
+	else
+		box.right = x - 4;
+	box.bottom = box.top + fLineHeight * 3 + fInset;
+
+	SetHighColor(tint_color(LowColor(), B_LIGHTEN_1_TINT));
+	FillRect(box);
+	SetHighColor(tint_color(LowColor(), B_DARKEN_2_TINT));
+	StrokeRect(box);
+
+	SetHighUIColor(B_PANEL_TEXT_COLOR);
+	SetDrawingMode(B_OP_OVER);
+	float y = box.top + fInset / 2 + fAscent;
+	for (int32 line = 0; line < 3; line++) {
+		DrawString(texts[line], BPoint(box.left + fInset, y));
+		y += fLineHeight;
+	}
+	SetDrawingMode(B_OP_COPY);
+}
+
+
+void
+ForecastChartView::_CrosshairTexts(int32 index, BString* texts)
+{
+	time_t time = fHourlyStart + static_cast<time_t>(index) * kHourlyInterval;
+	fWeekdayFormat.Format(texts[0], time, B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT);
+	BString hour;
+	fHourFormat.Format(hour, time, B_SHORT_TIME_FORMAT);
+	texts[0] << " " << hour;
+
+	float temperature = fSeries[kSeriesTemperature][index];
+	float feelsLike = fSeries[kSeriesFeelsLike][index];
+	if (isnan(temperature))
+		texts[1] = "-";
+	else
+		texts[1].SetToFormat("%.0f°", temperature);
+	if (!isnan(feelsLike))
+		texts[1] << BString().SetToFormat(", feels like %.0f°", feelsLike);
+
+	float rain = fSeries[kSeriesRain][index];
+	if (isnan(rain))
+		texts[2] = "Rain: -";
+	else
+		texts[2].SetToFormat("Rain: %.0f%%", rain);
+}
+
+
+// the line with its dots and the box with the values, on the side of the line where it fits
+BRect
+ForecastChartView::_CrosshairFrame(int32 index)
+{
+	BString texts[3];
+	_CrosshairTexts(index, texts);
+
+	float width = 0;
+	for (int32 line = 0; line < 3; line++)
+		width = max_c(width, StringWidth(texts[line]));
+	width = ceilf(width + fInset * 2);
+
+	float x = roundf(_X(index));
+	BRect frame(x - 4, fPlot.top - 3, x + 4, fPlot.bottom + 3);
+	if (x + 4 + width <= fPlot.right)
+		frame.right = x + 4 + width;
+	else
+		frame.left = x - 4 - width;
+	frame.bottom = max_c(frame.bottom, frame.top + fLineHeight * 3 + fInset);
+
+	return frame;
+}
+
+
+int32
+ForecastChartView::_HourAt(float x) const
+{
+	if (fHourCount < 2 || fWidth < 0 || x < fPlot.left || x > fPlot.right)
+		return -1;
+
+	return static_cast<int32>(roundf((x - fPlot.left) / fPlot.Width() * (fHourCount - 1)));
+}
+
+
+float
+ForecastChartView::_X(int32 index) const
+{
+	return fPlot.left + index * fPlot.Width() / (fHourCount - 1);
+}
+
+
+float
+ForecastChartView::_Y(int32 series, float value) const
+{
+	// the chance of rain has its own axis on the right
+	if (series == kSeriesRain)
+		return fPlot.bottom - value / 100 * fPlot.Height();
+
+	return fPlot.bottom - (value - fMin) / (fMax - fMin) * fPlot.Height();
+}
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _FORECASTCHARTVIEW_H_
+#define _FORECASTCHARTVIEW_H_
+
+
+#include <DateTimeFormat.h>
+#include <String.h>
+#include <TimeFormat.h>
+#include <View.h>
+
+#include "ForecastSnapshot.h"
+
+class BBitmap;
+
+
+enum chart_layer {
+	kChartGrid,
+	kChartSeries,
+	kChartAxes,
+	kChartLayerCount
+};
+
+
+// Draws the hourly temperature, feels like and chance of rain over the whole
+// forecast.  The grid, the series and the axes are drawn into offscreen
+// layers that are only drawn again when the size or the data changes, and
+// composed into one bitmap, so most frames are a single blit.  The series are
+// downsampled to the width of the chart first.  The crosshair under the mouse
+// is drawn over the blit, moving it redraws only where it was and where it is.
+class ForecastChartView : public BView {
+public:
+								ForecastChartView(const char* name, bool compact);
+	virtual						~ForecastChartView();
+
+	virtual	void				AttachedToWindow();
+	virtual	void				Draw(BRect updateRect);
+	virtual	void				FrameResized(float width, float height);
+	virtual	void				MouseMoved(BPoint where, uint32 transit, const BMessage* dragMessage);
+
+	virtual	BSize				MinSize();
+	virtual	BSize				MaxSize();
+	virtual	BSize				PreferredSize();
+
+			// draws the layers again only when the hours changed
+			void				SetSnapshot(const forecast_snapshot& snapshot);
+
+			// what the layers take
+			int64				HeldBytes() const;
+
+private:
+	struct layer {
+		BBitmap*	bitmap;
+		BView*		view;
+		bool		valid;
+	};
+
+	enum {
+		kSeriesTemperature,
+		kSeriesFeelsLike,
+		kSeriesRain,
+		kSeriesCount
+	};
+
+			void				_UpdateMetrics();
+			bool				_UpdateRange();
+			void				_UpdateDays();
+			bool				_PrepareLayers();
+			bool				_AllocateLayers(float width, float height);
+			void				_FreeLayers();
+			void				_InvalidateLayers();
+			void				_RenderGrid(BView* view);
+			void				_RenderSeries(BView* view);
+			void				_RenderAxes(BView* view);
+			void				_Compose();
+			void				_DrawSeries(BView* view, int32 series, rgb_color color, bool fill);
+			void				_DrawRun(BView* view, int32 count, bool fill);
+			void				_DrawCrosshair();
+			void				_CrosshairTexts(int32 index, BString* texts);
+			BRect				_CrosshairFrame(int32 index);
+			int32				_HourAt(float x) const;
+			float				_X(int32 index) const;
+			float				_Y(int32 series, float value) const;
+
+			bool				fCompact;
+			int32				fHourCount;
+			time_t				fHourlyStart;
+			float				fSeries[kSeriesCount][kMaxForecastHours];	// NaN when missing
+			int32				fDayStarts[kMaxForecastDays + 1];	// the first hour of each day
+			int32				fDayStartCount;
+
+			float				fMin;
+			float				fMax;
+			float				fStep;
+
+			layer				fLayers[kChartLayerCount];
+			layer				fComposite;
+			float				fWidth;		// the size the layers were drawn for
+			float				fHeight;
+			BRect				fPlot;
+
+			int32				fHover;		// -1 when the mouse isn't over the chart
+			BRect				fCrosshairFrame;
+
+			BDateTimeFormat		fWeekdayFormat;
+			BTimeFormat			fHourFormat;
+
+			float				fLineHeight;
+			float				fAscent;
+			float				fInset;
+			float				fLeftMargin;
+			float				fRightMargin;
+
+			// scratch space for drawing the series
+			int32				fSelected[kMaxForecastHours];
+			BPoint				fPoints[kMaxForecastHours + 2];
+};
+
+
+#endif // _FORECASTCHARTVIEW_H_
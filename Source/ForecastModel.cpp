@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "ForecastModel.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+
+ForecastModel::ForecastModel()
+	:
+	fDayBlock(NULL),
+	fDayCount(0),
+	fDayTimes(NULL),
+	fDayLows(NULL),
+	fDayHighs(NULL),
+	fDayCodes(NULL),
+	fHourBlock(NULL),
+	fHourCount(0),
+	fHourlyStart(0),
+	fHourlyTemperatures(NULL),
+	fHourlyFeelsLike(NULL),
+	fHourlyWinds(NULL),
+	fHourlyPrecipitation(NULL),
+	fHourlyCodes(NULL)
+{}
+
+
+ForecastModel::~ForecastModel()
+{
+	MakeEmpty();
+}
+
+
+void
+ForecastModel::MakeEmpty()
+{
+	SetDayCount(0);
+	SetHourCount(0, 0);
+}
+
+
+status_t
+ForecastModel::SetDayCount(int32 count)
+{
+	if (count < 0 || count > kMaxForecastDays)
+		return B_BAD_VALUE;
+
+	free(fDayBlock);
+	fDayBlock = NULL;
+	fDayCount = 0;
+	fDayTimes = NULL;
+	fDayLows = fDayHighs = NULL;
+	fDayCodes = NULL;
+
+	if (count == 0)
+		return B_OK;
+
+	// widest columns first so each one stays aligned
+	fDayBlock = malloc(count * (sizeof(time_t) + 2 * sizeof(float) + sizeof(int16)));
+	if (fDayBlock == NULL)
+		return B_NO_MEMORY;
+
+	fDayCount = count;
+	fDayTimes = static_cast<time_t*>(fDayBlock);
+	fDayLows = reinterpret_cast<float*>(fDayTimes + count);
+	fDayHighs = fDayLows + count;
+	fDayCodes = reinterpret_cast<int16*>(fDayHighs + count);
+
+	for (int32 x = 0; x < count; x++) {
+		fDayTimes[x] = 0;
+		fDayLows[x] = fDayHighs[x] = NAN;
+		fDayCodes[x] = kMissingValue;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+ForecastModel::SetHourCount(int32 count, time_t start)
+{
+	if (count < 0 || count > kMaxForecastHours)
+		return B_BAD_VALUE;
+
+	// keep the block when the size doesn't change, the hourly data is replaced on every refresh
+	if (count != fHourCount) {
+		free(fHourBlock);
+		fHourBlock = NULL;
+		fHourCount = 0;
+		fHourlyTemperatures = fHourlyFeelsLike = fHourlyWinds = NULL;
+		fHourlyPrecipitation = fHourlyCodes = NULL;
+
+		if (count > 0) {
+			fHourBlock = malloc(count * (3 * sizeof(float) + 2 * sizeof(int16)));
+			if (fHourBlock == NULL)
+				return B_NO_MEMORY;
+
+			fHourlyTemperatures = static_cast<float*>(fHourBlock);
+			fHourlyFeelsLike = fHourlyTemperatures + count;
+			fHourlyWinds = fHourlyFeelsLike + count;
+			fHourlyPrecipitation = reinterpret_cast<int16*>(fHourlyWinds + count);
+			fHourlyCodes = fHourlyPrecipitation + count;
+		}
+	}
+
+	fHourCount = count;
+	fHourlyStart = start;
+
+	for (int32 x = 0; x < count; x++) {
+		fHourlyTemperatures[x] = fHourlyFeelsLike[x] = fHourlyWinds[x] = NAN;
+		fHourlyPrecipitation[x] = fHourlyCodes[x] = kMissingValue;
+	}
+
+	return B_OK;
+}
+
+
+int32
+ForecastModel::HourIndex(time_t time) const
+{
+	if (fHourCount == 0 || time < fHourlyStart)
+		return -1;
+
+	int32 index = (time - fHourlyStart) / kHourlyInterval;
+	return index < fHourCount ? index : -1;
+}
+
+
+bool
+ForecastModel::GetRange(const float* column, int32 count, float& min, float& max)
+{
+	min = INFINITY;
+	max = -INFINITY;
+	for (int32 x = 0; x < count; x++) {
+		// NaN fails both comparisons, so missing values are skipped
+		if (column[x] < min)
+			min = column[x];
+		if (column[x] > max)
+			max = column[x];
+	}
+
+	return min <= max;
+}
+
+
+int16
+ForecastModel::MaxValue(const int16* column, int32 count)
+{
+	int16 max = kMissingValue;
+	for (int32 x = 0; x < count; x++) {
+		if (column[x] > max)
+			max = column[x];
+	}
+
+	return max;
+}
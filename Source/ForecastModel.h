@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _FORECASTMODEL_H_
+#define _FORECASTMODEL_H_
+
+
+#include <SupportDefs.h>
+#include <time.h>
+
+
+static const int32 kMaxForecastDays = 16;
+static const int32 kMaxForecastHours = kMaxForecastDays * 24;
+static const int32 kHourlyInterval = 3600;
+static const int16 kMissingValue = -32768; // marks missing entries in the int16 columns
+
+
+// Parts of a forecast that are converted from a reply separately, so only
+// what is shown has to be decoded.  The time of the current conditions is
+// always converted.
+enum forecast_field {
+	kForecastTemperature	= 0x0001,
+	kForecastFeelsLike		= 0x0002,
+	kForecastWeatherCode	= 0x0004,
+	kForecastHumidity		= 0x0008,
+	kForecastWind			= 0x0010,
+	kForecastCloudCover		= 0x0020,
+	kForecastTodayRange		= 0x0040,	// low and high of the first day
+	kForecastDaily			= 0x0080,
+	kForecastHourly			= 0x0100,
+	kForecastTime			= 0x0200,
+
+	kForecastCurrentFields	= 0x003f,
+	kForecastAllFields		= 0x03ff
+};
+
+
+// Forecast data stored column-wise.  Every column of a section lives in the
+// same allocation, and the hourly section has a single time base instead of a
+// time column.  Float columns use NaN for missing values.
+class ForecastModel {
+public:
+						ForecastModel();
+						~ForecastModel();
+
+			void		MakeEmpty();
+
+			status_t	SetDayCount(int32 count);
+			int32		CountDays() const { return fDayCount; }
+			time_t*		DayTimes() { return fDayTimes; }
+			float*		DayLows() { return fDayLows; }
+			float*		DayHighs() { return fDayHighs; }
+			int16*		DayCodes() { return fDayCodes; }
+			const time_t*	DayTimes() const { return fDayTimes; }
+			const float*	DayLows() const { return fDayLows; }
+			const float*	DayHighs() const { return fDayHighs; }
+			const int16*	DayCodes() const { return fDayCodes; }
+
+			status_t	SetHourCount(int32 count, time_t start);
+			int32		CountHours() const { return fHourCount; }
+			time_t		HourlyStart() const { return fHourlyStart; }
+			time_t		HourTime(int32 index) const { return fHourlyStart + (time_t)index * kHourlyInterval; }
+			int32		HourIndex(time_t time) const;
+			float*		HourlyTemperatures() { return fHourlyTemperatures; }
+			float*		HourlyFeelsLike() { return fHourlyFeelsLike; }
+			float*		HourlyWinds() { return fHourlyWinds; }
+			int16*		HourlyPrecipitation() { return fHourlyPrecipitation; }
+			int16*		HourlyCodes() { return fHourlyCodes; }
+			const float*	HourlyTemperatures() const { return fHourlyTemperatures; }
+			const float*	HourlyFeelsLike() const { return fHourlyFeelsLike; }
+			const float*	HourlyWinds() const { return fHourlyWinds; }
+			const int16*	HourlyPrecipitation() const { return fHourlyPrecipitation; }
+			const int16*	HourlyCodes() const { return fHourlyCodes; }
+
+	static	bool		GetRange(const float* column, int32 count, float& min, float& max);
+	static	int16		MaxValue(const int16* column, int32 count);
+
+private:
+						// the columns are owned, a copy would free them twice
+						ForecastModel(const ForecastModel&);
+			ForecastModel&	operator=(const ForecastModel&);
+
+			void*		fDayBlock;
+			int32		fDayCount;
+			time_t*		fDayTimes;
+			float*		fDayLows;
+			float*		fDayHighs;
+			int16*		fDayCodes;
+
+			void*		fHourBlock;
+			int32		fHourCount;
+			time_t		fHourlyStart;
+			float*		fHourlyTemperatures;
+			float*		fHourlyFeelsLike;
+			float*		fHourlyWinds;
+			int16*		fHourlyPrecipitation;
+			int16*		fHourlyCodes;
+};
+
+#endif // _FORECASTMODEL_H_
@@ -0,0 +1,735 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "ForecastParser.h"
+#include "ForecastModel.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// in the order of the parser's sections
+static const char* const kSectionNames[] = {
+	"current", "daily", "hourly"
+};
+
+enum {
+	kCurrentTime = 0,
+	kCurrentTemperature,
+	kCurrentApparentTemperature,
+	kCurrentHumidity,
+	kCurrentWindSpeed,
+	kCurrentWindDirection,
+	kCurrentCloudCover,
+	kCurrentWeatherCode,
+	kCurrentFieldCount
+};
+
+static const char* const kCurrentFields[kCurrentFieldCount] = {
+	"time", "temperature_2m", "apparent_temperature", "relative_humidity_2m", "wind_speed_10m",
+	"wind_direction_10m", "cloud_cover", "weathercode"
+};
+
+static const uint32 kCurrentFieldMasks[kCurrentFieldCount] = {
+	kForecastTime, kForecastTemperature, kForecastFeelsLike, kForecastHumidity, kForecastWind, kForecastWind,
+	kForecastCloudCover, kForecastWeatherCode
+};
+
+enum {
+	kDailyTime = 0,
+	kDailyLow,
+	kDailyHigh,
+	kDailyWeatherCode,
+	kDailyFieldCount
+};
+
+static const char* const kDailyFields[kDailyFieldCount] = {
+	"time", "temperature_2m_min", "temperature_2m_max", "weathercode"
+};
+
+enum {
+	kHourlyTime = 0,
+	kHourlyTemperature,
+	kHourlyPrecipitation,
+	kHourlyWindSpeed,
+	kHourlyWeatherCode,
+	kHourlyApparentTemperature,	// optional, replies saved before it was requested lack it
+	kHourlyFieldCount,
+	kHourlyRequiredCount = kHourlyApparentTemperature
+};
+
+static const char* const kHourlyFields[kHourlyFieldCount] = {
+	"time", "temperature_2m", "precipitation_probability", "wind_speed_10m", "weathercode", "apparent_temperature"
+};
+
+// powers of ten that are exact in each type
+static const float kFloatPowersOfTen[] = {
+	1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+static const double kDoublePowersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+struct json_number {
+	uint64		mantissa;
+	int32		exponent;
+	int32		digits;
+	bool		negative;
+};
+
+
+static inline const char*
+skip_space(const char* start, const char* end)
+{
+	while (start < end && (*start == ' ' || *start == '\n' || *start == '\r' || *start == '\t'))
+		start++;
+	return start;
+}
+
+
+static inline bool
+is_null(const char* start, const char* end)
+{
+	return *start == 'n' && end - start >= 4 && memcmp(start, "null", 4) == 0
+		&& skip_space(start + 4, end) == end;
+}
+
+
+static inline bool
+is_digit(char c)
+{
+	return static_cast<unsigned char>(c - '0') <= 9;
+}
+
+
+// Splits a number into its decimal mantissa and exponent.  When there are more
+// than 19 digits the mantissa has overflowed and must not be used.
+static inline bool
+decompose_number(const char*& start, const char* end, json_number& number)
+{
+	const char* c = start;
+	number.mantissa = 0;
+	number.exponent = 0;
+	number.negative = c < end && *c == '-';
+	if (number.negative)
+		c++;
+
+	const char* integerStart = c;
+	while (c < end && is_digit(*c))
+		number.mantissa = number.mantissa * 10 + (*c++ - '0');
+	number.digits = c - integerStart;
+	if (number.digits == 0)
+		return false;
+
+	if (c < end && *c == '.') {
+		const char* fractionStart = ++c;
+		while (c < end && is_digit(*c))
+			number.mantissa = number.mantissa * 10 + (*c++ - '0');
+		if (c == fractionStart)
+			return false;
+
+		number.exponent = fractionStart - c;
+		number.digits -= number.exponent;
+	}
+
+	if (c < end && (*c == 'e' || *c == 'E')) {
+		c++;
+		bool negative = false;
+		if (c < end && (*c == '-' || *c == '+'))
+			negative = *c++ == '-';
+
+		const char* exponentStart = c;
+		int32 exponent = 0;
+		while (c < end && is_digit(*c)) {
+			if (exponent < 100000)
+				exponent = exponent * 10 + (*c - '0');
+			c++;
+		}
+		if (c == exponentStart)
+			return false;
+
+		number.exponent += negative ? -exponent : exponent;
+	}
+
+	start = c;
+	return true;
+}
+
+
+// numbers outside of the fast path go through the C library
+static bool
+convert_number(const char* start, const char* end, double& value)
+{
+	char buffer[64];
+	size_t length = end - start;
+	if (length >= sizeof(buffer))
+		return false;
+
+	memcpy(buffer, start, length);
+	buffer[length] = '\0';
+	value = strtod(buffer, NULL);
+	return true;
+}
+
+
+static bool
+convert_number(const char* start, const char* end, float& value)
+{
+	char buffer[64];
+	size_t length = end - start;
+	if (length >= sizeof(buffer))
+		return false;
+
+	memcpy(buffer, start, length);
+	buffer[length] = '\0';
+	value = strtof(buffer, NULL);
+	return true;
+}
+
+
+// When the mantissa and the power of ten are both exact, a single multiplication
+// or division is correctly rounded, which covers almost every number in a reply.
+static bool
+parse_number(const char* start, const char* end, float& value)
+{
+	start = skip_space(start, end);
+	if (start == end)
+		return false;
+	if (is_null(start, end)) {
+		value = NAN;
+		return true;
+	}
+
+	json_number number;
+	const char* numberEnd = start;
+	if (!decompose_number(numberEnd, end, number) || skip_space(numberEnd, end) != end)
+		return false;
+
+	if (number.digits <= 19 && number.mantissa <= (1 << 24)
+		&& number.exponent >= -10 && number.exponent <= 10) {
+		float result = static_cast<float>(number.mantissa);
+		if (number.exponent < 0)
+			result /= kFloatPowersOfTen[-number.exponent];
+		else
+			result *= kFloatPowersOfTen[number.exponent];
+		value = number.negative ? -result : result;
+		return true;
+	}
+
+	return convert_number(start, numberEnd, value);
+}
+
+
+static bool
+parse_number(const char* start, const char* end, double& value)
+{
+	start = skip_space(start, end);
+	if (start == end)
+		return false;
+	if (is_null(start, end)) {
+		value = NAN;
+		return true;
+	}
+
+	json_number number;
+	const char* numberEnd = start;
+	if (!decompose_number(numberEnd, end, number) || skip_space(numberEnd, end) != end)
+		return false;
+
+	bool fast = number.digits <= 19 && number.mantissa <= (1ULL << 53)
+		&& number.exponent >= -22 && number.exponent <= 22;
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+	// with excess precision the result would be rounded twice
+	fast = fast && number.exponent == 0;
+#endif
+
+	if (fast) {
+		double result = static_cast<double>(number.mantissa);
+		if (number.exponent < 0)
+			result /= kDoublePowersOfTen[-number.exponent];
+		else
+			result *= kDoublePowersOfTen[number.exponent];
+		value = number.negative ? -result : result;
+		return true;
+	}
+
+	return convert_number(start, numberEnd, value);
+}
+
+
+static inline int16
+to_int16(float value)
+{
+	if (!(value >= -32767 && value <= 32767))
+		return kMissingValue; // also catches NaN
+
+	return static_cast<int16>(value);
+}
+
+
+static int32
+find_name(const char* const* names, int32 count, const char* key, int32 length)
+{
+	for (int32 x = 0; x < count; x++) {
+		if (strncmp(names[x], key, length) == 0 && names[x][length] == '\0')
+			return x;
+	}
+
+	return -1;
+}
+
+
+ForecastParser::ForecastParser()
+	:
+	fData(NULL),
+	fEnd(NULL),
+	fIndex(NULL),
+	fCount(0),
+	fPosition(0),
+	fDays(0),
+	fHourly(false),
+	fDecoded(0)
+{}
+
+
+status_t
+ForecastParser::Parse(const char* data, size_t length, int32 days, bool hourly, uint32 fields,
+	current_weather& current, ForecastModel& forecast)
+{
+	fData = NULL;
+	fDecoded = 0;
+	fDays = days < kMaxForecastDays ? days : kMaxForecastDays;
+	fHourly = hourly;
+
+	for (int32 section = 0; section < kSectionCount; section++) {
+		for (int32 x = 0; x < kMaxFieldCount; x++)
+			fValues[section][x] = -1;
+	}
+
+	status_t status = fScanner.Scan(data, length);
+	if (status != B_OK)
+		return status;
+
+	fData = data;
+	fEnd = data + length;
+	fIndex = fScanner.Index();
+	fCount = fScanner.CountIndex();
+
+	if (fCount < 2 || fData[fIndex[0]] != '{' || skip_space(fData, fData + fIndex[0]) != fData + fIndex[0])
+		status = B_BAD_DATA;
+
+	bool found[kSectionCount] = { false, false, false };
+	fPosition = 1;
+	bool done = status != B_OK;
+	if (!done && fData[fIndex[fPosition]] == '}') {
+		fPosition++;
+		done = true;
+	}
+
+	while (!done) {
+		if (fPosition + 3 >= fCount || fData[fIndex[fPosition]] != '"'
+			|| fData[fIndex[fPosition + 2]] != ':') {
+			status = B_BAD_DATA;
+			break;
+		}
+
+		int32 section = find_name(kSectionNames, kSectionCount, fData + fIndex[fPosition] + 1,
+			fIndex[fPosition + 1] - fIndex[fPosition] - 1);
+		fPosition += 3;
+
+		if (section == kSectionHourly && !hourly)
+			section = -1;
+
+		if (section < 0)
+			status = _SkipValue();
+		else {
+			static const char* const* kFields[kSectionCount] = {
+				kCurrentFields, kDailyFields, kHourlyFields
+			};
+			static const int32 kFieldCounts[kSectionCount] = {
+				kCurrentFieldCount, kDailyFieldCount, kHourlyFieldCount
+			};
+
+			status = _ReadObject(kFields[section], kFieldCounts[section], fValues[section]);
+			found[section] = true;
+		}
+
+		if (status != B_OK)
+			break;
+
+		if (fPosition >= fCount) {
+			status = B_BAD_DATA;
+			break;
+		}
+
+		char separator = fData[fIndex[fPosition++]];
+		if (separator == '}')
+			done = true;
+		else if (separator != ',')
+			status = B_BAD_DATA;
+	}
+
+	if (status == B_OK && (fPosition != fCount || skip_space(fData + fIndex[fCount - 1] + 1, fEnd) != fEnd))
+		status = B_BAD_DATA;
+
+	// a reply asked for no days has no daily forecast
+	if (status == B_OK && (!found[kSectionCurrent] || (!found[kSectionDaily] && fDays > 0)))
+		status = B_BAD_DATA;
+
+	if (status != B_OK) {
+		fData = NULL;
+		return status;
+	}
+
+	// only a reply that looks right replaces the last one, nothing of it may be
+	// left over in columns that aren't converted
+	current.time = 0;
+	current.temperature = current.apparentTemperature = current.humidity = NAN;
+	current.windSpeed = current.windDirection = current.cloudCover = NAN;
+	current.lowTemperature = current.highTemperature = NAN;
+	current.weatherCode = kMissingValue;
+
+	forecast.SetDayCount(0);
+	forecast.SetHourCount(0, 0);
+
+	return Decode(fields | kForecastTime, current, forecast);
+}
+
+
+// converts the fields that weren't converted yet
+status_t
+ForecastParser::Decode(uint32 fields, current_weather& current, ForecastModel& forecast)
+{
+	if (fData == NULL)
+		return B_NO_INIT;
+
+	uint32 missing = fields & ~fDecoded;
+	if (missing == 0)
+		return B_OK;
+
+	status_t status = _DecodeCurrent(missing, current);
+	if (status == B_OK && (missing & kForecastTodayRange) != 0)
+		status = _DecodeTodayRange(current);
+	if (status == B_OK && (missing & kForecastDaily) != 0)
+		status = _DecodeDaily(forecast);
+
+	// the rest of the forecast is still usable without hourly data
+	if (status == B_OK && (missing & kForecastHourly) != 0 && _DecodeHourly(forecast) != B_OK)
+		forecast.SetHourCount(0, 0);
+
+	if (status != B_OK)
+		return status;
+
+	fDecoded |= missing;
+	return B_OK;
+}
+
+
+// records where the value of each named member starts and skips over the rest
+status_t
+ForecastParser::_ReadObject(const char* const* names, int32 nameCount, int32* values)
+{
+	if (fPosition >= fCount || fData[fIndex[fPosition]] != '{')
+		return B_BAD_DATA;
+
+	fPosition++;
+	if (fPosition < fCount && fData[fIndex[fPosition]] == '}') {
+		fPosition++;
+		return B_OK;
+	}
+
+	while (true) {
+		if (fPosition + 3 >= fCount || fData[fIndex[fPosition]] != '"'
+			|| fData[fIndex[fPosition + 2]] != ':')
+			return B_BAD_DATA;
+
+		int32 field = find_name(names, nameCount, fData + fIndex[fPosition] + 1,
+			fIndex[fPosition + 1] - fIndex[fPosition] - 1);
+		fPosition += 3;
+		if (field >= 0)
+			values[field] = fPosition - 1;
+
+		status_t status = _SkipValue();
+		if (status != B_OK)
+			return status;
+
+		if (fPosition >= fCount)
+			return B_BAD_DATA;
+
+		char separator = fData[fIndex[fPosition++]];
+		if (separator == '}')
+			return B_OK;
+		if (separator != ',')
+			return B_BAD_DATA;
+	}
+}
+
+
+// steps over the value following the entry before fPosition
+status_t
+ForecastParser::_SkipValue()
+{
+	const char* start = _ValueStart(fPosition - 1);
+	if (start >= fEnd)
+		return B_BAD_DATA;
+
+	switch (*start) {
+		case '"':
+			fPosition += 2;
+			return B_OK;
+		case '{':
+		case '[':
+			break;
+		default:
+			// scalars have no entries
+			return B_OK;
+	}
+
+	int32 depth = 0;
+	do {
+		if (fPosition >= fCount)
+			return B_BAD_DATA;
+
+		switch (fData[fIndex[fPosition++]]) {
+			case '{':
+			case '[':
+				depth++;
+				break;
+			case '}':
+			case ']':
+				depth--;
+				break;
+		}
+	} while (depth > 0);
+
+	return B_OK;
+}
+
+
+// only arrays of scalars are supported, so the elements are separated by commas alone
+status_t
+ForecastParser::_ArrayLength(int32 open, int32& length)
+{
+	if (open >= fCount || fData[fIndex[open]] != '[')
+		return B_BAD_DATA;
+
+	int32 close = open + 1;
+	while (close < fCount && fData[fIndex[close]] == ',')
+		close++;
+
+	if (close >= fCount || fData[fIndex[close]] != ']')
+		return B_BAD_DATA;
+
+	length = close - open;
+	if (length == 1 && skip_space(_ElementStart(open, 0), _ElementEnd(open, 0)) == _ElementEnd(open, 0))
+		length = 0;
+
+	return B_OK;
+}
+
+
+const char*
+ForecastParser::_ValueStart(int32 value)
+{
+	return skip_space(fData + fIndex[value] + 1, fEnd);
+}
+
+
+const char*
+ForecastParser::_ElementStart(int32 open, int32 element)
+{
+	return fData + fIndex[open + element] + 1;
+}
+
+
+const char*
+ForecastParser::_ElementEnd(int32 open, int32 element)
+{
+	return fData + fIndex[open + element + 1];
+}
+
+
+status_t
+ForecastParser::_SectionLength(const int32* values, int32 fieldCount, int32& length)
+{
+	// every array of a section must have the same length
+	for (int32 x = 0; x < fieldCount; x++) {
+		int32 fieldLength;
+		if (values[x] < 0 || _ArrayLength(values[x] + 1, fieldLength) != B_OK)
+			return B_BAD_DATA;
+		if (x == 0)
+			length = fieldLength;
+		else if (fieldLength != length)
+			return B_BAD_DATA;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+ForecastParser::_DecodeCurrent(uint32 fields, current_weather& current)
+{
+	const int32* values = fValues[kSectionCurrent];
+	float* columns[kCurrentFieldCount] = {
+		NULL, &current.temperature, &current.apparentTemperature, &current.humidity,
+		&current.windSpeed, &current.windDirection, &current.cloudCover, NULL
+	};
+
+	for (int32 x = 0; x < kCurrentFieldCount; x++) {
+		if ((fields & kCurrentFieldMasks[x]) == 0 || values[x] < 0)
+			continue;
+
+		// a scalar ends at the entry following its colon
+		const char* start = _ValueStart(values[x]);
+		const char* end = fData + fIndex[values[x] + 1];
+
+		if (x == kCurrentTime) {
+			double time;
+			if (!parse_number(start, end, time))
+				return B_BAD_DATA;
+			current.time = isnan(time) ? 0 : static_cast<time_t>(time);
+		} else if (x == kCurrentWeatherCode) {
+			float code;
+			if (!parse_number(start, end, code))
+				return B_BAD_DATA;
+			current.weatherCode = to_int16(code);
+		} else if (!parse_number(start, end, *columns[x]))
+			return B_BAD_DATA;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+ForecastParser::_DecodeTodayRange(current_weather& current)
+{
+	const int32* values = fValues[kSectionDaily];
+	if (fDays == 0 && values[kDailyTime] < 0)
+		return B_OK;
+
+	int32 count;
+	if (_SectionLength(values, kDailyFieldCount, count) != B_OK)
+		return B_BAD_DATA;
+
+	if (count == 0)
+		return B_OK;
+
+	int32 lows = values[kDailyLow] + 1;
+	int32 highs = values[kDailyHigh] + 1;
+	if (!parse_number(_ElementStart(lows, 0), _ElementEnd(lows, 0), current.lowTemperature)
+		|| !parse_number(_ElementStart(highs, 0), _ElementEnd(highs, 0), current.highTemperature))
+		return B_BAD_DATA;
+
+	return B_OK;
+}
+
+
+status_t
+ForecastParser::_DecodeDaily(ForecastModel& forecast)
+{
+	const int32* values = fValues[kSectionDaily];
+	if (fDays == 0 && values[kDailyTime] < 0)
+		return forecast.SetDayCount(0);
+
+	int32 count;
+	if (_SectionLength(values, kDailyFieldCount, count) != B_OK)
+		return B_BAD_DATA;
+
+	if (count > fDays)
+		count = fDays > 0 ? fDays : 0;
+
+	if (forecast.SetDayCount(count) != B_OK)
+		return B_NO_MEMORY;
+
+	int32 times = values[kDailyTime] + 1;
+	time_t* timeColumn = forecast.DayTimes();
+	for (int32 x = 0; x < count; x++) {
+		double time;
+		if (!parse_number(_ElementStart(times, x), _ElementEnd(times, x), time))
+			return B_BAD_DATA;
+		timeColumn[x] = isnan(time) ? 0 : static_cast<time_t>(time);
+	}
+
+	if (_ReadColumn(values[kDailyLow] + 1, count, forecast.DayLows()) != B_OK
+		|| _ReadColumn(values[kDailyHigh] + 1, count, forecast.DayHighs()) != B_OK
+		|| _ReadColumn(values[kDailyWeatherCode] + 1, count, forecast.DayCodes()) != B_OK)
+		return B_BAD_DATA;
+
+	return B_OK;
+}
+
+
+status_t
+ForecastParser::_DecodeHourly(ForecastModel& forecast)
+{
+	const int32* values = fValues[kSectionHourly];
+	int32 count;
+	if (!fHourly || _SectionLength(values, kHourlyRequiredCount, count) != B_OK)
+		return B_BAD_DATA;
+
+	int32 feelsLikeCount;
+	int32 feelsLike = values[kHourlyApparentTemperature];
+	if (feelsLike >= 0 && (_ArrayLength(feelsLike + 1, feelsLikeCount) != B_OK || feelsLikeCount != count))
+		return B_BAD_DATA;
+
+	if (count > kMaxForecastHours)
+		count = kMaxForecastHours;
+
+	int32 times = values[kHourlyTime] + 1;
+	double start = 0;
+	if (count > 0 && (!parse_number(_ElementStart(times, 0), _ElementEnd(times, 0), start) || isnan(start)))
+		return B_BAD_DATA;
+
+	if (forecast.SetHourCount(count, static_cast<time_t>(start)) != B_OK)
+		return B_NO_MEMORY;
+
+	// the model has no time column, so the hours must be evenly spaced
+	for (int32 x = 1; x < count; x++) {
+		double time;
+		if (!parse_number(_ElementStart(times, x), _ElementEnd(times, x), time)
+			|| time != static_cast<double>(forecast.HourTime(x)))
+			return B_BAD_DATA;
+	}
+
+	if (_ReadColumn(values[kHourlyTemperature] + 1, count, forecast.HourlyTemperatures()) != B_OK
+		|| _ReadColumn(values[kHourlyPrecipitation] + 1, count, forecast.HourlyPrecipitation()) != B_OK
+		|| _ReadColumn(values[kHourlyWindSpeed] + 1, count, forecast.HourlyWinds()) != B_OK
+		|| _ReadColumn(values[kHourlyWeatherCode] + 1, count, forecast.HourlyCodes()) != B_OK
+		|| (feelsLike >= 0 && _ReadColumn(feelsLike + 1, count, forecast.HourlyFeelsLike()) != B_OK))
+		return B_BAD_DATA;
+
+	return B_OK;
+}
+
+
+status_t
+ForecastParser::_ReadColumn(int32 open, int32 count, float* column)
+{
+	for (int32 x = 0; x < count; x++) {
+		if (!parse_number(_ElementStart(open, x), _ElementEnd(open, x), column[x]))
+			return B_BAD_DATA;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+ForecastParser::_ReadColumn(int32 open, int32 count, int16* column)
+{
+	for (int32 x = 0; x < count; x++) {
+		float value;
+		if (!parse_number(_ElementStart(open, x), _ElementEnd(open, x), value))
+			return B_BAD_DATA;
+		column[x] = to_int16(value);
+	}
+
+	return B_OK;
+}
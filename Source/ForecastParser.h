@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _FORECASTPARSER_H_
+#define _FORECASTPARSER_H_
+
+
+#include "JsonScanner.h"
+
+#include <time.h>
+
+
+class ForecastModel;
+
+
+// current conditions as they are in the reply, missing values are NaN
+struct current_weather {
+	time_t	time;
+	float	temperature;
+	float	apparentTemperature;
+	float	humidity;
+	float	windSpeed;
+	float	windDirection;
+	float	cloudCover;
+	float	lowTemperature;		// from the first forecast day
+	float	highTemperature;
+	int16	weatherCode;
+};
+
+
+// Reads an Open-Meteo forecast reply straight into a ForecastModel.  Parse()
+// only locates the members of the reply, and just the requested fields are
+// converted.  Other fields can be converted later with Decode() as long as
+// the reply data stays untouched.  Everything else is stepped over using the
+// structural index.
+class ForecastParser {
+public:
+							ForecastParser();
+
+			JsonScanner&	Scanner() { return fScanner; }
+
+			status_t		Parse(const char* data, size_t length, int32 days, bool hourly, uint32 fields,
+								current_weather& current, ForecastModel& forecast);
+			status_t		Decode(uint32 fields, current_weather& current, ForecastModel& forecast);
+			uint32			DecodedFields() const { return fDecoded; }
+
+private:
+	enum {
+		kSectionCurrent = 0,
+		kSectionDaily,
+		kSectionHourly,
+		kSectionCount
+	};
+
+	enum {
+		kMaxFieldCount = 8
+	};
+
+			status_t		_ReadObject(const char* const* names, int32 nameCount, int32* values);
+			status_t		_SkipValue();
+			status_t		_ArrayLength(int32 open, int32& length);
+			status_t		_SectionLength(const int32* values, int32 fieldCount, int32& length);
+			const char*		_ValueStart(int32 value);
+			const char*		_ElementStart(int32 open, int32 element);
+			const char*		_ElementEnd(int32 open, int32 element);
+
+			status_t		_DecodeCurrent(uint32 fields, current_weather& current);
+			status_t		_DecodeTodayRange(current_weather& current);
+			status_t		_DecodeDaily(ForecastModel& forecast);
+			status_t		_DecodeHourly(ForecastModel& forecast);
+			status_t		_ReadColumn(int32 open, int32 count, float* column);
+			status_t		_ReadColumn(int32 open, int32 count, int16* column);
+
+			JsonScanner		fScanner;
+			const char*		fData;
+			const char*		fEnd;
+			const uint32*	fIndex;
+			int32			fCount;
+			int32			fPosition;
+
+			// the entry of the colon in front of each member, -1 when it is missing
+			int32			fValues[kSectionCount][kMaxFieldCount];
+			int32			fDays;
+			bool			fHourly;
+			uint32			fDecoded;
+};
+
+#endif // _FORECASTPARSER_H_
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "ForecastSnapshot.h"
+
+#include <string.h>
+
+
+void
+build_forecast_snapshot(forecast_snapshot& snapshot, const Condition& current, const ForecastModel& forecast,
+	bool imperial)
+{
+	snapshot.current = current;
+	snapshot.imperial = imperial;
+	snapshot.dayCount = forecast.CountDays() < kMaxForecastDays ? forecast.CountDays() : kMaxForecastDays;
+
+	for (int32 x = 0; x < snapshot.dayCount; x++) {
+		Condition& day = snapshot.days[x];
+		day = Condition(forecast, x);
+
+		// chance of rain is the highest hourly probability for the rest of the day
+		snapshot.rain[x] = kMissingValue;
+		time_t from = day.Day() > forecast.HourlyStart() ? day.Day() : forecast.HourlyStart();
+		int32 firstHour = forecast.HourIndex(from);
+		if (firstHour >= 0) {
+			int32 hours = (day.Day() + 24 * kHourlyInterval - from) / kHourlyInterval;
+			if (hours > forecast.CountHours() - firstHour)
+				hours = forecast.CountHours() - firstHour;
+
+			snapshot.rain[x] = ForecastModel::MaxValue(forecast.HourlyPrecipitation() + firstHour, hours);
+		}
+	}
+
+	snapshot.hourCount = forecast.CountHours() < kMaxForecastHours ? forecast.CountHours() : kMaxForecastHours;
+	snapshot.hourlyStart = forecast.HourlyStart();
+	if (snapshot.hourCount > 0) {
+		memcpy(snapshot.hourlyTemps, forecast.HourlyTemperatures(), snapshot.hourCount * sizeof(float));
+		memcpy(snapshot.hourlyFeelsLike, forecast.HourlyFeelsLike(), snapshot.hourCount * sizeof(float));
+		memcpy(snapshot.hourlyRain, forecast.HourlyPrecipitation(), snapshot.hourCount * sizeof(int16));
+		memcpy(snapshot.hourlyCodes, forecast.HourlyCodes(), snapshot.hourCount * sizeof(int16));
+	}
+}
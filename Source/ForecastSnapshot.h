@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _FORECASTSNAPSHOT_H_
+#define _FORECASTSNAPSHOT_H_
+
+
+#include "Condition.h"
+#include "ForecastModel.h"
+
+
+// Everything the forecast window shows.  It only holds plain values, so it
+// can be copied into a message as it is and compared field by field with the
+// snapshot that is shown already.
+struct forecast_snapshot {
+	Condition	current;		// the day is the time of the update
+	bool		imperial;
+	int32		dayCount;
+	Condition	days[kMaxForecastDays];
+	int16		rain[kMaxForecastDays];	// the highest hourly chance for the rest of the day, or kMissingValue
+
+	int32		hourCount;
+	time_t		hourlyStart;
+	float		hourlyTemps[kMaxForecastHours];	// NaN when missing
+	float		hourlyFeelsLike[kMaxForecastHours];
+	int16		hourlyRain[kMaxForecastHours];
+	int16		hourlyCodes[kMaxForecastHours];
+};
+
+
+void	build_forecast_snapshot(forecast_snapshot& snapshot, const Condition& current,
+			const ForecastModel& forecast, bool imperial);
+
+#endif // _FORECASTSNAPSHOT_H_
@@ -0,0 +1,469 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "ForecastStripView.h"
+#include "IconCache.h"
+#include "Trace.h"
+#include "WeatherCode.h"
+
+#include <Bitmap.h>
+#include <LayoutUtils.h>
+#include <ScrollBar.h>
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+
+static const int32 kDailyCells = 7;
+static const int32 kHourlyCells = 12;
+
+// a wednesday with a two digit month and day, for the widest date
+static const time_t kSampleDate = 1640736000;
+
+
+ForecastStripView::ForecastStripView(const char* name, bool compact)
+	:
+	BView(name, B_WILL_DRAW | B_FRAME_EVENTS),
+	fHasSnapshot(false),
+	fMode(kStripDaily),
+	fCompact(compact),
+	fCellWidth(0),
+	fCellHeight(0),
+	fLineHeight(0),
+	fAscent(0),
+	fInset(0),
+	fIconLogicalSize(0),
+	fIconSize(0)
+{
+	fDayFormat.SetDateTimeFormat(B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT, B_DATE_ELEMENT_WEEKDAY | B_DATE_ELEMENT_MONTH | B_DATE_ELEMENT_DAY);
+	fWeekdayFormat.SetDateTimeFormat(B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT, B_DATE_ELEMENT_WEEKDAY);
+
+	fSnapshot.dayCount = 0;
+	fSnapshot.hourCount = 0;
+	for (int32 x = 0; x < kStripCellCache; x++) {
+		fCells[x].index = -1;
+		fCells[x].icon = NULL;
+		fCells[x].startsDay = false;
+	}
+
+	SetViewUIColor(B_PANEL_BACKGROUND_COLOR);
+	SetLowUIColor(B_PANEL_BACKGROUND_COLOR);
+	SetHighUIColor(B_PANEL_TEXT_COLOR);
+
+	_UpdateMetrics();
+}
+
+
+ForecastStripView::~ForecastStripView()
+{
+}
+
+
+void
+ForecastStripView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+
+	// the font might be a different one now
+	_UpdateMetrics();
+	_UpdateScrollBar();
+}
+
+
+void
+ForecastStripView::Draw(BRect updateRect)
+{
+	TRACE_SCOPE("ForecastStripView::Draw");
+	int32 count = CountCells();
+	if (count == 0 || fCellWidth <= 0)
+		return;
+
+	// only the cells that intersect the update rect
+	int32 first = static_cast<int32>(floorf(updateRect.left / fCellWidth));
+	int32 last = static_cast<int32>(floorf(updateRect.right / fCellWidth));
+	if (first < 0)
+		first = 0;
+	if (last >= count)
+		last = count - 1;
+
+	SetDrawingMode(B_OP_OVER);
+	rgb_color separator = tint_color(ViewColor(), B_DARKEN_1_TINT);
+	rgb_color daySeparator = tint_color(ViewColor(), B_DARKEN_3_TINT);
+
+	for (int32 index = first; index <= last; index++) {
+		cell& slot = _Cell(index);
+		BRect frame = _CellFrame(index);
+
+		float y = frame.top + fInset + fAscent;
+		_DrawString(slot.title, y, frame);
+		y += fLineHeight;
+		if (fMode == kStripHourly) {
+			_DrawString(slot.subtitle, y, frame);
+			y += fLineHeight;
+		}
+
+		if (slot.icon != NULL) {
+			// the cache might only have another resolution for now
+			BRect iconFrame(0, 0, fIconSize, fIconSize);
+			iconFrame.OffsetTo(floorf(frame.left + (frame.Width() - fIconSize) / 2), y - fAscent + fInset);
+			SetDrawingMode(B_OP_ALPHA);
+			DrawBitmap(slot.icon, slot.icon->Bounds(), iconFrame, B_FILTER_BITMAP_BILINEAR);
+			SetDrawingMode(B_OP_OVER);
+		}
+		y += fIconSize + fInset * 2;
+
+		if (fMode == kStripDaily) {
+			_DrawString(slot.condition, y, frame);
+			y += fLineHeight;
+		}
+
+		for (int32 x = 0; x < (fMode == kStripDaily ? 3 : 2); x++) {
+			_DrawString(slot.values[x], y, frame);
+			y += fLineHeight;
+		}
+
+		if (index > 0) {
+			SetHighColor(slot.startsDay ? daySeparator : separator);
+			StrokeLine(BPoint(frame.left, frame.top + fInset), BPoint(frame.left, frame.bottom - fInset));
+			SetHighUIColor(B_PANEL_TEXT_COLOR);
+		}
+	}
+}
+
+
+void
+ForecastStripView::FrameResized(float width, float height)
+{
+	BView::FrameResized(width, height);
+	_UpdateScrollBar();
+}
+
+
+void
+ForecastStripView::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case B_MOUSE_WHEEL_CHANGED:
+		{
+			// there's only a horizontal scroll bar, so the wheel moves that one
+			BScrollBar* scrollBar = ScrollBar(B_HORIZONTAL);
+			float delta = message->GetFloat("be:wheel_delta_x", 0);
+			if (delta == 0)
+				delta = message->GetFloat("be:wheel_delta_y", 0);
+
+			if (scrollBar != NULL && delta != 0) {
+				float smallStep, largeStep;
+				scrollBar->GetSteps(&smallStep, &largeStep);
+				scrollBar->SetValue(scrollBar->Value() + delta * smallStep * 3);
+			}
+			break;
+		}
+		default:
+			BView::MessageReceived(message);
+	}
+}
+
+
+BSize
+ForecastStripView::MinSize()
+{
+	return BLayoutUtils::ComposeSize(ExplicitMinSize(), BSize(2 * fCellWidth - 1, fCellHeight - 1));
+}
+
+
+BSize
+ForecastStripView::MaxSize()
+{
+	int32 cells = CountCells() > 2 ? CountCells() : 2;
+	return BLayoutUtils::ComposeSize(ExplicitMaxSize(), BSize(cells * fCellWidth - 1, fCellHeight - 1));
+}
+
+
+BSize
+ForecastStripView::PreferredSize()
+{
+	int32 cells = fMode == kStripDaily ? kDailyCells : kHourlyCells;
+	if (CountCells() < cells)
+		cells = CountCells() > 2 ? CountCells() : 2;
+
+	return BLayoutUtils::ComposeSize(ExplicitPreferredSize(), BSize(cells * fCellWidth - 1, fCellHeight - 1));
+}
+
+
+void
+ForecastStripView::SetSnapshot(forecast_snapshot& snapshot)
+{
+	TRACE_SCOPE("ForecastStripView::SetSnapshot");
+	bool all = !fHasSnapshot;
+	int32 count = CountCells();
+
+	if (fMode == kStripDaily) {
+		if (snapshot.dayCount != fSnapshot.dayCount)
+			all = true;
+
+		for (int32 x = 0; x < snapshot.dayCount && !all; x++) {
+			if (_DayChanged(snapshot, x))
+				_InvalidateCell(x);
+		}
+	} else {
+		if (snapshot.hourCount != fSnapshot.hourCount || snapshot.hourlyStart != fSnapshot.hourlyStart)
+			all = true;
+
+		for (int32 x = 0; x < snapshot.hourCount && !all; x++) {
+			if (_HourChanged(snapshot, x))
+				_InvalidateCell(x);
+		}
+	}
+
+	fSnapshot = snapshot;
+	fHasSnapshot = true;
+
+	if (!all)
+		return;
+
+	for (int32 x = 0; x < kStripCellCache; x++)
+		fCells[x].index = -1;
+
+	if (CountCells() != count) {
+		InvalidateLayout();
+		_UpdateScrollBar();
+	}
+	Invalidate();
+}
+
+
+void
+ForecastStripView::SetMode(strip_mode mode)
+{
+	if (mode == fMode)
+		return;
+
+	fMode = mode;
+	_UpdateMetrics();
+
+	ScrollTo(0, 0);
+	InvalidateLayout();
+	_UpdateScrollBar();
+	Invalidate();
+}
+
+
+int32
+ForecastStripView::CountCells() const
+{
+	if (!fHasSnapshot)
+		return 0;
+
+	return fMode == kStripDaily ? fSnapshot.dayCount : fSnapshot.hourCount;
+}
+
+
+void
+ForecastStripView::ReloadIcons()
+{
+	_UpdateMetrics();
+	_UpdateScrollBar();
+	InvalidateLayout();
+	Invalidate();
+}
+
+
+// the cells are as wide as the widest texts they can show, longer condition
+// texts are truncated
+void
+ForecastStripView::_UpdateMetrics()
+{
+	font_height height;
+	GetFontHeight(&height);
+	fAscent = ceilf(height.ascent);
+	fLineHeight = ceilf(height.ascent + height.descent + height.leading);
+	fInset = ceilf(fLineHeight / (fCompact ? 4 : 2));
+
+	BString sample;
+	float width;
+	if (fMode == kStripDaily) {
+		fIconLogicalSize = fCompact ? kStripCompactDayIconSize : kStripDayIconSize;
+		fIconSize = IconCache::Default()->PhysicalSize(fIconLogicalSize);
+
+		fDayFormat.Format(sample, kSampleDate, B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT);
+		width = StringWidth(sample);
+		width = max_c(width, StringWidth("Partly cloudy"));
+		width = max_c(width, StringWidth("High: -888°"));
+		width = max_c(width, StringWidth("Rain: 100%"));
+
+		// title, condition and three values
+		fCellHeight = fLineHeight * 5 + fIconSize + fInset * 4;
+	} else {
+		fIconLogicalSize = fCompact ? kStripCompactHourIconSize : kStripHourIconSize;
+		fIconSize = IconCache::Default()->PhysicalSize(fIconLogicalSize);
+
+		fWeekdayFormat.Format(sample, kSampleDate, B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT);
+		width = StringWidth(sample);
+		sample.Truncate(0);
+		fHourFormat.Format(sample, kSampleDate + 23 * kHourlyInterval, B_SHORT_TIME_FORMAT);
+		width = max_c(width, StringWidth(sample));
+		width = max_c(width, StringWidth("-888°"));
+		width = max_c(width, StringWidth("100%"));
+
+		// title, time and two values
+		fCellHeight = fLineHeight * 4 + fIconSize + fInset * 4;
+	}
+
+	fCellWidth = ceilf(max_c(width, fIconSize) + fInset * 2);
+
+	// the texts were fitted to the old cells, and the icons have a new size
+	for (int32 x = 0; x < kStripCellCache; x++)
+		fCells[x].index = -1;
+}
+
+
+void
+ForecastStripView::_UpdateScrollBar()
+{
+	BScrollBar* scrollBar = ScrollBar(B_HORIZONTAL);
+	if (scrollBar == NULL)
+		return;
+
+	float total = CountCells() * fCellWidth;
+	float visible = Bounds().Width() + 1;
+	if (total <= visible) {
+		scrollBar->SetRange(0, 0);
+		scrollBar->SetProportion(1);
+		return;
+	}
+
+	scrollBar->SetRange(0, total - visible);
+	scrollBar->SetProportion(visible / total);
+	// small steps of a few pixels keep scrolling smooth
+	scrollBar->SetSteps(ceilf(fCellWidth / 8), max_c(visible - fCellWidth, fCellWidth));
+}
+
+
+BRect
+ForecastStripView::_CellFrame(int32 index) const
+{
+	return BRect(index * fCellWidth, 0, (index + 1) * fCellWidth - 1, fCellHeight - 1);
+}
+
+
+// the slot of a cell is reused by whatever cell needs it next
+ForecastStripView::cell&
+ForecastStripView::_Cell(int32 index)
+{
+	cell& slot = fCells[index % kStripCellCache];
+	if (slot.index != index) {
+		_FillCell(slot, index);
+		slot.index = index;
+	}
+
+	return slot;
+}
+
+
+void
+ForecastStripView::_FillCell(cell& slot, int32 index)
+{
+	slot.title.Truncate(0);
+	slot.subtitle.Truncate(0);
+	slot.condition.Truncate(0);
+	for (int32 x = 0; x < 3; x++)
+		slot.values[x].Truncate(0);
+
+	if (fMode == kStripDaily) {
+		Condition& day = fSnapshot.days[index];
+		fDayFormat.Format(slot.title, day.Day(), B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT);
+
+		slot.condition = day.Forecast();
+		TruncateString(&slot.condition, B_TRUNCATE_END, fCellWidth - fInset * 2);
+
+		slot.values[0] = "High: -";
+		if (!Condition::IsMissing(day.High()))
+			slot.values[0].SetToFormat("High: %" B_PRId32 "°", day.iHigh());
+		slot.values[1] = "Low: -";
+		if (!Condition::IsMissing(day.Low()))
+			slot.values[1].SetToFormat("Low: %" B_PRId32 "°", day.iLow());
+		if (fSnapshot.rain[index] != kMissingValue)
+			slot.values[2].SetToFormat("Rain: %d%%", fSnapshot.rain[index]);
+		else
+			slot.values[2] = "Rain: -";
+
+		slot.icon = _Icon(day.Icon());
+		slot.startsDay = false;
+		return;
+	}
+
+	time_t time = fSnapshot.hourlyStart + static_cast<time_t>(index) * kHourlyInterval;
+	struct tm local;
+	localtime_r(&time, &local);
+	slot.startsDay = local.tm_hour == 0;
+
+	// the day is only shown where it begins
+	if (index == 0 || slot.startsDay)
+		fWeekdayFormat.Format(slot.title, time, B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT);
+	fHourFormat.Format(slot.subtitle, time, B_SHORT_TIME_FORMAT);
+
+	float temp = fSnapshot.hourlyTemps[index];
+	if (isnan(temp))
+		slot.values[0] = "-";
+	else
+		slot.values[0].SetToFormat("%.0f°", temp);
+
+	if (fSnapshot.hourlyRain[index] != kMissingValue)
+		slot.values[1].SetToFormat("%d%%", fSnapshot.hourlyRain[index]);
+	else
+		slot.values[1] = "-";
+
+	slot.icon = _Icon(weather_code_icon(to_weather_code(fSnapshot.hourlyCodes[index])));
+}
+
+
+void
+ForecastStripView::_InvalidateCell(int32 index)
+{
+	cell& slot = fCells[index % kStripCellCache];
+	if (slot.index == index)
+		slot.index = -1;
+
+	Invalidate(_CellFrame(index));
+}
+
+
+bool
+ForecastStripView::_DayChanged(forecast_snapshot& snapshot, int32 index)
+{
+	Condition& day = snapshot.days[index];
+	Condition& shown = fSnapshot.days[index];
+
+	return day.Day() != shown.Day() || day.WeatherCode() != shown.WeatherCode() || day.iHigh() != shown.iHigh()
+		|| day.iLow() != shown.iLow() || snapshot.rain[index] != fSnapshot.rain[index];
+}
+
+
+bool
+ForecastStripView::_HourChanged(const forecast_snapshot& snapshot, int32 index) const
+{
+	// compared bitwise, so missing values are equal
+	return memcmp(&snapshot.hourlyTemps[index], &fSnapshot.hourlyTemps[index], sizeof(float)) != 0
+		|| snapshot.hourlyRain[index] != fSnapshot.hourlyRain[index]
+		|| snapshot.hourlyCodes[index] != fSnapshot.hourlyCodes[index];
+}
+
+
+// all cells with the same condition share one bitmap
+BBitmap*
+ForecastStripView::_Icon(const char* name)
+{
+	return IconCache::Default()->Get(name, fIconLogicalSize);
+}
+
+
+void
+ForecastStripView::_DrawString(const char* text, float y, const BRect& frame)
+{
+	if (text[0] == '\0')
+		return;
+
+	float left = floorf(frame.left + (frame.Width() + 1 - StringWidth(text)) / 2);
+	DrawString(text, BPoint(left, y));
+}
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _FORECASTSTRIPVIEW_H_
+#define _FORECASTSTRIPVIEW_H_
+
+
+#include <DateTimeFormat.h>
+#include <String.h>
+#include <TimeFormat.h>
+#include <View.h>
+
+#include "ForecastSnapshot.h"
+
+class BBitmap;
+
+
+enum strip_mode {
+	kStripDaily,
+	kStripHourly
+};
+
+static const int32 kStripCellCache = 48;	// more than fit on any screen
+
+// the logical sizes of the icons in a cell
+static const float kStripDayIconSize = 48;
+static const float kStripCompactDayIconSize = 36;
+static const float kStripHourIconSize = 32;
+static const float kStripCompactHourIconSize = 24;
+
+
+// Draws the days or hours of a forecast as a row of cells, straight from the
+// snapshot.  Only the cells in the update rect are drawn, so a frame costs the
+// same for 3 days or 16 days of hourly data.  The texts of a cell are
+// formatted once and kept in a slot until another cell needs it, the icons
+// come from the shared icon cache.  Scrolls horizontally inside a BScrollView.
+class ForecastStripView : public BView {
+public:
+								ForecastStripView(const char* name, bool compact);
+	virtual						~ForecastStripView();
+
+	virtual	void				AttachedToWindow();
+	virtual	void				Draw(BRect updateRect);
+	virtual	void				FrameResized(float width, float height);
+	virtual	void				MessageReceived(BMessage* message);
+
+	virtual	BSize				MinSize();
+	virtual	BSize				MaxSize();
+	virtual	BSize				PreferredSize();
+
+			// invalidates only the cells that changed
+			void				SetSnapshot(forecast_snapshot& snapshot);
+
+			void				SetMode(strip_mode mode);
+			strip_mode			Mode() const { return fMode; }
+			int32				CountCells() const;
+
+			// after the icon cache has another resolution, or another scale
+			void				ReloadIcons();
+
+private:
+	struct cell {
+		int32		index;		// -1 when the slot is free
+		BString		title;
+		BString		subtitle;
+		BString		condition;
+		BString		values[3];
+		BBitmap*	icon;		// belongs to the icon cache
+		bool		startsDay;
+	};
+
+			void				_UpdateMetrics();
+			void				_UpdateScrollBar();
+			BRect				_CellFrame(int32 index) const;
+			cell&				_Cell(int32 index);
+			void				_FillCell(cell& slot, int32 index);
+			void				_InvalidateCell(int32 index);
+			bool				_DayChanged(forecast_snapshot& snapshot, int32 index);
+			bool				_HourChanged(const forecast_snapshot& snapshot, int32 index) const;
+			BBitmap*			_Icon(const char* name);
+			void				_DrawString(const char* text, float y, const BRect& frame);
+
+			forecast_snapshot	fSnapshot;
+			bool				fHasSnapshot;
+			strip_mode			fMode;
+			bool				fCompact;
+
+			BDateTimeFormat		fDayFormat;
+			BDateTimeFormat		fWeekdayFormat;
+			BTimeFormat			fHourFormat;
+
+			float				fCellWidth;
+			float				fCellHeight;
+			float				fLineHeight;
+			float				fAscent;
+			float				fInset;
+			float				fIconLogicalSize;
+			int32				fIconSize;		// in physical pixels
+
+			cell				fCells[kStripCellCache];
+};
+
+
+#endif // _FORECASTSTRIPVIEW_H_
@@ -4,131 +4,458 @@
 #include "ForecastWindow.h"
 #include "BitmapView.h"
 #include "Condition.h"
-#include "DeskbarWeatherView.h"
-#include "OpenMeteo.h"
+#include "ForecastChartView.h"
+#include "ForecastModel.h"
+#include "ForecastStripView.h"
+#include "Formatters.h"
+#include "IconCache.h"
+#include "LooperWatchdog.h"
+#include "Trace.h"
 
 #include <Bitmap.h>
 #include <Box.h>
-#include <DateTimeFormat.h>
-#include <File.h>
-#include <IconUtils.h>
+#include <CheckBox.h>
 #include <LayoutBuilder.h>
-#include <Resources.h>
+#include <MessageRunner.h>
+#include <ScrollView.h>
 #include <StringView.h>
 
+#include <string.h>
 
-ForecastWindow::ForecastWindow(OpenMeteo* weather, BRect frame, const char* location, bool compact)
+
+static const uint32 kShownMessage = 'FpGw';
+static const uint32 kIdleMessage = 'FiGw';
+static const uint32 kHourlyMessage = 'FhGw';
+
+
+static const char*
+wind_direction_arrow(double direction)
+{
+	if (direction > 337.5 || direction <= 22.5)
+		return "\u2193"; // north
+	if (direction <= 67.5)
+		return "\u2199"; // north-east
+	if (direction <= 112.5)
+		return "\u2190"; // east
+	if (direction <= 157.5)
+		return "\u2196"; // south-east
+	if (direction <= 202.5)
+		return "\u2191"; // south
+	if (direction <= 247.5)
+		return "\u2197"; // south-west
+	if (direction <= 292.5)
+		return "\u2192"; // west
+
+	return "\u2198"; // north-west
+}
+
+
+// leaves the view alone when the text didn't change
+static void
+set_text(BStringView* view, const char* text)
+{
+	if (strcmp(view->Text() != NULL ? view->Text() : "", text) != 0)
+		view->SetText(text);
+}
+
+
+ForecastWindow::ForecastWindow(const forecast_snapshot& snapshot, BRect frame, const char* location, bool compact,
+	const BMessenger& target, bool keepWarm, bool hidden, bigtime_t requested)
 	:
 	BWindow(frame, location, B_TITLED_WINDOW_LOOK, B_NORMAL_WINDOW_FEEL,
-		B_NOT_ZOOMABLE | B_NOT_MINIMIZABLE | B_NOT_RESIZABLE | B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS | B_CLOSE_ON_ESCAPE)
+		B_NOT_ZOOMABLE | B_NOT_MINIMIZABLE | B_NOT_V_RESIZABLE | B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS | B_CLOSE_ON_ESCAPE),
+	fHasSnapshot(false),
+	fCompact(compact),
+	fKeepWarm(keepWarm),
+	fTarget(target),
+	fIdleRunner(NULL),
+	fCurrentBox(NULL),
+	fIconView(NULL),
+	fForecastBox(NULL),
+	fHourlyBox(NULL),
+	fStrip(NULL),
+	fChart(NULL)
+{
+	TRACE_SCOPE("ForecastWindow");
+	AddShortcut('W', B_COMMAND_KEY, new BMessage(B_QUIT_REQUESTED));
+	IconCache::Default()->AddWatcher(BMessenger(this));
+
+	if (hidden) {
+		// the views are built in the thread of the window, a first Show()
+		// after Hide() only starts it
+		BMessage message(kForecastSnapshotMessage);
+		message.AddData("snapshot", B_RAW_TYPE, &snapshot, sizeof(snapshot));
+		message.AddString("location", location);
+		PostMessage(&message);
+
+		// the idle time only starts once it was shown and closed again
+		Lock();
+		Hide();
+		Show();
+		Unlock();
+		return;
+	}
+
+	forecast_snapshot first = snapshot;
+	_Update(first, location);
+
+	Lock();
+	Show();
+	Unlock();
+
+	if (requested >= 0) {
+		BMessage shown(kShownMessage);
+		shown.AddInt64(kMessageSentKey, requested);
+		PostMessage(&shown);
+	}
+}
+
+
+ForecastWindow::~ForecastWindow()
+{
+	IconCache::Default()->RemoveWatcher(BMessenger(this));
+	delete fIdleRunner;
+}
+
+
+void
+ForecastWindow::DispatchMessage(BMessage* message, BHandler* handler)
+{
+	// closing a window that keeps warm only hides it, Quit() still quits
+	if (message->what == B_QUIT_REQUESTED && fKeepWarm) {
+		_Close();
+		return;
+	}
+
+	BWindow::DispatchMessage(message, handler);
+}
+
+
+void
+ForecastWindow::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case kForecastSnapshotMessage:
+		{
+			const void* data;
+			ssize_t size;
+			if (message->FindData("snapshot", B_RAW_TYPE, &data, &size) != B_OK
+				|| size != static_cast<ssize_t>(sizeof(forecast_snapshot)))
+				break;
+
+			// a hidden window that shouldn't keep warm anymore isn't needed
+			fKeepWarm = message->GetBool("keep", fKeepWarm);
+			if (!fKeepWarm && IsHidden()) {
+				Quit();
+				break;
+			}
+
+			forecast_snapshot snapshot;
+			memcpy(&snapshot, data, sizeof(snapshot));
+			_Update(snapshot, message->GetString("location", fLocation));
+			break;
+		}
+		case kForecastToggleMessage:
+		{
+			fKeepWarm = message->GetBool("keep", fKeepWarm);
+			if (IsHidden()) {
+				delete fIdleRunner;
+				fIdleRunner = NULL;
+
+				Show();
+				Activate();
+				_ReportShown(message->GetInt64(kMessageSentKey, -1), true);
+			} else if (message->GetBool("toggle") && IsActive())
+				_Close();
+			else
+				Activate();
+			break;
+		}
+		case kHourlyMessage:
+			fStrip->SetMode(fHourlyBox->Value() == B_CONTROL_ON ? kStripHourly : kStripDaily);
+			break;
+		case kIconsChangedMessage:
+			// the resolution for the current scale is ready
+			if (fHasSnapshot) {
+				_SetIcon(fSnapshot.current.Icon());
+				fStrip->ReloadIcons();
+			}
+			break;
+		case kShownMessage:
+			_ReportShown(message->GetInt64(kMessageSentKey, -1), false);
+			break;
+		case kIdleMessage:
+			delete fIdleRunner;
+			fIdleRunner = NULL;
+			if (IsHidden())
+				Quit();
+			break;
+		default:
+			BWindow::MessageReceived(message);
+	}
+}
+
+
+// compares every field with the snapshot that is shown and only touches the
+// views of the fields that changed
+void
+ForecastWindow::_Update(forecast_snapshot& snapshot, const char* location)
+{
+	TRACE_SCOPE("ForecastWindow::_Update");
+	if (fCurrentBox == NULL)
+		_BuildViews();
+
+	bool all = !fHasSnapshot;
+	Condition& current = snapshot.current;
+	Condition& shown = fSnapshot.current;
+	BString text;
+
+	if (all || fLocation != location) {
+		fLocation = location;
+		text.SetTo("Weather Conditions & Forecast for ");
+		text << location;
+		SetTitle(text);
+		set_text(fLocationView, location);
+	}
+
+	// the icons follow the size of the plain font
+	bool rescaled = IconCache::Default()->UpdateScale();
+
+	if (all || rescaled || current.WeatherCode() != shown.WeatherCode())
+		_SetIcon(current.Icon());
+	if (rescaled)
+		fStrip->ReloadIcons();
+
+	if (all || current.WeatherCode() != shown.WeatherCode())
+		set_text(fConditionView, current.Forecast());
+
+	// values missing from the reply are left empty
+	if (all || current.Temp() != shown.Temp()) {
+		text.SetTo("");
+		if (!Condition::IsMissing(current.Temp()))
+			text.SetToFormat("%.1f°", current.Temp());
+		set_text(fTempView, text);
+	}
+
+	if (all || current.Temp(true) != shown.Temp(true)) {
+		text.SetTo("");
+		if (!Condition::IsMissing(current.Temp(true)))
+			text.SetToFormat("%.1f°", current.Temp(true));
+		set_text(fFeelView, text);
+	}
+
+	if (all || current.iHigh() != shown.iHigh()) {
+		text.SetTo("");
+		if (!Condition::IsMissing(current.High()))
+			text << current.iHigh() << "°";
+		set_text(fHighView, text);
+	}
+
+	if (all || current.iLow() != shown.iLow()) {
+		text.SetTo("");
+		if (!Condition::IsMissing(current.Low()))
+			text << current.iLow() << "°";
+		set_text(fLowView, text);
+	}
+
+	if (all || current.Humidity() != shown.Humidity()) {
+		text.SetTo("");
+		if (current.Humidity() >= 0)
+			format_percent(text, current.Humidity());
+		set_text(fHumidityView, text);
+	}
+
+	if (all || current.Wind() != shown.Wind() || snapshot.imperial != fSnapshot.imperial) {
+		text.SetTo("");
+		if (!Condition::IsMissing(current.Wind()))
+			text.SetToFormat("%.1f %s", current.Wind(), (snapshot.imperial ? " mph" : " kmh"));
+		set_text(fWindView, text);
+	}
+
+	if (all || current.WindDirection() != shown.WindDirection()) {
+		text.SetTo("");
+		if (!Condition::IsMissing(current.WindDirection()))
+			text.SetToFormat("%s %.0f°", wind_direction_arrow(current.WindDirection()), current.WindDirection());
+		set_text(fDirectionView, text);
+	}
+
+	if (all || current.CloudCover() != shown.CloudCover()) {
+		text.SetTo("");
+		if (!Condition::IsMissing(current.CloudCover()))
+			text.SetToFormat("%.0f%%", current.CloudCover());
+		set_text(fCloudView, text);
+	}
+
+	if (all || current.Day() != shown.Day()) {
+		BString dateStr;
+		format_date_time(dateStr, current.Day(), B_FULL_DATE_FORMAT, B_SHORT_TIME_FORMAT);
+		text.SetTo("Current conditions updated: ");
+		text << dateStr;
+		fCurrentBox->SetLabel(text.String());
+	}
+
+	// the strip finds the days or hours that changed itself
+	bool hasDays = snapshot.dayCount > 0;
+	if (hasDays == fForecastBox->IsHidden(fForecastBox)) {
+		if (hasDays)
+			fForecastBox->Show();
+		else
+			fForecastBox->Hide();
+	}
+
+	fHourlyBox->SetEnabled(snapshot.hourCount > 0);
+	if (snapshot.hourCount == 0 && fStrip->Mode() == kStripHourly) {
+		fHourlyBox->SetValue(B_CONTROL_OFF);
+		fStrip->SetMode(kStripDaily);
+	}
+	fStrip->SetSnapshot(snapshot);
+
+	bool hasHours = snapshot.hourCount > 1;
+	if (hasHours == fChart->IsHidden(fChart)) {
+		if (hasHours)
+			fChart->Show();
+		else
+			fChart->Hide();
+	}
+	fChart->SetSnapshot(snapshot);
+
+	if (!fHasSnapshot)
+		CenterOnScreen();
+
+	fSnapshot = snapshot;
+	fHasSnapshot = true;
+}
+
+
+void
+ForecastWindow::_SetIcon(const char* name)
+{
+	float size = fCompact ? kCompactForecastIconSize : kForecastIconSize;
+	IconCache* icons = IconCache::Default();
+	fIconView->SetBitmap(icons->Get(name, size), icons->PhysicalSize(size));
+}
+
+
+void
+ForecastWindow::_Close()
+{
+	if (!fKeepWarm) {
+		Quit();
+		return;
+	}
+
+	if (IsHidden())
+		return;
+
+	Hide();
+	delete fIdleRunner;
+	fIdleRunner = new BMessageRunner(BMessenger(this), BMessage(kIdleMessage), kForecastIdleTimeout, 1);
+}
+
+
+// tells the target how long it took from the click until the window was drawn
+void
+ForecastWindow::_ReportShown(bigtime_t requested, bool warm)
+{
+	UpdateIfNeeded();
+
+	if (requested < 0 || !fTarget.IsValid())
+		return;
+
+	BMessage shown(kForecastShownMessage);
+	shown.AddInt64("latency", system_time() - requested);
+	shown.AddBool("warm", warm);
+	shown.AddInt64("bytes", _HeldBytes());
+	shown.AddInt64("icon bytes", IconCache::Default()->HeldBytes());
+	fTarget.SendMessage(&shown);
+}
+
+
+// what the window keeps for itself, the icons are shared and the views are small
+int64
+ForecastWindow::_HeldBytes()
+{
+	// the strip keeps a snapshot as well
+	int64 bytes = 2 * sizeof(forecast_snapshot);
+
+	if (fChart != NULL)
+		bytes += fChart->HeldBytes();
+
+	return bytes;
+}
+
+
+void
+ForecastWindow::_BuildViews()
 {
 	BFont bigFont(be_bold_font);
-	bigFont.SetSize(bigFont.Size() + (compact ? 2 : 4));
+	bigFont.SetSize(bigFont.Size() + (fCompact ? 2 : 4));
 
 	BFont bigPlainFont(be_plain_font);
-	bigPlainFont.SetSize(bigPlainFont.Size() + (compact ? 2 : 4));
-
-	BString windowTitle("Weather Conditions & Forecast for ");
-	windowTitle << location;
-	SetTitle(windowTitle);
-
-	BString currentString;
-	currentString.SetToFormat("%.1f°", weather->Current()->Temp());
-
-	BString currentFeelString;
-	currentFeelString.SetToFormat("%.1f°", weather->Current()->Temp(true));
-
-	BString currentLowString;
-	currentLowString << weather->Current()->iLow() << "°";
-
-	BString currentHighString;
-	currentHighString << weather->Current()->iHigh() << "°";
-
-	BString currentWindString;
-	currentWindString.SetToFormat("%.1f %s", weather->Current()->Wind(), (weather->IsImperial() ? " mph" : " kmh"));
-
-	BString currentDirectionString;
-	BString directionSymbolString;
-	double direction = weather->Current()->WindDirection();
-	if (direction > 337.5 || direction <= 22.5) {
-		// north
-		directionSymbolString = "\u2193";
-	} else if (direction > 22.5 && direction <= 67.5) {
-		// north-east
-		directionSymbolString = "\u2199";
-	} else if (direction > 67.5 && direction <= 112.5) {
-		// east
-		directionSymbolString = "\u2190";
-	} else if (direction > 112.5 && direction <= 157.5) {
-		// south-east
-		directionSymbolString = "\u2196";
-	} else if (direction > 157.5 && direction <= 202.5) {
-		// south
-		directionSymbolString = "\u2191";
-	} else if (direction > 202.5 && direction <= 247.5) {
-		// south-west
-		directionSymbolString = "\u2197";
-	} else if (direction > 247.5 && direction <= 292.5) {
-		// west
-		directionSymbolString = "\u2192";
-	} else if (direction > 292.5 && direction <= 337.5) {
-		// north-west
-		directionSymbolString = "\u2198";
-	}
-	currentDirectionString.SetToFormat("%s %.0f°", directionSymbolString.String(), direction);
-
-	BString currentCloudString;
-	currentCloudString.SetToFormat("%.0f%%", weather->Current()->CloudCover());
+	bigPlainFont.SetSize(bigPlainFont.Size() + (fCompact ? 2 : 4));
+
+	// the labels are filled in by _Update()
+	fLocationView = _BuildStringView("LocationString", "", B_ALIGN_CENTER, &bigFont);
+	fIconView = new BitmapView("ConditionBitmap");
+	fConditionView = _BuildStringView("CurrentConditionString", "", B_ALIGN_CENTER, &bigFont);
+	fTempView = _BuildStringView("CurrentString", "", B_ALIGN_LEFT, &bigFont);
+	fFeelView = _BuildStringView("CurrentFeelString", "", B_ALIGN_LEFT, &bigPlainFont);
+	fHighView = _BuildStringView("HighString", "", B_ALIGN_LEFT, &bigPlainFont);
+	fLowView = _BuildStringView("LowString", "", B_ALIGN_LEFT, &bigPlainFont);
+	fHumidityView = _BuildStringView("HumidityString", "", B_ALIGN_LEFT, &bigPlainFont);
+	fWindView = _BuildStringView("WindString", "", B_ALIGN_LEFT, &bigPlainFont);
+	fDirectionView = _BuildStringView("DirectionString", "", B_ALIGN_LEFT, &bigPlainFont);
+	fCloudView = _BuildStringView("CloudString", "", B_ALIGN_LEFT, &bigPlainFont);
 
 	BGridLayout* tempGrid;
 	BGridLayout* otherGrid;
 
-	BGroupView* currentView = new BGroupView(B_HORIZONTAL, compact ? 0 : B_USE_BIG_SPACING);
+	BGroupView* currentView = new BGroupView(B_HORIZONTAL, fCompact ? 0 : B_USE_BIG_SPACING);
 	// clang-format off
-	BLayoutBuilder::Group<>(currentView, B_HORIZONTAL, compact ? 0 : B_USE_BIG_SPACING)
-		.SetInsets(compact ? 0 : B_USE_BIG_INSETS)
+	BLayoutBuilder::Group<>(currentView, B_HORIZONTAL, fCompact ? 0 : B_USE_BIG_SPACING)
+		.SetInsets(fCompact ? 0 : B_USE_BIG_INSETS)
 		.AddGlue()
-		.AddGroup(B_VERTICAL, compact ? 0 : B_USE_DEFAULT_SPACING)
+		.AddGroup(B_VERTICAL, fCompact ? 0 : B_USE_DEFAULT_SPACING)
 			.AddGlue()
 			.AddGroup(B_HORIZONTAL)
 				.AddGlue()
-				.Add(_BuildStringView("LocationString", location, B_ALIGN_CENTER, &bigFont))
+				.Add(fLocationView)
 				.AddGlue()
 			.End()
 			.AddGroup(B_HORIZONTAL)
 				.AddGlue()
-				.Add(new BitmapView("ConditionBitmap", DeskbarWeatherView::LoadResourceBitmap(weather->Current()->Icon()->String(), compact ? 48 : 64)), 0)
+				.Add(fIconView, 0)
 				.AddGlue()
 			.End()
 			.AddGroup(B_HORIZONTAL)
 				.AddGlue()
-				.Add(_BuildStringView("CurrentConditionString", weather->Current()->Forecast()->String(), B_ALIGN_CENTER, &bigFont))
+				.Add(fConditionView)
 				.AddGlue()
 			.End()
 			.AddGlue()
 		.End()
 		.AddGlue()
-		.Add(tempGrid = BLayoutBuilder::Grid<>(B_USE_HALF_ITEM_SPACING, compact ? 0 : B_USE_BIG_SPACING)
+		.Add(tempGrid = BLayoutBuilder::Grid<>(B_USE_HALF_ITEM_SPACING, fCompact ? 0 : B_USE_BIG_SPACING)
 			.Add(_BuildStringView("CurrentLabel", "Current:", B_ALIGN_RIGHT, &bigFont), 0, 0)
-			.Add(_BuildStringView("CurrentString", currentString.String(), B_ALIGN_LEFT, &bigFont), 1, 0)
+			.Add(fTempView, 1, 0)
 			.Add(_BuildStringView("CurrentFeelLabel", "Feels Like:", B_ALIGN_RIGHT, &bigPlainFont), 0, 1)
-			.Add(_BuildStringView("CurrentFeelString", currentFeelString.String(), B_ALIGN_LEFT, &bigPlainFont), 1, 1)
+			.Add(fFeelView, 1, 1)
 			.Add(_BuildStringView("HighLabel", "High:", B_ALIGN_RIGHT, &bigPlainFont), 0, 2)
-			.Add(_BuildStringView("HighString", currentHighString.String(), B_ALIGN_LEFT, &bigPlainFont), 1, 2)
+			.Add(fHighView, 1, 2)
 			.Add(_BuildStringView("LowLabel", "Low:", B_ALIGN_RIGHT, &bigPlainFont), 0, 3)
-			.Add(_BuildStringView("LowLabel", currentLowString.String(), B_ALIGN_LEFT, &bigPlainFont), 1, 3)
+			.Add(fLowView, 1, 3)
 			.SetColumnWeight(0, 0)
 		)
 		.AddGlue()
-		.Add(otherGrid = BLayoutBuilder::Grid<>(B_USE_HALF_ITEM_SPACING, compact ? 0 : B_USE_BIG_SPACING)
+		.Add(otherGrid = BLayoutBuilder::Grid<>(B_USE_HALF_ITEM_SPACING, fCompact ? 0 : B_USE_BIG_SPACING)
 			.Add(_BuildStringView("HumidityLabel", "Humidity:", B_ALIGN_RIGHT, &bigPlainFont), 0, 0)
-			.Add(_BuildStringView("HumidityString", weather->Current()->Humidity()->String(), B_ALIGN_LEFT, &bigPlainFont), 1, 0)
+			.Add(fHumidityView, 1, 0)
 			.Add(_BuildStringView("WindLabel", "Wind Speed:", B_ALIGN_RIGHT, &bigPlainFont), 0, 1)
-			.Add(_BuildStringView("WindString", currentWindString, B_ALIGN_LEFT, &bigPlainFont), 1, 1)
+			.Add(fWindView, 1, 1)
 			.Add(_BuildStringView("DirectionLabel", "Wind Direction:", B_ALIGN_RIGHT, &bigPlainFont), 0, 2)
-			.Add(_BuildStringView("DirectionString", currentDirectionString, B_ALIGN_LEFT, &bigPlainFont), 1, 2)
+			.Add(fDirectionView, 1, 2)
 			.Add(_BuildStringView("CloudLabel", "Cloud Cover:", B_ALIGN_RIGHT, &bigPlainFont), 0, 3)
-			.Add(_BuildStringView("CloudString", currentCloudString, B_ALIGN_LEFT, &bigPlainFont), 1, 3)
+			.Add(fCloudView, 1, 3)
 			.SetColumnWeight(0, 0)
 		)
 		.AddGlue();
@@ -136,94 +463,34 @@ ForecastWindow::ForecastWindow(OpenMeteo* weather, BRect frame, const char* loca
 
 	otherGrid->AlignLayoutWith(tempGrid, B_VERTICAL);
 
-	BBox* currentBox = new BBox("CurrentBBox");
-	BString boxLabel("Current conditions updated: ");
-	BString dateStr;
-	weather->LastUpdate(dateStr, true);
-	boxLabel << dateStr;
-	currentBox->SetLabel(boxLabel.String());
-	currentBox->AddChild(currentView);
-
-	BLayoutBuilder::Group<> builder = BLayoutBuilder::Group<>(this, B_VERTICAL, compact ? 0 : B_USE_SMALL_SPACING)
-		.SetInsets(compact ? 1 : B_USE_HALF_ITEM_INSETS)
-		.Add(currentBox);
-
-	BObjectList<Condition>* forecastList = weather->Forecast();
-	// check if we need to bother with creating a forecast box at all
-	if (forecastList->CountItems() > 0) {
-		BGroupView* forecastView = new BGroupView(B_HORIZONTAL, compact ? 0 : B_USE_DEFAULT_SPACING);
-		BLayoutBuilder::Group<> forecastBuilder = BLayoutBuilder::Group<>(forecastView);
-
-		BDateTimeFormat format;
-		format.SetDateTimeFormat(B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT, B_DATE_ELEMENT_WEEKDAY | B_DATE_ELEMENT_MONTH | B_DATE_ELEMENT_DAY);
-
-		for (int32 i = 0; i < forecastList->CountItems(); i++) {
-			Condition* condition = forecastList->ItemAt(i);
-
-			BString dayString;
-			format.Format(dayString, condition->Day(), B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT);
-
-			BString lowString;
-			lowString << condition->iLow() << "°";
-
-			BString highString;
-			highString << condition->iHigh() << "°";
-
-			// clang-format off
-			forecastBuilder
-				.AddGroup(B_VERTICAL, compact ? B_USE_SMALL_SPACING : B_USE_DEFAULT_SPACING)
-					.AddGroup(B_HORIZONTAL, compact ? B_USE_SMALL_SPACING : B_USE_DEFAULT_SPACING)
-						.AddGlue()
-						.Add(new BStringView("DateString", dayString))
-						.AddGlue()
-					.End()
-					.AddGroup(B_HORIZONTAL, compact ? B_USE_SMALL_SPACING : B_USE_DEFAULT_SPACING)
-						.AddGlue()
-						.Add(new BitmapView("ConditionBitmap", DeskbarWeatherView::LoadResourceBitmap(condition->Icon()->String(), compact ? 36 : 48)), 0)
-						.AddGlue()
-					.End()
-					.AddGroup(B_HORIZONTAL, compact ? B_USE_SMALL_SPACING : B_USE_DEFAULT_SPACING)
-						.AddGlue()
-						.Add(new BStringView("ConditionString", condition->Forecast()->String()))
-						.AddGlue()
-					.End()
-					.AddGroup(B_HORIZONTAL, compact ? B_USE_SMALL_SPACING : B_USE_DEFAULT_SPACING)
-						.AddGlue()
-						.AddGrid(B_USE_HALF_ITEM_SPACING, 0.0)
-							.Add(_BuildStringView("HighLabel", "High:", B_ALIGN_RIGHT), 0, 0)
-							.Add(_BuildStringView("HighString", highString.String(), B_ALIGN_LEFT), 1, 0)
-							.Add(_BuildStringView("LowLabel", "Low:", B_ALIGN_RIGHT), 0, 1)
-							.Add(_BuildStringView("LowString", lowString.String(), B_ALIGN_LEFT), 1, 1)
-							.SetColumnWeight(0, 0)
-							.SetColumnWeight(1, 0)
-						.End()
-						.AddGlue()
-					.End()
-				.End();
-			// clang-format on
-
-			if (forecastList->ItemAt(i + 1) != NULL) {
-				BView* separatorView = new BView("SeparatorView", B_WILL_DRAW);
-				separatorView->SetExplicitSize(BSize(0, B_SIZE_UNSET));
-				separatorView->SetViewUIColor(B_PANEL_BACKGROUND_COLOR, B_DARKEN_1_TINT);
-				forecastBuilder.Add(separatorView);
-			}
-		}
-		forecastBuilder.SetInsets(compact ? 1 : B_USE_ITEM_INSETS);
+	fCurrentBox = new BBox("CurrentBBox");
+	fCurrentBox->AddChild(currentView);
 
-		BBox* forecastBox = new BBox("ForecastBBox");
-		forecastBox->SetLabel("Forecast");
-		forecastBox->AddChild(forecastView);
+	// the days and hours are drawn by one view, however many there are
+	fStrip = new ForecastStripView("ForecastStrip", fCompact);
+	fHourlyBox = new BCheckBox("HourlyBox", "Hourly", new BMessage(kHourlyMessage));
+	fChart = new ForecastChartView("ForecastChart", fCompact);
 
-		builder.Add(forecastBox);
-	}
+	BGroupView* forecastView = new BGroupView(B_VERTICAL, fCompact ? 0 : B_USE_SMALL_SPACING);
+	// clang-format off
+	BLayoutBuilder::Group<>(forecastView)
+		.SetInsets(fCompact ? 1 : B_USE_ITEM_INSETS)
+		.AddGroup(B_HORIZONTAL)
+			.AddGlue()
+			.Add(fHourlyBox)
+		.End()
+		.Add(new BScrollView("ForecastScrollView", fStrip, 0, true, false, B_NO_BORDER))
+		.Add(fChart);
+	// clang-format on
 
-	AddShortcut('W', B_COMMAND_KEY, new BMessage(B_QUIT_REQUESTED));
+	fForecastBox = new BBox("ForecastBBox");
+	fForecastBox->SetLabel("Forecast");
+	fForecastBox->AddChild(forecastView);
 
-	Lock();
-	CenterOnScreen();
-	Show();
-	Unlock();
+	BLayoutBuilder::Group<>(this, B_VERTICAL, fCompact ? 0 : B_USE_SMALL_SPACING)
+		.SetInsets(fCompact ? 1 : B_USE_HALF_ITEM_INSETS)
+		.Add(fCurrentBox)
+		.Add(fForecastBox);
 }
 
 
@@ -5,21 +5,102 @@
 #define _FORECASTWINDOW_H_
 
 
+#include <Messenger.h>
+#include <String.h>
 #include <Window.h>
 
-class BBitmap;
+#include "ForecastModel.h"
+#include "ForecastSnapshot.h"
+#include "RequestStats.h"
+
+class BBox;
+class BCheckBox;
+class BMessageRunner;
 class BStringView;
 
-class OpenMeteo;
+class BitmapView;
+class ForecastChartView;
+class ForecastStripView;
+
+
+// the window shows everything
+static const uint32 kForecastWindowFields = kForecastAllFields;
+
+// a new forecast_snapshot in "snapshot" and the name of the location in "location",
+// "keep" turns keeping the window around when it's closed on or off
+static const uint32 kForecastSnapshotMessage = 'FsGw';
+// shows a hidden window or activates it, "toggle" closes it when it's active
+static const uint32 kForecastToggleMessage = 'FtGw';
+// sent to the target once the window is visible, with "latency", "warm", "bytes"
+// held by the window itself and "icon bytes" of the icon cache it shares
+static const uint32 kForecastShownMessage = 'FvGw';
 
+// a window kept around that was hidden for this long quits
+static const bigtime_t kForecastIdleTimeout = 10 * 60 * 1000000LL;
 
+// the logical size of the icon of the current conditions
+static const float kForecastIconSize = 64;
+static const float kCompactForecastIconSize = 48;
+
+
+// how long a click took to show the window, measured by the replicant
+struct forecast_open_stats {
+	Histogram	warm;		// showed a hidden window
+	Histogram	cold;		// built a new window
+	int64		heldBytes;	// the snapshots and the chart of the last window that was shown
+	int64		iconBytes;	// the icon cache, shared with the replicant
+};
+
+
+// Builds its views once and updates only the labels and icons that changed
+// with every snapshot it receives.  A window that keeps warm only hides when
+// it's closed, and quits when it stayed hidden for kForecastIdleTimeout.  A
+// window built hidden builds its views in its own thread and stays until it
+// was shown once.
 class ForecastWindow : public BWindow {
 
 public:
-		ForecastWindow(OpenMeteo* weather, BRect frame, const char* location, bool compact);
+		ForecastWindow(const forecast_snapshot& snapshot, BRect frame, const char* location, bool compact,
+			const BMessenger& target, bool keepWarm = false, bool hidden = false, bigtime_t requested = -1);
+		~ForecastWindow();
+
+	virtual	void	DispatchMessage(BMessage* message, BHandler* handler);
+	virtual	void	MessageReceived(BMessage* message);
 
 private:
+		void			_Update(forecast_snapshot& snapshot, const char* location);
+		void			_SetIcon(const char* name);
+		void			_Close();
+		void			_ReportShown(bigtime_t requested, bool warm);
+		int64			_HeldBytes();
+		void			_BuildViews();
 		BStringView*	_BuildStringView(const char* name, const char* label, alignment align, BFont* font = NULL);
+
+		forecast_snapshot	fSnapshot;
+		bool			fHasSnapshot;
+		bool			fCompact;
+		bool			fKeepWarm;
+		BMessenger		fTarget;
+		BMessageRunner*	fIdleRunner;
+		BString			fLocation;
+
+		BBox*			fCurrentBox;
+		BStringView*	fLocationView;
+		BitmapView*		fIconView;
+		BStringView*	fConditionView;
+		BStringView*	fTempView;
+		BStringView*	fFeelView;
+		BStringView*	fHighView;
+		BStringView*	fLowView;
+		BStringView*	fHumidityView;
+		BStringView*	fWindView;
+		BStringView*	fDirectionView;
+		BStringView*	fCloudView;
+
+		BBox*			fForecastBox;
+		BCheckBox*		fHourlyBox;
+		ForecastStripView*	fStrip;
+		ForecastChartView*	fChart;
 };
 
 
@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "Formatters.h"
+#include "Condition.h"
+#include "ForecastWindow.h"
+#include "IconCache.h"
+#include "LooperWatchdog.h"
+#include "RequestStats.h"
+
+#include <DateTimeFormat.h>
+#include <Locker.h>
+#include <NumberFormat.h>
+#include <private/shared/AutoLocker.h>
+
+
+static BLocker sFormatLock("formatter lock");
+
+
+status_t
+format_percent(BString& output, double fraction)
+{
+	AutoLocker<BLocker> locker(sFormatLock);
+	static BNumberFormat sNumberFormat;
+
+	return sNumberFormat.FormatPercent(output, fraction);
+}
+
+
+status_t
+format_date_time(BString& output, time_t time, BDateFormatStyle dateStyle, BTimeFormatStyle timeStyle)
+{
+	AutoLocker<BLocker> locker(sFormatLock);
+	static BDateTimeFormat sDateTimeFormat;
+
+	return sDateTimeFormat.Format(output, time, dateStyle, timeStyle);
+}
+
+
+void
+format_tooltip(BString& output, const char* location, Condition& current, bool showFeelsLike, const char* updated)
+{
+	output.SetTo(location);
+	output << "\n" << current.Forecast() << "\n";
+	// if we're showing "Feels Like" in the Deskbar then show actual temp in the tooltip,
+	// values missing from the reply are left out
+	double temp = current.Temp(!showFeelsLike);
+	if (!Condition::IsMissing(temp))
+		output << (showFeelsLike ? "Current: " : "Feels Like: ") << temp << "°\n";
+
+	if (!Condition::IsMissing(current.High()))
+		output << "High: " << current.iHigh() << "°\n";
+	if (!Condition::IsMissing(current.Low()))
+		output << "Low: " << current.iLow() << "°\n";
+	output << "Updated: " << updated;
+}
+
+
+void
+format_notification(BString& output, const char* location, Condition& current)
+{
+	output.SetTo(location);
+	output << "\n\n" << current.Forecast();
+	if (!Condition::IsMissing(current.Temp()))
+		output << "\n\n" << current.Temp() << "°";
+}
+
+
+void
+format_replicant(BString& output, display_mode mode, Condition& current, bool imperial, bool feelsLike, int16 rain)
+{
+	if (Condition::IsMissing(current.Temp(feelsLike)))
+		output = "-°";
+	else if (imperial)
+		output.SetToFormat("%" B_PRId32 "°", current.iTemp(feelsLike));
+	else
+		output.SetToFormat("%.1f°", current.Temp(feelsLike));
+
+	BString extra;
+	if (mode == kDisplayHighLow && (Condition::IsMissing(current.High()) || Condition::IsMissing(current.Low())))
+		extra = " -°/-°";
+	else if (mode == kDisplayHighLow)
+		extra.SetToFormat(" %" B_PRId32 "°/%" B_PRId32 "°", current.iHigh(), current.iLow());
+	else if (mode == kDisplayRain && rain != kMissingValue)
+		extra.SetToFormat(" %d%%", rain);
+	else if (mode == kDisplayRain)
+		extra = " -%";
+	output << extra;
+}
+
+
+static void
+format_duration(BString& output, uint64 microseconds)
+{
+	BString duration;
+	if (microseconds < 1000)
+		duration.SetToFormat("%u µs", static_cast<unsigned>(microseconds));
+	else
+		duration.SetToFormat("%.1f ms", microseconds / 1000.0);
+	output << duration;
+}
+
+
+void
+format_request_stats(BString& output, const char* name, const request_stats& stats)
+{
+	BString line;
+	line.SetToFormat("%s: %u requests, %u failed", name, static_cast<unsigned>(stats.requests),
+		static_cast<unsigned>(stats.failed));
+	output << line;
+
+	if (stats.bytes.Count() > 0) {
+		line.SetToFormat(", %.1f KiB average, %.1f KiB largest",
+			stats.bytes.Sum() / 1024.0 / stats.bytes.Count(), stats.bytes.Max() / 1024.0);
+		output << line;
+	}
+	output << "\n";
+
+	// the percentiles are the upper ends of power of two buckets
+	for (int32 x = 0; x < kPhaseCount; x++) {
+		const Histogram& phase = stats.phases[x];
+		if (phase.Count() == 0)
+			continue;
+
+		output << "    " << RequestStats::PhaseName(static_cast<request_phase>(x)) << ": median ";
+		format_duration(output, phase.Percentile(50));
+		output << ", p95 ";
+		format_duration(output, phase.Percentile(95));
+		output << ", max ";
+		format_duration(output, phase.Max());
+		output << "\n";
+	}
+}
+
+
+void
+format_watchdog_stats(BString& output, const watchdog_stats& stats)
+{
+	BString line;
+	line.SetToFormat("Deskbar: %u messages, %u over the %.1f ms budget", static_cast<unsigned>(stats.handled),
+		static_cast<unsigned>(stats.overBudget), stats.budget / 1000.0);
+	output << line;
+
+	if (stats.worstHandler != NULL) {
+		output << ", slowest " << stats.worstHandler << " ";
+		if (stats.worstWhat != 0) {
+			char what[16];
+			LooperWatchdog::FormatWhat(what, sizeof(what), stats.worstWhat);
+			output << what << " ";
+		}
+		format_duration(output, stats.worstDuration);
+	}
+	output << "\n";
+
+	const rolling_percentiles* percentiles[] = {&stats.handler, &stats.queue};
+	const char* names[] = {"handler", "queued"};
+	for (int32 x = 0; x < 2; x++) {
+		if (percentiles[x]->count == 0)
+			continue;
+
+		output << "    " << names[x] << ": median ";
+		format_duration(output, percentiles[x]->median);
+		output << ", p95 ";
+		format_duration(output, percentiles[x]->p95);
+		output << ", p99 ";
+		format_duration(output, percentiles[x]->p99);
+		output << ", max ";
+		format_duration(output, percentiles[x]->max);
+		output << "\n";
+	}
+}
+
+
+void
+format_open_stats(BString& output, const forecast_open_stats& stats)
+{
+	BString line;
+	line.SetToFormat("Forecast window: %u warm opens, %u cold", static_cast<unsigned>(stats.warm.Count()),
+		static_cast<unsigned>(stats.cold.Count()));
+	output << line;
+
+	if (stats.heldBytes > 0) {
+		line.SetToFormat(", %.1f KiB kept, %.1f KiB of shared icons", stats.heldBytes / 1024.0,
+			stats.iconBytes / 1024.0);
+		output << line;
+	}
+	output << "\n";
+
+	const Histogram* opens[] = {&stats.warm, &stats.cold};
+	const char* names[] = {"warm", "cold"};
+	for (int32 x = 0; x < 2; x++) {
+		if (opens[x]->Count() == 0)
+			continue;
+
+		output << "    " << names[x] << ": median ";
+		format_duration(output, opens[x]->Percentile(50));
+		output << ", p95 ";
+		format_duration(output, opens[x]->Percentile(95));
+		output << ", max ";
+		format_duration(output, opens[x]->Max());
+		output << "\n";
+	}
+}
+
+
+void
+format_icon_stats(BString& output, const icon_cache_stats& stats)
+{
+	BString line;
+	line.SetToFormat("Icons: %d rasterized by %d workers, %.1f KiB", static_cast<int>(stats.rasterCount),
+		static_cast<int>(stats.workerCount), stats.heldBytes / 1024.0);
+	output << line;
+
+	if (stats.prewarmTime >= 0) {
+		output << ", prewarmed in ";
+		format_duration(output, stats.prewarmTime);
+	}
+	output << "\n";
+}
+
+
+void
+format_history_stats(BString& output, int32 locations, int32 observations, int64 bytes)
+{
+	BString line;
+	line.SetToFormat("History: %d observations of %d locations, %.1f KiB\n", static_cast<int>(observations),
+		static_cast<int>(locations), bytes / 1024.0);
+	output << line;
+}
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _FORMATTERS_H_
+#define _FORMATTERS_H_
+
+
+#include <FormattingConventions.h>
+#include <String.h>
+
+#include "WeatherSettings.h"
+
+
+class Condition;
+struct forecast_open_stats;
+struct icon_cache_stats;
+struct request_stats;
+struct watchdog_stats;
+
+
+// Locale formatters are costly to create, these share one of each between all callers.
+status_t	format_percent(BString& output, double fraction);
+status_t	format_date_time(BString& output, time_t time, BDateFormatStyle dateStyle,
+				BTimeFormatStyle timeStyle);
+
+//TODO configurable tooltip and notification information
+void		format_tooltip(BString& output, const char* location, Condition& current, bool showFeelsLike,
+				const char* updated);
+void		format_notification(BString& output, const char* location, Condition& current);
+// the replicant text, rain is a percentage or kMissingValue
+void		format_replicant(BString& output, display_mode mode, Condition& current, bool imperial, bool feelsLike,
+				int16 rain);
+
+// appends one line for the requests and one for every phase that was measured
+void		format_request_stats(BString& output, const char* name, const request_stats& stats);
+void		format_watchdog_stats(BString& output, const watchdog_stats& stats);
+void		format_open_stats(BString& output, const forecast_open_stats& stats);
+void		format_icon_stats(BString& output, const icon_cache_stats& stats);
+void		format_history_stats(BString& output, int32 locations, int32 observations, int64 bytes);
+
+#endif // _FORMATTERS_H_
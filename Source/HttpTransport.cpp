@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "HttpTransport.h"
+#include "CaptureArchive.h"
+#include "Trace.h"
+
+#include <DataIO.h>
+#include <OS.h>
+#include <String.h>
+#include <private/netservices/HttpRequest.h>
+#include <private/netservices/UrlProtocolListener.h>
+#include <private/netservices/UrlProtocolRoster.h>
+#include <private/shared/AutoLocker.h>
+
+
+using namespace BPrivate::Network;
+
+
+// the request of one listener, it is reused for every fetch
+class HttpExchange : public BUrlProtocolListener {
+public:
+	HttpExchange(HttpTransport* transport, TransportListener* listener)
+		:
+		fTransport(transport),
+		fListener(listener),
+		fRequest(NULL),
+		fStarted(0),
+		fResolved(0),
+		fConnected(0),
+		fResponded(0),
+		fTime(0)
+	{}
+
+
+	virtual
+	~HttpExchange()
+	{
+		if (fRequest != NULL && fRequest->IsRunning())
+			fRequest->Stop();
+		delete fRequest;
+	}
+
+
+	status_t
+	Fetch(const BUrl& url)
+	{
+		if (fRequest == NULL) {
+			fRequest = BUrlProtocolRoster::MakeRequest(url, &fOutput, this);
+			if (fRequest == NULL)
+				return B_ERROR;
+		} else if (fRequest->IsRunning())
+			return B_BUSY;
+		else
+			fRequest->SetUrl(url);
+
+		fStarted = system_time();
+		fResolved = fConnected = fResponded = 0;
+		fTime = real_time_clock_usecs();
+		return fRequest->Run() < B_OK ? B_ERROR : B_OK;
+	}
+
+
+	virtual void
+	HostnameResolved(BUrlRequest* /*caller*/, const char* /*ip*/)
+	{
+		fResolved = system_time();
+	}
+
+
+	// the secure socket has done the handshake by then as well
+	virtual void
+	ConnectionOpened(BUrlRequest* /*caller*/)
+	{
+		fConnected = system_time();
+	}
+
+
+	virtual void
+	ResponseStarted(BUrlRequest* /*caller*/)
+	{
+		fResponded = system_time();
+	}
+
+
+	virtual void
+	RequestCompleted(BUrlRequest* caller, bool /*success*/)
+	{
+		BString url(caller->Url().UrlString());
+		const BHttpResult* result = dynamic_cast<const BHttpResult*>(&caller->Result());
+
+		transport_exchange exchange;
+		exchange.url = url.String();
+		exchange.status = result != NULL ? result->StatusCode() : 0;
+		exchange.statusText = result != NULL ? result->StatusText().String() : "";
+		// the buffer is reused, so only the part written by this request is valid
+		exchange.body = fOutput.Buffer();
+		exchange.bodySize = fOutput.Position();
+		exchange.time = fTime;
+		bigtime_t completed = system_time();
+		exchange.duration = completed - fStarted;
+		exchange.resolveTime = _Phase(fStarted, fResolved);
+		exchange.connectTime = _Phase(fResolved, fConnected);
+		exchange.waitTime = _Phase(fConnected, fResponded);
+		exchange.transferTime = _Phase(fResponded, completed);
+		_TraceExchange(exchange);
+
+		TRACE_SCOPE("RequestCompleted");
+		fTransport->_Record(exchange);
+		fListener->ExchangeCompleted(exchange);
+		fOutput.Seek(0, SEEK_SET);
+	}
+
+
+	TransportListener*	Listener() const { return fListener; }
+
+private:
+	// the request ran on this thread, so it can be shown from here
+	void
+	_TraceExchange(const transport_exchange& exchange)
+	{
+		if (!Trace::IsEnabled())
+			return;
+
+		Trace::Complete("request", fStarted, exchange.duration);
+		if (exchange.resolveTime >= 0)
+			Trace::Complete("resolve", fStarted, exchange.resolveTime);
+		if (exchange.connectTime >= 0)
+			Trace::Complete("connect", fResolved, exchange.connectTime);
+		if (exchange.waitTime >= 0)
+			Trace::Complete("wait", fConnected, exchange.waitTime);
+		if (exchange.transferTime >= 0)
+			Trace::Complete("transfer", fResponded, exchange.transferTime);
+	}
+
+
+	// a phase is unknown when the request failed before it ended
+	static bigtime_t
+	_Phase(bigtime_t start, bigtime_t end)
+	{
+		return start > 0 && end > 0 ? end - start : -1;
+	}
+
+	HttpTransport*		fTransport;
+	TransportListener*	fListener;
+	BUrlRequest*		fRequest;
+	BMallocIO			fOutput;
+	bigtime_t			fStarted;
+	bigtime_t			fResolved;
+	bigtime_t			fConnected;
+	bigtime_t			fResponded;
+	bigtime_t			fTime;
+};
+
+
+HttpTransport::HttpTransport()
+	:
+	fLock("HttpTransport"),
+	fRecorder(NULL)
+{}
+
+
+HttpTransport::~HttpTransport()
+{
+	while (!fExchanges.IsEmpty())
+		delete fExchanges.RemoveItemAt(0);
+
+	delete fRecorder;
+}
+
+
+status_t
+HttpTransport::Fetch(const char* urlString, TransportListener* listener)
+{
+	if (urlString == NULL || listener == NULL)
+		return B_BAD_VALUE;
+
+#if B_HAIKU_VERSION > B_HAIKU_VERSION_1_BETA_5
+	BUrl url(urlString, true);
+#else
+	BUrl url(urlString);
+#endif
+
+	HttpExchange* exchange = NULL;
+	for (int32 x = 0; x < fExchanges.CountItems(); x++) {
+		if (fExchanges.ItemAt(x)->Listener() == listener)
+			exchange = fExchanges.ItemAt(x);
+	}
+
+	if (exchange == NULL) {
+		exchange = new HttpExchange(this, listener);
+		fExchanges.AddItem(exchange);
+	}
+
+	return exchange->Fetch(url);
+}
+
+
+void
+HttpTransport::Cancel(TransportListener* listener)
+{
+	for (int32 x = 0; x < fExchanges.CountItems(); x++) {
+		if (fExchanges.ItemAt(x)->Listener() == listener) {
+			delete fExchanges.RemoveItemAt(x);
+			return;
+		}
+	}
+}
+
+
+status_t
+HttpTransport::StartCapture(const char* path)
+{
+	CaptureRecorder* recorder = new CaptureRecorder();
+	status_t status = recorder->Open(path);
+	if (status != B_OK) {
+		delete recorder;
+		return status;
+	}
+
+	StopCapture();
+
+	AutoLocker<BLocker> locker(fLock);
+	fRecorder = recorder;
+	return B_OK;
+}
+
+
+void
+HttpTransport::StopCapture()
+{
+	fLock.Lock();
+	CaptureRecorder* recorder = fRecorder;
+	fRecorder = NULL;
+	fLock.Unlock();
+
+	// flushes whatever is still buffered
+	delete recorder;
+}
+
+
+bool
+HttpTransport::IsCapturing()
+{
+	AutoLocker<BLocker> locker(fLock);
+	return fRecorder != NULL;
+}
+
+
+// called from the request threads, the recorder only copies the exchange
+void
+HttpTransport::_Record(const transport_exchange& exchange)
+{
+	AutoLocker<BLocker> locker(fLock);
+	if (fRecorder != NULL)
+		fRecorder->Record(exchange);
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _HTTPTRANSPORT_H_
+#define _HTTPTRANSPORT_H_
+
+
+#include "Transport.h"
+
+#include <Locker.h>
+#include <ObjectList.h>
+
+
+class CaptureRecorder;
+class HttpExchange;
+
+
+// Gets the replies from the network, optionally capturing every exchange
+// into an archive for ReplayTransport.
+class HttpTransport : public Transport {
+public:
+								HttpTransport();
+	virtual						~HttpTransport();
+
+	virtual	status_t			Fetch(const char* url, TransportListener* listener);
+	virtual	void				Cancel(TransportListener* listener);
+
+			status_t			StartCapture(const char* path);
+			void				StopCapture();
+			bool				IsCapturing();
+
+private:
+	friend class HttpExchange;
+
+			void				_Record(const transport_exchange& exchange);
+
+			BObjectList<HttpExchange> fExchanges;
+			BLocker				fLock;
+			CaptureRecorder*	fRecorder;
+};
+
+#endif // _HTTPTRANSPORT_H_
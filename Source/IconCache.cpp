@@ -0,0 +1,511 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "IconCache.h"
+#include "AppImage.h"
+#include "Trace.h"
+
+#include <Bitmap.h>
+#include <File.h>
+#include <Font.h>
+#include <IconUtils.h>
+#include <OS.h>
+#include <Resources.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// the size of the plain font that doesn't scale anything
+const float kUnscaledFontSize = 12.0;
+
+
+static float
+system_scale()
+{
+	float scale = be_plain_font->Size() / kUnscaledFontSize;
+	return scale > 1 ? scale : 1;
+}
+
+
+IconCache::IconCache()
+	:
+	fThreadCount(0),
+	fQuit(false),
+	fFile(NULL),
+	fResources(NULL),
+	fPrewarmStart(-1),
+	fPrewarmTime(-1),
+	fScale(system_scale()),
+	fIconCount(0),
+	fRasterCount(0),
+	fSizeCount(0),
+	fJobCount(0),
+	fWatcherCount(0)
+{
+	pthread_mutex_init(&fLock, NULL);
+	pthread_cond_init(&fCondition, NULL);
+	pthread_cond_init(&fStored, NULL);
+}
+
+
+IconCache::~IconCache()
+{
+	pthread_mutex_lock(&fLock);
+	fQuit = true;
+	pthread_cond_broadcast(&fCondition);
+	pthread_mutex_unlock(&fLock);
+
+	for (int32 x = 0; x < fThreadCount; x++)
+		pthread_join(fThreads[x], NULL);
+
+	for (int32 x = 0; x < fRasterCount; x++)
+		delete fRasters[x].bitmap;
+	for (int32 x = 0; x < fIconCount; x++)
+		free(fIcons[x].data);
+
+	delete fResources;
+	delete fFile;
+
+	pthread_cond_destroy(&fStored);
+	pthread_cond_destroy(&fCondition);
+	pthread_mutex_destroy(&fLock);
+}
+
+
+IconCache*
+IconCache::Default()
+{
+	static IconCache sDefaultCache;
+	return &sDefaultCache;
+}
+
+
+BBitmap*
+IconCache::Get(const char* name, float size)
+{
+	pthread_mutex_lock(&fLock);
+	int32 icon = _Icon(name);
+	if (icon < 0) {
+		pthread_mutex_unlock(&fLock);
+		return NULL;
+	}
+
+	_AddSize(size);
+	int32 physical = static_cast<int32>(roundf(size * fScale));
+	raster* found = _Find(icon, physical, false);
+
+	// prewarming is about to get to it
+	int32 index = _FindJob(icon, physical);
+	if (found == NULL && index >= 0 && fJobs[index].prewarm) {
+		while (_FindJob(icon, physical) >= 0)
+			pthread_cond_wait(&fStored, &fLock);
+
+		found = _Find(icon, physical, false);
+	}
+
+	if (found == NULL)
+		found = _Find(icon, physical, true);
+
+	if (found != NULL) {
+		// scaled until the exact one is there
+		if (found->size != physical) {
+			_Queue(icon, physical, false);
+			_StartWorkers();
+		}
+
+		BBitmap* bitmap = found->bitmap;
+		pthread_mutex_unlock(&fLock);
+		return bitmap;
+	}
+	pthread_mutex_unlock(&fLock);
+
+	// there's nothing to show in the meantime
+	BBitmap* bitmap = _Rasterize(icon, physical);
+
+	pthread_mutex_lock(&fLock);
+	bitmap = _Store(icon, physical, bitmap);
+	pthread_mutex_unlock(&fLock);
+
+	return bitmap;
+}
+
+
+int32
+IconCache::PhysicalSize(float size)
+{
+	pthread_mutex_lock(&fLock);
+	int32 physical = static_cast<int32>(roundf(size * fScale));
+	pthread_mutex_unlock(&fLock);
+
+	return physical;
+}
+
+
+float
+IconCache::Scale()
+{
+	pthread_mutex_lock(&fLock);
+	float scale = fScale;
+	pthread_mutex_unlock(&fLock);
+
+	return scale;
+}
+
+
+bool
+IconCache::UpdateScale()
+{
+	float scale = system_scale();
+
+	pthread_mutex_lock(&fLock);
+	if (scale == fScale) {
+		pthread_mutex_unlock(&fLock);
+		return false;
+	}
+
+	fScale = scale;
+	for (int32 icon = 0; icon < fIconCount; icon++) {
+		for (int32 x = 0; x < fSizeCount; x++) {
+			int32 physical = static_cast<int32>(roundf(fSizes[x] * fScale));
+			if (_Find(icon, physical, false) == NULL)
+				_Queue(icon, physical, false);
+		}
+	}
+	_StartWorkers();
+	pthread_mutex_unlock(&fLock);
+
+	return true;
+}
+
+
+void
+IconCache::Prewarm(const char* const* names, int32 nameCount, const float* sizes, int32 sizeCount)
+{
+	TRACE_SCOPE("IconCache::Prewarm");
+	pthread_mutex_lock(&fLock);
+	for (int32 x = 0; x < sizeCount; x++)
+		_AddSize(sizes[x]);
+
+	int32 jobCount = fJobCount;
+
+	for (int32 x = 0; x < nameCount; x++) {
+		int32 icon = _Icon(names[x]);
+		if (icon < 0)
+			continue;
+
+		for (int32 y = 0; y < sizeCount; y++) {
+			int32 physical = static_cast<int32>(roundf(sizes[y] * fScale));
+			if (_Find(icon, physical, false) == NULL)
+				_Queue(icon, physical, true);
+		}
+	}
+
+	if (fJobCount > jobCount && fPrewarmStart < 0) {
+		fPrewarmStart = system_time();
+		fPrewarmTime = -1;
+	}
+	_StartWorkers();
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+IconCache::AddWatcher(const BMessenger& watcher)
+{
+	pthread_mutex_lock(&fLock);
+	bool found = false;
+	for (int32 x = 0; x < fWatcherCount && !found; x++)
+		found = fWatchers[x] == watcher;
+
+	if (!found && fWatcherCount < kIconCacheWatchers)
+		fWatchers[fWatcherCount++] = watcher;
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+IconCache::RemoveWatcher(const BMessenger& watcher)
+{
+	pthread_mutex_lock(&fLock);
+	for (int32 x = 0; x < fWatcherCount; x++) {
+		if (fWatchers[x] == watcher) {
+			fWatchers[x] = fWatchers[--fWatcherCount];
+			break;
+		}
+	}
+	pthread_mutex_unlock(&fLock);
+}
+
+
+int64
+IconCache::HeldBytes()
+{
+	pthread_mutex_lock(&fLock);
+	int64 bytes = 0;
+	for (int32 x = 0; x < fRasterCount; x++)
+		bytes += fRasters[x].bitmap->BitsLength();
+	pthread_mutex_unlock(&fLock);
+
+	return bytes;
+}
+
+
+void
+IconCache::GetStats(icon_cache_stats& stats)
+{
+	stats.heldBytes = HeldBytes();
+
+	pthread_mutex_lock(&fLock);
+	stats.rasterCount = fRasterCount;
+	stats.workerCount = fThreadCount;
+	stats.prewarmTime = fPrewarmTime;
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void*
+IconCache::_WorkerThread(void* data)
+{
+	static_cast<IconCache*>(data)->_Work();
+	return NULL;
+}
+
+
+void
+IconCache::_Work()
+{
+	pthread_mutex_lock(&fLock);
+	while (true) {
+		int32 index = -1;
+		while (!fQuit) {
+			for (index = 0; index < fJobCount && fJobs[index].taken; index++)
+				;
+			if (index < fJobCount)
+				break;
+
+			pthread_cond_wait(&fCondition, &fLock);
+		}
+
+		if (fQuit)
+			break;
+
+		fJobs[index].taken = true;
+		job next = fJobs[index];
+		pthread_mutex_unlock(&fLock);
+
+		// the icon data doesn't change once it was loaded
+		BBitmap* bitmap = _Rasterize(next.icon, next.size);
+
+		pthread_mutex_lock(&fLock);
+		_Store(next.icon, next.size, bitmap);
+
+		// the other workers moved the jobs meanwhile
+		index = _FindJob(next.icon, next.size);
+		memmove(fJobs + index, fJobs + index + 1, (--fJobCount - index) * sizeof(job));
+		pthread_cond_broadcast(&fStored);
+
+		if (fJobCount == 0) {
+			if (fPrewarmStart >= 0) {
+				fPrewarmTime = system_time() - fPrewarmStart;
+				fPrewarmStart = -1;
+			}
+			_NotifyWatchers();
+		}
+	}
+	pthread_mutex_unlock(&fLock);
+}
+
+
+// loads the vector data the first time an icon is asked for, the lock is held
+int32
+IconCache::_Icon(const char* name)
+{
+	for (int32 x = 0; x < fIconCount; x++) {
+		if (fIcons[x].name == name)
+			return x;
+	}
+
+	if (fIconCount == kIconCacheIcons)
+		return -1;
+
+	vector_icon& entry = fIcons[fIconCount];
+	entry.name = name;
+	entry.data = NULL;
+	entry.size = 0;
+
+	// the resources are opened once for all icons
+	image_info image;
+	if (fResources == NULL && get_app_image(image) == B_OK) {
+		fFile = new BFile(image.name, B_READ_ONLY);
+		fResources = new BResources(fFile);
+	}
+
+	size_t size;
+	const void* data = fResources != NULL ? fResources->LoadResource(B_VECTOR_ICON_TYPE, name, &size) : NULL;
+	// the resources free what they loaded
+	if (data != NULL) {
+		entry.data = static_cast<uint8*>(malloc(size));
+		if (entry.data != NULL) {
+			memcpy(entry.data, data, size);
+			entry.size = size;
+		}
+	}
+
+	return fIconCount++;
+}
+
+
+IconCache::raster*
+IconCache::_Find(int32 icon, int32 size, bool nearest)
+{
+	raster* best = NULL;
+	for (int32 x = 0; x < fRasterCount; x++) {
+		raster& entry = fRasters[x];
+		if (entry.icon != icon)
+			continue;
+
+		if (entry.size == size)
+			return &entry;
+
+		if (nearest && (best == NULL || abs(entry.size - size) < abs(best->size - size)))
+			best = &entry;
+	}
+
+	return best;
+}
+
+
+// called without the lock
+BBitmap*
+IconCache::_Rasterize(int32 icon, int32 size)
+{
+	TRACE_SCOPE("IconCache::Rasterize");
+	BBitmap* bitmap = new BBitmap(BRect(0, 0, size, size), B_RGBA32);
+	if (bitmap->InitCheck() != B_OK) {
+		delete bitmap;
+		return NULL;
+	}
+
+	// an icon that's missing from the resources stays empty
+	if (fIcons[icon].data != NULL)
+		BIconUtils::GetVectorIcon(fIcons[icon].data, fIcons[icon].size, bitmap);
+
+	return bitmap;
+}
+
+
+// keeps the first bitmap for a size when two were rasterized at the same time
+BBitmap*
+IconCache::_Store(int32 icon, int32 size, BBitmap* bitmap)
+{
+	raster* found = _Find(icon, size, false);
+	if (found != NULL) {
+		delete bitmap;
+		return found->bitmap;
+	}
+
+	if (bitmap == NULL || fRasterCount == kIconCacheRasters) {
+		delete bitmap;
+		return NULL;
+	}
+
+	raster& entry = fRasters[fRasterCount++];
+	entry.icon = icon;
+	entry.size = size;
+	entry.bitmap = bitmap;
+	return bitmap;
+}
+
+
+void
+IconCache::_Queue(int32 icon, int32 size, bool prewarm)
+{
+	int32 index = _FindJob(icon, size);
+	if (index >= 0) {
+		fJobs[index].prewarm |= prewarm;
+		return;
+	}
+
+	if (fJobCount == kIconCacheJobs)
+		return;
+
+	fJobs[fJobCount].icon = icon;
+	fJobs[fJobCount].size = size;
+	fJobs[fJobCount].taken = false;
+	fJobs[fJobCount].prewarm = prewarm;
+	fJobCount++;
+}
+
+
+int32
+IconCache::_FindJob(int32 icon, int32 size)
+{
+	for (int32 x = 0; x < fJobCount; x++) {
+		if (fJobs[x].icon == icon && fJobs[x].size == size)
+			return x;
+	}
+
+	return -1;
+}
+
+
+// one worker per job up to one per CPU, they wait for more once they're started
+void
+IconCache::_StartWorkers()
+{
+	if (fJobCount == 0)
+		return;
+
+	system_info info;
+	int32 count = get_system_info(&info) == B_OK ? info.cpu_count : 1;
+	if (count > kIconCacheWorkers)
+		count = kIconCacheWorkers;
+	if (count > fJobCount)
+		count = fJobCount;
+
+	while (fThreadCount < count
+		&& pthread_create(&fThreads[fThreadCount], NULL, &_WorkerThread, this) == 0)
+		fThreadCount++;
+
+	// nobody would ever do them
+	if (fThreadCount == 0) {
+		fJobCount = 0;
+		fPrewarmStart = -1;
+		return;
+	}
+
+	pthread_cond_broadcast(&fCondition);
+}
+
+
+// the sizes a new scale has to be rasterized for, the oldest makes room
+void
+IconCache::_AddSize(float size)
+{
+	for (int32 x = 0; x < fSizeCount; x++) {
+		if (fSizes[x] == size)
+			return;
+	}
+
+	if (fSizeCount == kIconCacheSizes) {
+		memmove(fSizes, fSizes + 1, (kIconCacheSizes - 1) * sizeof(float));
+		fSizeCount--;
+	}
+
+	fSizes[fSizeCount++] = size;
+}
+
+
+// the lock is held, so a watcher with a full queue is skipped instead of
+// waited for, one that is gone is dropped
+void
+IconCache::_NotifyWatchers()
+{
+	BMessage message(kIconsChangedMessage);
+	for (int32 x = fWatcherCount - 1; x >= 0; x--) {
+		if (fWatchers[x].SendMessage(&message, (BHandler*)NULL, 0) == B_BAD_PORT_ID)
+			fWatchers[x] = fWatchers[--fWatcherCount];
+	}
+}
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _ICONCACHE_H_
+#define _ICONCACHE_H_
+
+
+#include <Messenger.h>
+#include <String.h>
+
+#include <pthread.h>
+
+class BBitmap;
+class BFile;
+class BResources;
+
+
+enum {
+	kIconsChangedMessage = 'IcGw'
+};
+
+static const int32 kIconCacheIcons = 16;
+static const int32 kIconCacheSizes = 8;		// logical sizes that were asked for
+static const int32 kIconCacheRasters = 128;
+static const int32 kIconCacheJobs = 64;
+static const int32 kIconCacheWatchers = 8;
+static const int32 kIconCacheWorkers = 4;
+
+
+struct icon_cache_stats {
+	int32		rasterCount;
+	int32		workerCount;
+	bigtime_t	prewarmTime;	// until the workers were done with the last Prewarm(), -1 while they aren't
+	int64		heldBytes;
+};
+
+
+// Rasterizes every icon once per physical size and shares the bitmaps between
+// the replicant and the forecast windows.  Sizes are asked for in logical
+// pixels, which are physical pixels for a 12 point plain font, and resolved to
+// the nearest size that was rasterized already.  When it isn't the exact one
+// a worker thread rasterizes that in the background, and the watchers get a
+// kIconsChangedMessage to ask again.  A new scale rasterizes every size that
+// was asked for again the same way, so drawing never waits for it.  Prewarm()
+// rasterizes everything ahead, spread over up to one worker per CPU, and Get()
+// waits for those instead of rasterizing them a second time.  The
+// bitmaps stay until the cache is deleted.
+class IconCache {
+public:
+							IconCache();
+							~IconCache();
+
+	static	IconCache*		Default();
+
+			// the icon to draw into PhysicalSize(size), NULL when there's none
+			BBitmap*		Get(const char* name, float size);
+			int32			PhysicalSize(float size);
+			float			Scale();
+
+			// checks the size of the plain font, returns if the scale changed
+			bool			UpdateScale();
+
+			// rasterizes every icon at every size in the background
+			void			Prewarm(const char* const* names, int32 nameCount, const float* sizes,
+								int32 sizeCount);
+
+			void			AddWatcher(const BMessenger& watcher);
+			void			RemoveWatcher(const BMessenger& watcher);
+
+			int64			HeldBytes();
+			void			GetStats(icon_cache_stats& stats);
+
+private:
+	struct vector_icon {
+		BString		name;
+		uint8*		data;		// NULL when there's no such resource
+		size_t		size;
+	};
+
+	struct raster {
+		int32		icon;
+		int32		size;
+		BBitmap*	bitmap;
+	};
+
+	struct job {
+		int32		icon;
+		int32		size;
+		bool		taken;		// a worker is rasterizing it
+		bool		prewarm;	// waited for rather than scaled from another size
+	};
+
+	static	void*			_WorkerThread(void* data);
+			void			_Work();
+			int32			_Icon(const char* name);
+			raster*			_Find(int32 icon, int32 size, bool nearest);
+			BBitmap*		_Rasterize(int32 icon, int32 size);
+			BBitmap*		_Store(int32 icon, int32 size, BBitmap* bitmap);
+			void			_Queue(int32 icon, int32 size, bool prewarm);
+			int32			_FindJob(int32 icon, int32 size);
+			void			_StartWorkers();
+			void			_AddSize(float size);
+			void			_NotifyWatchers();
+
+			pthread_mutex_t	fLock;
+			pthread_cond_t	fCondition;	// there are jobs
+			pthread_cond_t	fStored;	// a job is done
+			pthread_t		fThreads[kIconCacheWorkers];
+			int32			fThreadCount;
+			bool			fQuit;
+
+			BFile*			fFile;
+			BResources*		fResources;
+
+			bigtime_t		fPrewarmStart;	// -1 when the workers are done
+			bigtime_t		fPrewarmTime;
+
+			float			fScale;
+			vector_icon		fIcons[kIconCacheIcons];
+			int32			fIconCount;
+			raster			fRasters[kIconCacheRasters];
+			int32			fRasterCount;
+			float			fSizes[kIconCacheSizes];
+			int32			fSizeCount;
+			job				fJobs[kIconCacheJobs];
+			int32			fJobCount;
+			BMessenger		fWatchers[kIconCacheWatchers];
+			int32			fWatcherCount;
+};
+
+
+#endif // _ICONCACHE_H_
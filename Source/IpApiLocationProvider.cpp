@@ -3,35 +3,44 @@
 
 #include "IpApiLocationProvider.h"
 #include "JsonRequest.h"
+#include "NetworkMonitor.h"
+#include "Transport.h"
 
+#include <Directory.h>
+#include <Entry.h>
 #include <File.h>
 #include <FindDirectory.h>
 #include <Invoker.h>
-#include <private/netservices/UrlProtocolRoster.h>
-#include <private/netservices/UrlRequest.h>
+#include <Path.h>
 
 
 const char* kIpApiUrl = "http://ip-api.com/json/?fields=status,message,lat,lon,country,regionName,city";
 
+const char* kCacheDirectory = "DeskbarWeather";
+const char* kCacheFileName = "GeoLocation.msg";
+const char* kLegacyCacheFileName = "DeskbarWeather.GL.msg";
 
-IpApiLocationProvider::IpApiLocationProvider(BInvoker* invoker)
+const int32 kDefaultCacheLifetime = 24;
+
+
+IpApiLocationProvider::IpApiLocationProvider(BInvoker* invoker, Transport* transport, NetworkMonitor* monitor,
+	RequestStats* stats)
 	:
 	fInvoker(invoker),
-	fUrlRequest(NULL)
+	fListener(new JsonRequestListener(invoker, false, stats)),
+	fTransport(transport),
+	fMonitor(monitor),
+	fCacheLifetime(kDefaultCacheLifetime),
+	fCachedNetwork(0)
 {}
 
 
 IpApiLocationProvider::~IpApiLocationProvider()
 {
-	if (fUrlRequest != NULL) {
-		if (fUrlRequest->IsRunning())
-			fUrlRequest->Stop();
-
-		delete fUrlRequest->Output();
-		delete dynamic_cast<JsonRequestListener*>(fUrlRequest->Listener());
-	}
-	delete fUrlRequest;
+	fTransport->Cancel(fListener);
+	delete fListener;
 	delete fInvoker;
+	delete fMonitor;
 }
 
 
@@ -40,27 +49,68 @@ IpApiLocationProvider::Run(bool force)
 {
 	BMessage geoMsg;
 
-	//TODO check if cache needs to be invalidated and a new lookup performed
-	if (!force) {
-		if (_LoadCache(geoMsg) == B_OK) {
-			if (!geoMsg.HasBool(kGeoLookupCacheKey))
-				geoMsg.AddBool(kGeoLookupCacheKey, true);
+	if (!force && _LoadCache(geoMsg) == B_OK) {
+		if (!geoMsg.HasBool(kGeoLookupCacheKey))
+			geoMsg.AddBool(kGeoLookupCacheKey, true);
 
-			return fInvoker->Invoke(&geoMsg);
-		}
+		fCachedNetwork = geoMsg.GetUInt64(kGeoCacheNetworkKey, 0);
+
+		// always answer from the cache first, a revalidation will follow up with a second reply
+		status_t status = fInvoker->Invoke(&geoMsg);
+		if (_NeedsRevalidation(geoMsg))
+			_Lookup();
+
+		return status;
 	}
 
-#if B_HAIKU_VERSION > B_HAIKU_VERSION_1_BETA_5
-		BUrl url(kIpApiUrl, true);
-#else
-		BUrl url(kIpApiUrl);
-#endif
-	if (fUrlRequest == NULL)
-		fUrlRequest = BUrlProtocolRoster::MakeRequest(url, new BMallocIO(), new JsonRequestListener(fInvoker));
-	else if (fUrlRequest->IsRunning())
-		return B_ERROR; //TODO stop and restart?
-
-	return fUrlRequest->Run() < B_OK ? B_ERROR : B_OK;
+	return _Lookup();
+}
+
+
+status_t
+IpApiLocationProvider::NetworkChanged()
+{
+	if (fMonitor == NULL)
+		return B_ERROR;
+
+	uint64 network = fMonitor->Fingerprint();
+	if (network == 0 || network == fCachedNetwork)
+		return B_OK; // offline or nothing that matters has changed
+
+	return _Lookup();
+}
+
+
+void
+IpApiLocationProvider::SetCacheLifetime(int32 hours)
+{
+	if (hours > 0)
+		fCacheLifetime = hours;
+}
+
+
+NetworkMonitor*
+IpApiLocationProvider::Monitor()
+{
+	return fMonitor;
+}
+
+
+// a lookup running on the old transport is dropped
+void
+IpApiLocationProvider::SetTransport(Transport* transport)
+{
+	fTransport->Cancel(fListener);
+	fTransport = transport;
+}
+
+
+// B_BUSY while the last lookup is still running, it answers for this one as well
+status_t
+IpApiLocationProvider::_Lookup()
+{
+	status_t status = fTransport->Fetch(kIpApiUrl, fListener);
+	return status == B_OK || status == B_BUSY ? status : B_ERROR;
 }
 
 
@@ -84,42 +134,79 @@ IpApiLocationProvider::ParseResult(BMessage& data, BString& name, double* latitu
 	if (*latitude == -999.0 || *longitude == -999.0)
 		return B_ERROR;
 
-	if (cacheResult)
+	// don't refresh the timestamp of a reply that came from the cache itself
+	if (cacheResult && !data.HasBool(kGeoLookupCacheKey))
 		_SaveCache(data);
 
 	return B_OK;
 }
 
 
+bool
+IpApiLocationProvider::_NeedsRevalidation(BMessage& cache)
+{
+	int64 cacheTime = cache.GetInt64(kGeoCacheTimeKey, 0);
+	if (cacheTime <= 0 || real_time_clock() - cacheTime > (int64)fCacheLifetime * 3600)
+		return true;
+
+	if (fMonitor == NULL)
+		return false;
+
+	uint64 network = fMonitor->Fingerprint();
+	return network != 0 && network != fCachedNetwork;
+}
+
+
+status_t
+IpApiLocationProvider::_CachePath(BPath& path, bool create)
+{
+	if (find_directory(B_USER_CACHE_DIRECTORY, &path) != B_OK)
+		return B_ERROR;
+
+	path.Append(kCacheDirectory);
+	if (create && create_directory(path.Path(), 0755) != B_OK)
+		return B_ERROR;
+
+	return path.Append(kCacheFileName);
+}
+
+
 status_t
 IpApiLocationProvider::_SaveCache(BMessage& message)
 {
-	BPath prefsPath;
-	if (find_directory(B_USER_CACHE_DIRECTORY, &prefsPath) != B_OK)
+	BPath cachePath;
+	if (_CachePath(cachePath, true) != B_OK)
 		return B_ERROR;
 
-	//TODO mkdir DeskbarWeather
-	prefsPath.Append("DeskbarWeather.GL.msg");
-	BFile prefsFile;
-	if (prefsFile.SetTo(prefsPath.Path(), B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE) == B_OK)
-		return message.Flatten(&prefsFile);
+	fCachedNetwork = fMonitor != NULL ? fMonitor->Fingerprint() : 0;
 
-	return B_ERROR;
+	BMessage cache(message);
+	cache.SetInt64(kGeoCacheTimeKey, real_time_clock());
+	cache.SetUInt64(kGeoCacheNetworkKey, fCachedNetwork);
+
+	BFile cacheFile;
+	if (cacheFile.SetTo(cachePath.Path(), B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE) != B_OK)
+		return B_ERROR;
+
+	// remove the old cache file from the root of the cache directory
+	BPath legacyPath;
+	if (find_directory(B_USER_CACHE_DIRECTORY, &legacyPath) == B_OK && legacyPath.Append(kLegacyCacheFileName) == B_OK)
+		BEntry(legacyPath.Path()).Remove();
+
+	return cache.Flatten(&cacheFile);
 }
 
 
 status_t
 IpApiLocationProvider::_LoadCache(BMessage& message)
 {
-	BPath prefsPath;
-	if (find_directory(B_USER_CACHE_DIRECTORY, &prefsPath) != B_OK)
+	BPath cachePath;
+	if (_CachePath(cachePath) != B_OK)
 		return B_ERROR;
 
-	//TODO mkdir DeskbarWeather
-	prefsPath.Append("DeskbarWeather.GL.msg");
-	BFile prefsFile;
-	if (prefsFile.SetTo(prefsPath.Path(), B_READ_ONLY) == B_OK)
-		return message.Unflatten(&prefsFile);
+	BFile cacheFile;
+	if (cacheFile.SetTo(cachePath.Path(), B_READ_ONLY) == B_OK)
+		return message.Unflatten(&cacheFile);
 
 	return B_ERROR;
 }
@@ -9,35 +9,45 @@
 
 class BInvoker;
 class BMessage;
+class BPath;
 class BString;
-namespace BPrivate
-{
-namespace Network
-{
-	class BUrlRequest;
-}
-} // namespace BPrivate
-
-static const char* kGeoLookupCacheKey = "dw:GeoLookupCache";
 
+class JsonRequestListener;
+class NetworkMonitor;
+class RequestStats;
+class Transport;
 
-using namespace BPrivate::Network;
+static const char* kGeoLookupCacheKey = "dw:GeoLookupCache";
+static const char* kGeoCacheTimeKey = "dw:GeoCacheTime";
+static const char* kGeoCacheNetworkKey = "dw:GeoCacheNetwork";
 
 
 class IpApiLocationProvider {
 public:
-							IpApiLocationProvider(BInvoker* invoker);
+							IpApiLocationProvider(BInvoker* invoker, Transport* transport,
+								NetworkMonitor* monitor = NULL, RequestStats* stats = NULL);
 							~IpApiLocationProvider();
 
 			status_t		Run(bool force = false);
+			status_t		NetworkChanged();
+			void			SetCacheLifetime(int32 hours);
+			NetworkMonitor*	Monitor();
+			void			SetTransport(Transport* transport);
 			status_t		ParseResult(BMessage& data, BString& name, double* latitude, double* longitude, bool cacheResult = true);
 
 private:
+			status_t		_Lookup();
+			bool			_NeedsRevalidation(BMessage& cache);
+			status_t		_CachePath(BPath& path, bool create = false);
 			status_t		_SaveCache(BMessage& message);
 			status_t		_LoadCache(BMessage& message);
 
 		BInvoker*			fInvoker;
-		BUrlRequest*		fUrlRequest;
+		JsonRequestListener* fListener;
+		Transport*			fTransport;
+		NetworkMonitor*		fMonitor;
+		int32				fCacheLifetime;
+		uint64				fCachedNetwork;
 };
 
 #endif // _IPAPILOCATIONPROVIDER_H_
@@ -2,16 +2,25 @@
 // SPDX-FileCopyrightText: 2021 Chris Roberts
 
 #include "JsonRequest.h"
+#include "LooperWatchdog.h"
+#include "RequestStats.h"
+#include "Trace.h"
 
 #include <Invoker.h>
+#include <OS.h>
+#include <String.h>
 #include <private/netservices/HttpRequest.h>
-#include <private/netservices/UrlProtocolRoster.h>
 #include <private/shared/Json.h>
 
 
-JsonRequestListener::JsonRequestListener(BInvoker* invoker)
+using namespace BPrivate::Network;
+
+
+JsonRequestListener::JsonRequestListener(BInvoker* invoker, bool rawBody, RequestStats* stats)
 	:
-	fInvoker(invoker)
+	fInvoker(invoker),
+	fRawBody(rawBody),
+	fStats(stats)
 {}
 
 
@@ -19,26 +28,34 @@ JsonRequestListener::~JsonRequestListener() {}
 
 
 void
-JsonRequestListener::RequestCompleted(BUrlRequest* caller, bool /*success*/)
+JsonRequestListener::ExchangeCompleted(const transport_exchange& exchange)
 {
+	TRACE_SCOPE("ExchangeCompleted");
+	if (fStats != NULL)
+		fStats->AddExchange(exchange);
+
 	if (fInvoker == NULL)
 		return;
 
 	BMessage replyCopy(*fInvoker->Message());
 
-	const BHttpResult& result = dynamic_cast<const BHttpResult&>(caller->Result());
-	replyCopy.AddInt32("re:code", result.StatusCode());
-	replyCopy.AddString("re:message", result.StatusText());
-
-	if (BHttpRequest::IsSuccessStatusCode(result.StatusCode())) {
-		BMallocIO* data = dynamic_cast<BMallocIO*>(caller->Output());
-		if (data == NULL)
-			return; // TODO reset re:code and re:message ?
-
-		BPrivate::BJson::Parse(static_cast<const char*>(data->Buffer()), replyCopy);
-		data->Seek(0, SEEK_SET);
+	replyCopy.AddInt32("re:code", exchange.status);
+	replyCopy.AddString("re:message", exchange.statusText);
+
+	if (BHttpRequest::IsSuccessStatusCode(exchange.status)) {
+		if (fRawBody)
+			replyCopy.AddData("re:body", B_RAW_TYPE, exchange.body, exchange.bodySize);
+		else {
+			// the body isn't terminated
+			bigtime_t start = system_time();
+			BString body(static_cast<const char*>(exchange.body), exchange.bodySize);
+			BPrivate::BJson::Parse(body.String(), replyCopy);
+			if (fStats != NULL)
+				fStats->AddPhase(kPhaseParse, system_time() - start);
+		}
 	}
 
 	replyCopy.what = fInvoker->Message()->what; // reset ->what after BJson::Parse() messed with it
+	replyCopy.AddInt64(kMessageSentKey, system_time());
 	fInvoker->Invoke(&replyCopy);
 }
@@ -4,29 +4,24 @@
 #ifndef _JSONREQUEST_H_
 #define _JSONREQUEST_H_
 
-#include <private/netservices/UrlProtocolListener.h>
-
-namespace BPrivate
-{
-namespace Network
-{
-	class BUrlRequest;
-}
-} // namespace BPrivate
+#include "Transport.h"
 
 class BInvoker;
-class BMallocIO;
-
-using namespace BPrivate::Network;
+class RequestStats;
 
 
-class JsonRequestListener : public BUrlProtocolListener {
+// Sends the reply of a request to the invoker, either parsed into the message
+// or as the raw body in "re:body" for callers with their own parser.  The
+// timings of the request and of the parse are added to the stats.
+class JsonRequestListener : public TransportListener {
 public:
-						JsonRequestListener(BInvoker* invoker);
+						JsonRequestListener(BInvoker* invoker, bool rawBody = false, RequestStats* stats = NULL);
 	virtual				~JsonRequestListener();
-	virtual	void		RequestCompleted(BUrlRequest *caller, bool success);
+	virtual	void		ExchangeCompleted(const transport_exchange& exchange);
 private:
 			BInvoker*	fInvoker;
+			bool		fRawBody;
+			RequestStats* fStats;
 };
 
 #endif // _JSONREQUEST_H_
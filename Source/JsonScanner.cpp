@@ -0,0 +1,367 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "JsonScanner.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#	define JSON_SCANNER_SSE2
+#endif
+
+// AVX2 is picked at runtime, the rest of the app is built for the baseline CPU
+#if (defined(__x86_64__) || defined(__i386__)) \
+	&& (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#	include <immintrin.h>
+#	define JSON_SCANNER_AVX2
+#endif
+
+
+static const size_t kBlockSize = 64;
+static const uint64 kEvenBits = 0x5555555555555555ULL;
+
+
+// one bit per byte of a 64 byte block
+struct block_masks {
+	uint64	quotes;
+	uint64	backslashes;
+	uint64	operators;
+};
+
+
+struct scan_state {
+	uint64	escaped;	// the first byte of the next block is escaped
+	uint64	inString;	// all ones when the last block ended inside a string
+	uint32*	output;
+};
+
+
+static inline int
+count_trailing_zeros(uint64 value)
+{
+#if defined(__GNUC__) && __GNUC__ >= 4
+	return __builtin_ctzll(value);
+#else
+	int count = 0;
+	while ((value & 1) == 0) {
+		value >>= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+
+// marks the bytes preceded by an odd number of backslashes
+static inline uint64
+find_escaped(uint64 backslashes, uint64& carry)
+{
+	if (backslashes == 0) {
+		uint64 escaped = carry;
+		carry = 0;
+		return escaped;
+	}
+
+	// a backslash escaped from the previous block doesn't start a sequence
+	backslashes &= ~carry;
+	uint64 followsEscape = backslashes << 1 | carry;
+
+	// adding the start of each sequence that begins on an odd bit carries through the
+	// sequence, which flips the parity of the bits after it
+	uint64 oddStarts = backslashes & ~kEvenBits & ~followsEscape;
+	uint64 evenSequences = oddStarts + backslashes;
+	carry = evenSequences < oddStarts ? 1 : 0;
+
+	return (kEvenBits ^ (evenSequences << 1)) & followsEscape;
+}
+
+
+// every bit becomes the xor of itself and all bits below it
+static inline uint64
+prefix_xor(uint64 bits)
+{
+	bits ^= bits << 1;
+	bits ^= bits << 2;
+	bits ^= bits << 4;
+	bits ^= bits << 8;
+	bits ^= bits << 16;
+	bits ^= bits << 32;
+	return bits;
+}
+
+
+static inline void
+process_block(const block_masks& masks, uint32 offset, scan_state& state)
+{
+	uint64 escaped = find_escaped(masks.backslashes, state.escaped);
+	uint64 quotes = masks.quotes & ~escaped;
+
+	// the opening quote is inside the string, the closing one isn't
+	uint64 inString = prefix_xor(quotes) ^ state.inString;
+	state.inString = 0 - (inString >> 63);
+
+	uint64 structural = (masks.operators & ~inString) | quotes;
+	uint32* output = state.output;
+	while (structural != 0) {
+		*output++ = offset + count_trailing_zeros(structural);
+		structural &= structural - 1;
+	}
+	state.output = output;
+}
+
+
+static inline void
+classify_scalar(const char* block, block_masks& masks)
+{
+	masks.quotes = masks.backslashes = masks.operators = 0;
+	for (size_t x = 0; x < kBlockSize; x++) {
+		uint64 bit = 1ULL << x;
+		switch (block[x]) {
+			case '"':
+				masks.quotes |= bit;
+				break;
+			case '\\':
+				masks.backslashes |= bit;
+				break;
+			case '{':
+			case '}':
+			case '[':
+			case ']':
+			case ':':
+			case ',':
+				masks.operators |= bit;
+				break;
+		}
+	}
+}
+
+
+static void
+scan_scalar(const char* data, size_t blocks, scan_state& state)
+{
+	block_masks masks;
+	for (size_t x = 0; x < blocks; x++) {
+		classify_scalar(data + x * kBlockSize, masks);
+		process_block(masks, x * kBlockSize, state);
+	}
+}
+
+
+#if defined(JSON_SCANNER_SSE2)
+static inline void
+classify_sse2(const char* block, block_masks& masks)
+{
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+	const __m128i openBrace = _mm_set1_epi8('{');
+	const __m128i closeBrace = _mm_set1_epi8('}');
+	const __m128i colon = _mm_set1_epi8(':');
+	const __m128i comma = _mm_set1_epi8(',');
+
+	masks.quotes = masks.backslashes = masks.operators = 0;
+	for (int x = 0; x < 4; x++) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + x * 16));
+		// '[' and ']' only differ from '{' and '}' in the case bit
+		__m128i folded = _mm_or_si128(chunk, caseBit);
+		__m128i operators = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma)));
+
+		int shift = x * 16;
+		masks.quotes |= (uint64)(uint16)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)) << shift;
+		masks.backslashes |= (uint64)(uint16)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)) << shift;
+		masks.operators |= (uint64)(uint16)_mm_movemask_epi8(operators) << shift;
+	}
+}
+
+
+static void
+scan_sse2(const char* data, size_t blocks, scan_state& state)
+{
+	block_masks masks;
+	for (size_t x = 0; x < blocks; x++) {
+		classify_sse2(data + x * kBlockSize, masks);
+		process_block(masks, x * kBlockSize, state);
+	}
+}
+#endif
+
+
+#if defined(JSON_SCANNER_AVX2)
+__attribute__((target("avx2"))) static inline void
+classify_avx2(const char* block, block_masks& masks)
+{
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i caseBit = _mm256_set1_epi8(0x20);
+	const __m256i openBrace = _mm256_set1_epi8('{');
+	const __m256i closeBrace = _mm256_set1_epi8('}');
+	const __m256i colon = _mm256_set1_epi8(':');
+	const __m256i comma = _mm256_set1_epi8(',');
+
+	masks.quotes = masks.backslashes = masks.operators = 0;
+	for (int x = 0; x < 2; x++) {
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + x * 32));
+		__m256i folded = _mm256_or_si256(chunk, caseBit);
+		__m256i operators = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace), _mm256_cmpeq_epi8(folded, closeBrace)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, colon), _mm256_cmpeq_epi8(chunk, comma)));
+
+		int shift = x * 32;
+		masks.quotes |= (uint64)(uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)) << shift;
+		masks.backslashes |= (uint64)(uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslash)) << shift;
+		masks.operators |= (uint64)(uint32)_mm256_movemask_epi8(operators) << shift;
+	}
+}
+
+
+__attribute__((target("avx2"))) static void
+scan_avx2(const char* data, size_t blocks, scan_state& state)
+{
+	block_masks masks;
+	for (size_t x = 0; x < blocks; x++) {
+		classify_avx2(data + x * kBlockSize, masks);
+		process_block(masks, x * kBlockSize, state);
+	}
+}
+#endif
+
+
+static json_scan_method
+best_method()
+{
+#if defined(JSON_SCANNER_AVX2)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return JSON_SCAN_AVX2;
+#endif
+#if defined(JSON_SCANNER_SSE2)
+	return JSON_SCAN_SSE2;
+#else
+	return JSON_SCAN_SCALAR;
+#endif
+}
+
+
+JsonScanner::JsonScanner()
+	:
+	fIndex(NULL),
+	fCount(0),
+	fCapacity(0),
+	fMethod(JSON_SCAN_AUTO)
+{}
+
+
+JsonScanner::~JsonScanner()
+{
+	free(fIndex);
+}
+
+
+status_t
+JsonScanner::SetMethod(json_scan_method method)
+{
+	if (!IsSupported(method))
+		return B_NOT_SUPPORTED;
+
+	fMethod = method;
+	return B_OK;
+}
+
+
+bool
+JsonScanner::IsSupported(json_scan_method method)
+{
+	switch (method) {
+		case JSON_SCAN_AUTO:
+		case JSON_SCAN_SCALAR:
+			return true;
+		case JSON_SCAN_SSE2:
+#if defined(JSON_SCANNER_SSE2)
+			return true;
+#else
+			return false;
+#endif
+		case JSON_SCAN_AVX2:
+			return best_method() == JSON_SCAN_AVX2;
+	}
+
+	return false;
+}
+
+
+const char*
+JsonScanner::MethodName(json_scan_method method)
+{
+	switch (method) {
+		case JSON_SCAN_AUTO:
+			return MethodName(best_method());
+		case JSON_SCAN_SCALAR:
+			return "scalar";
+		case JSON_SCAN_SSE2:
+			return "sse2";
+		case JSON_SCAN_AVX2:
+			return "avx2";
+	}
+
+	return "unknown";
+}
+
+
+status_t
+JsonScanner::Scan(const char* data, size_t length)
+{
+	fCount = 0;
+
+	if (data == NULL || length == 0 || length > 0x7fffffff)
+		return B_BAD_VALUE;
+
+	// in the worst case every byte is structural
+	if (length > fCapacity) {
+		uint32* index = static_cast<uint32*>(realloc(fIndex, length * sizeof(uint32)));
+		if (index == NULL)
+			return B_NO_MEMORY;
+
+		fIndex = index;
+		fCapacity = length;
+	}
+
+	scan_state state = { 0, 0, fIndex };
+	size_t blocks = length / kBlockSize;
+
+	switch (fMethod == JSON_SCAN_AUTO ? best_method() : fMethod) {
+#if defined(JSON_SCANNER_AVX2)
+		case JSON_SCAN_AVX2:
+			scan_avx2(data, blocks, state);
+			break;
+#endif
+#if defined(JSON_SCANNER_SSE2)
+		case JSON_SCAN_SSE2:
+			scan_sse2(data, blocks, state);
+			break;
+#endif
+		default:
+			scan_scalar(data, blocks, state);
+			break;
+	}
+
+	// pad the last partial block with spaces, they are never structural
+	size_t remaining = length - blocks * kBlockSize;
+	if (remaining > 0) {
+		char tail[kBlockSize];
+		memset(tail, ' ', sizeof(tail));
+		memcpy(tail, data + blocks * kBlockSize, remaining);
+
+		block_masks masks;
+		classify_scalar(tail, masks);
+		process_block(masks, blocks * kBlockSize, state);
+	}
+
+	fCount = state.output - fIndex;
+
+	// an unterminated string runs to the end of the document
+	return state.inString == 0 ? B_OK : B_BAD_DATA;
+}
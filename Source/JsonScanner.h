@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _JSONSCANNER_H_
+#define _JSONSCANNER_H_
+
+
+#include <SupportDefs.h>
+
+
+enum json_scan_method {
+	JSON_SCAN_AUTO = 0,
+	JSON_SCAN_SCALAR,
+	JSON_SCAN_SSE2,
+	JSON_SCAN_AVX2
+};
+
+
+// Builds an index of the structural characters of a JSON document: braces,
+// brackets, colons and commas outside of strings, plus the opening and closing
+// quote of every string.  Scalars have no entry of their own, they start right
+// after the entry in front of them.  The document is classified 64 bytes at a
+// time with SIMD compares where the CPU supports them.
+class JsonScanner {
+public:
+							JsonScanner();
+							~JsonScanner();
+
+			status_t		SetMethod(json_scan_method method);
+			json_scan_method	Method() const { return fMethod; }
+	static	bool			IsSupported(json_scan_method method);
+	static	const char*		MethodName(json_scan_method method);
+
+			status_t		Scan(const char* data, size_t length);
+
+			const uint32*	Index() const { return fIndex; }
+			int32			CountIndex() const { return fCount; }
+
+private:
+			uint32*			fIndex;
+			int32			fCount;
+			size_t			fCapacity;
+			json_scan_method	fMethod;
+};
+
+#endif // _JSONSCANNER_H_
@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "LooperWatchdog.h"
+
+#include <OS.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+
+
+const char* kMessageSentKey = "dw:sent";
+
+
+static int
+compare_times(const void* first, const void* second)
+{
+	bigtime_t a = *static_cast<const bigtime_t*>(first);
+	bigtime_t b = *static_cast<const bigtime_t*>(second);
+	return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+
+LooperWatchdog::LooperWatchdog(bigtime_t budget)
+	:
+	fBudget(budget > 0 ? budget : kDefaultHandlerBudget),
+	fDepth(0),
+	fSpanCount(0),
+	fWhat(0),
+	fQueued(-1),
+	fHandled(0),
+	fQueuedCount(0),
+	fOverBudget(0),
+	fWorstHandler(NULL),
+	fWorstWhat(0),
+	fWorstDuration(0)
+{}
+
+
+void
+LooperWatchdog::SetBudget(bigtime_t budget)
+{
+	if (budget > 0)
+		fBudget = budget;
+}
+
+
+void
+LooperWatchdog::Begin(const char* handler, uint32 what, bigtime_t sent)
+{
+	bigtime_t now = system_time();
+
+	if (fDepth == 0) {
+		fSpanCount = 0;
+		fWhat = what;
+		fQueued = sent >= 0 && sent <= now ? now - sent : -1;
+	}
+
+	if (fDepth < kMaxWatchdogDepth) {
+		span& current = fStack[fDepth];
+		current.name = handler;
+		current.start = now;
+		current.duration = 0;
+		current.depth = fDepth;
+	}
+	fDepth++;
+}
+
+
+void
+LooperWatchdog::End()
+{
+	if (fDepth == 0)
+		return;
+
+	fDepth--;
+	if (fDepth >= kMaxWatchdogDepth)
+		return;
+
+	span& current = fStack[fDepth];
+	current.duration = system_time() - current.start;
+
+	if (fDepth > 0) {
+		// only needed for the warning, the first ones are kept
+		if (fSpanCount < kMaxWatchdogSpans)
+			fSpans[fSpanCount++] = current;
+		return;
+	}
+
+	fHandlerTimes[fHandled % kWatchdogWindow] = current.duration;
+	fHandled++;
+	if (fQueued >= 0)
+		fQueueTimes[fQueuedCount++ % kWatchdogWindow] = fQueued;
+
+	if (current.duration > fWorstDuration) {
+		fWorstDuration = current.duration;
+		fWorstHandler = current.name;
+		fWorstWhat = fWhat;
+	}
+
+	if (current.duration > fBudget) {
+		fOverBudget++;
+		_Warn(current);
+	}
+}
+
+
+void
+LooperWatchdog::GetStats(watchdog_stats& stats) const
+{
+	stats.handled = fHandled;
+	stats.overBudget = fOverBudget;
+	stats.budget = fBudget;
+	stats.worstHandler = fWorstHandler;
+	stats.worstWhat = fWorstWhat;
+	stats.worstDuration = fWorstDuration;
+
+	_Percentiles(fHandlerTimes, fHandled < static_cast<uint32>(kWatchdogWindow) ? fHandled : kWatchdogWindow,
+		stats.handler);
+	_Percentiles(fQueueTimes, fQueuedCount < static_cast<uint32>(kWatchdogWindow) ? fQueuedCount : kWatchdogWindow,
+		stats.queue);
+}
+
+
+// logs the message with the handlers it went through, like
+// "MessageReceived 'RqGw' took 9.1 ms: RefreshComplete 8.9 ms > ForceRefresh 0.1 ms"
+void
+LooperWatchdog::_Warn(const span& handler)
+{
+	char what[16] = "";
+	if (fWhat != 0)
+		FormatWhat(what, sizeof(what), fWhat);
+
+	char queued[32] = "";
+	if (fQueued >= 0)
+		snprintf(queued, sizeof(queued), ", queued %.1f ms", fQueued / 1000.0);
+
+	// the inner handlers end before the outer ones, show them as they started
+	char stack[256] = "";
+	size_t length = 0;
+	int32 lastDepth = 0;
+	bool used[kMaxWatchdogSpans] = {};
+	for (int32 count = 0; count < fSpanCount && length < sizeof(stack); count++) {
+		int32 next = -1;
+		for (int32 x = 0; x < fSpanCount; x++) {
+			if (!used[x] && (next < 0 || fSpans[x].start < fSpans[next].start))
+				next = x;
+		}
+		used[next] = true;
+
+		const span& inner = fSpans[next];
+		length += snprintf(stack + length, sizeof(stack) - length, "%s%s %.1f ms",
+			count == 0 ? ": " : (inner.depth > lastDepth ? " > " : ", "), inner.name, inner.duration / 1000.0);
+		lastDepth = inner.depth;
+	}
+
+	syslog(LOG_WARNING, "DeskbarWeather: %s%s%s took %.1f ms, over the %.1f ms budget%s%s", handler.name,
+		what[0] != '\0' ? " " : "", what, handler.duration / 1000.0, fBudget / 1000.0, queued, stack);
+}
+
+
+void
+LooperWatchdog::FormatWhat(char* buffer, size_t size, uint32 what)
+{
+	char code[4] = {static_cast<char>(what >> 24), static_cast<char>(what >> 16), static_cast<char>(what >> 8),
+		static_cast<char>(what)};
+	for (int32 x = 0; x < 4; x++) {
+		if (!isprint(static_cast<unsigned char>(code[x]))) {
+			snprintf(buffer, size, "0x%08x", static_cast<unsigned>(what));
+			return;
+		}
+	}
+
+	snprintf(buffer, size, "'%.4s'", code);
+}
+
+
+void
+LooperWatchdog::_Percentiles(const bigtime_t* samples, int32 count, rolling_percentiles& percentiles)
+{
+	percentiles.count = count;
+	percentiles.median = percentiles.p95 = percentiles.p99 = percentiles.max = 0;
+	if (count == 0)
+		return;
+
+	bigtime_t sorted[kWatchdogWindow];
+	memcpy(sorted, samples, count * sizeof(bigtime_t));
+	qsort(sorted, count, sizeof(bigtime_t), &compare_times);
+
+	percentiles.median = sorted[(count - 1) / 2];
+	percentiles.p95 = sorted[(count * 95 - 1) / 100];
+	percentiles.p99 = sorted[(count * 99 - 1) / 100];
+	percentiles.max = sorted[count - 1];
+}
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _LOOPERWATCHDOG_H_
+#define _LOOPERWATCHDOG_H_
+
+
+#include <SupportDefs.h>
+
+
+static const bigtime_t kDefaultHandlerBudget = 4000;
+static const int32 kWatchdogWindow = 256;
+static const int32 kMaxWatchdogDepth = 8;
+static const int32 kMaxWatchdogSpans = 16;
+
+// senders add the time they posted a message, for the queue delay
+extern const char* kMessageSentKey;
+
+
+// percentiles over the last kWatchdogWindow samples
+struct rolling_percentiles {
+	int32		count;
+	bigtime_t	median;
+	bigtime_t	p95;
+	bigtime_t	p99;
+	bigtime_t	max;
+};
+
+
+struct watchdog_stats {
+	uint32				handled;
+	uint32				overBudget;
+	bigtime_t			budget;
+	rolling_percentiles	handler;
+	rolling_percentiles	queue;
+	const char*			worstHandler;
+	uint32				worstWhat;
+	bigtime_t			worstDuration;
+};
+
+
+// Measures how long the handlers of a looper take and how long their messages
+// waited in the queue.  Handlers can nest, the outermost one is the message,
+// the inner ones show up in the warning when the message is over budget.
+// Everything happens in the thread of the looper, so there's no locking.
+class LooperWatchdog {
+public:
+								LooperWatchdog(bigtime_t budget = kDefaultHandlerBudget);
+
+			void				SetBudget(bigtime_t budget);
+			bigtime_t			Budget() const { return fBudget; }
+
+			// sent is when the message was posted, or -1 when it isn't known
+			void				Begin(const char* handler, uint32 what = 0, bigtime_t sent = -1);
+			void				End();
+
+			void				GetStats(watchdog_stats& stats) const;
+
+	// 'RqGw' for four printable characters, the number otherwise
+	static	void				FormatWhat(char* buffer, size_t size, uint32 what);
+
+private:
+	struct span {
+		const char*			name;
+		bigtime_t			start;
+		bigtime_t			duration;
+		int32				depth;
+	};
+
+			void				_Warn(const span& handler);
+	static	void				_Percentiles(const bigtime_t* samples, int32 count,
+									rolling_percentiles& percentiles);
+
+			bigtime_t			fBudget;
+
+			span				fStack[kMaxWatchdogDepth];
+			int32				fDepth;
+			span				fSpans[kMaxWatchdogSpans];
+			int32				fSpanCount;
+			uint32				fWhat;
+			bigtime_t			fQueued;
+
+			bigtime_t			fHandlerTimes[kWatchdogWindow];
+			bigtime_t			fQueueTimes[kWatchdogWindow];
+			uint32				fHandled;
+			uint32				fQueuedCount;
+			uint32				fOverBudget;
+
+			const char*			fWorstHandler;
+			uint32				fWorstWhat;
+			bigtime_t			fWorstDuration;
+};
+
+
+class WatchdogScope {
+public:
+	WatchdogScope(LooperWatchdog* watchdog, const char* handler, uint32 what = 0, bigtime_t sent = -1)
+		:
+		fWatchdog(watchdog)
+	{
+		if (fWatchdog != NULL)
+			fWatchdog->Begin(handler, what, sent);
+	}
+
+
+	~WatchdogScope()
+	{
+		if (fWatchdog != NULL)
+			fWatchdog->End();
+	}
+
+private:
+			LooperWatchdog*		fWatchdog;
+};
+
+#endif // _LOOPERWATCHDOG_H_
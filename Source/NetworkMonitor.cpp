@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "NetworkMonitor.h"
+
+#include <Messenger.h>
+#include <NetworkAddress.h>
+#include <NetworkInterface.h>
+#include <NetworkRoster.h>
+#include <String.h>
+#include <net/if.h>
+#include <private/net/net_notifications.h>
+
+
+static uint64
+hash_string(uint64 hash, const char* string)
+{
+	// FNV-1a
+	for (; *string != '\0'; string++) {
+		hash ^= static_cast<uint8>(*string);
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+
+NetworkMonitor::~NetworkMonitor() {}
+
+
+status_t
+InterfaceNetworkMonitor::StartWatching(const BMessenger& target)
+{
+	return start_watching_network(B_WATCH_NETWORK_INTERFACE_CHANGES | B_WATCH_NETWORK_LINK_CHANGES, target);
+}
+
+
+status_t
+InterfaceNetworkMonitor::StopWatching(const BMessenger& target)
+{
+	return stop_watching_network(target);
+}
+
+
+bool
+InterfaceNetworkMonitor::IsChangeMessage(const BMessage* message) const
+{
+	return message != NULL && message->what == B_NETWORK_MONITOR;
+}
+
+
+uint64
+InterfaceNetworkMonitor::Fingerprint()
+{
+	uint64 hash = 0xcbf29ce484222325ULL;
+	bool haveRoute = false;
+
+	BNetworkRoster& roster = BNetworkRoster::Default();
+	BNetworkInterface interface;
+	uint32 cookie = 0;
+	while (roster.GetNextInterface(&cookie, interface) == B_OK) {
+		uint32 flags = interface.Flags();
+		if ((flags & IFF_LOOPBACK) != 0 || (flags & IFF_UP) == 0)
+			continue;
+
+		hash = hash_string(hash, interface.Name());
+
+		// the local address set tells us which network we joined
+		for (int32 x = 0; x < interface.CountAddresses(); x++) {
+			BNetworkInterfaceAddress address;
+			if (interface.GetAddressAt(x, address) == B_OK)
+				hash = hash_string(hash, address.Address().ToString(false));
+		}
+
+		// and the default route tells us how we leave it
+		BNetworkAddress gateway;
+		if (interface.GetDefaultGateway(AF_INET, gateway) == B_OK) {
+			hash = hash_string(hash, gateway.ToString(false));
+			haveRoute = true;
+		}
+		if (interface.GetDefaultGateway(AF_INET6, gateway) == B_OK) {
+			hash = hash_string(hash, gateway.ToString(false));
+			haveRoute = true;
+		}
+	}
+
+	// without a default route we can't reach ip-api anyway
+	return haveRoute ? hash : 0;
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _NETWORKMONITOR_H_
+#define _NETWORKMONITOR_H_
+
+#include <SupportDefs.h>
+
+
+class BMessage;
+class BMessenger;
+
+
+// Watches for network configuration changes and summarizes the current
+// configuration into a fingerprint.  Subclasses can replace the default
+// interface/route based implementation.
+class NetworkMonitor {
+public:
+	virtual					~NetworkMonitor();
+
+	virtual	status_t		StartWatching(const BMessenger& target) = 0;
+	virtual	status_t		StopWatching(const BMessenger& target) = 0;
+	virtual	bool			IsChangeMessage(const BMessage* message) const = 0;
+
+	// returns 0 when no usable network configuration exists
+	virtual	uint64			Fingerprint() = 0;
+};
+
+
+class InterfaceNetworkMonitor : public NetworkMonitor {
+public:
+	virtual	status_t		StartWatching(const BMessenger& target);
+	virtual	status_t		StopWatching(const BMessenger& target);
+	virtual	bool			IsChangeMessage(const BMessage* message) const;
+	virtual	uint64			Fingerprint();
+};
+
+#endif // _NETWORKMONITOR_H_
@@ -0,0 +1,917 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "ObservationHistory.h"
+#include "ForecastParser.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static const char kHistoryMagic[4] = {'D', 'W', 'H', 'S'};
+static const char kTailMagic[4] = {'D', 'W', 'H', 'T'};
+static const size_t kFileHeaderSize = 8;
+static const int32 kStreamCount = kHistoryColumnCount + 1;
+
+
+// most significant bit first, the buffer has to be large enough
+struct bit_writer {
+	uint8*	data;
+	size_t	position;	// in bits
+
+	void
+	Write(uint32 value, int32 bits)
+	{
+		for (int32 x = bits - 1; x >= 0; x--) {
+			uint8& byte = data[position >> 3];
+			if ((position & 7) == 0)
+				byte = 0;
+			byte |= ((value >> x) & 1) << (7 - (position & 7));
+			position++;
+		}
+	}
+
+	size_t
+	Align()
+	{
+		position = (position + 7) & ~static_cast<size_t>(7);
+		return position >> 3;
+	}
+};
+
+
+struct bit_reader {
+	const uint8*	data;
+	size_t			position;
+	size_t			end;		// in bits
+
+	bool
+	Read(uint32& value, int32 bits)
+	{
+		if (position + bits > end)
+			return false;
+
+		value = 0;
+		for (int32 x = 0; x < bits; x++) {
+			value = (value << 1) | ((data[position >> 3] >> (7 - (position & 7))) & 1);
+			position++;
+		}
+		return true;
+	}
+
+	// the number of 1 bits before the next 0, at most max
+	bool
+	ReadPrefix(int32& ones, int32 max)
+	{
+		ones = 0;
+		uint32 bit;
+		while (ones < max) {
+			if (!Read(bit, 1))
+				return false;
+			if (bit == 0)
+				break;
+			ones++;
+		}
+		return true;
+	}
+};
+
+
+// the range of the delta of delta that fits behind each prefix
+static const int32 kDeltaBits[] = {0, 7, 9, 12, 32};
+static const int32 kDeltaBucketCount = 5;
+
+
+static void
+write_delta(bit_writer& writer, int32 delta)
+{
+	for (int32 bucket = 0; bucket < kDeltaBucketCount; bucket++) {
+		int32 bits = kDeltaBits[bucket];
+		if (bucket + 1 < kDeltaBucketCount
+			&& (bits == 0 ? delta != 0 : delta < -(1 << (bits - 1)) || delta >= (1 << (bits - 1))))
+			continue;
+
+		// 0, 10, 110, 1110 and 1111
+		if (bucket + 1 < kDeltaBucketCount)
+			writer.Write(((1 << bucket) - 1) << 1, bucket + 1);
+		else
+			writer.Write((1 << bucket) - 1, bucket);
+		if (bits > 0)
+			writer.Write(static_cast<uint32>(delta) & (bits == 32 ? 0xffffffff : (1u << bits) - 1), bits);
+		return;
+	}
+}
+
+
+static bool
+read_delta(bit_reader& reader, int32& delta)
+{
+	int32 bucket;
+	if (!reader.ReadPrefix(bucket, kDeltaBucketCount - 1))
+		return false;
+
+	int32 bits = kDeltaBits[bucket];
+	uint32 value = 0;
+	if (bits > 0 && !reader.Read(value, bits))
+		return false;
+
+	// sign extend
+	if (bits > 0 && bits < 32 && (value & (1u << (bits - 1))) != 0)
+		value |= ~((1u << bits) - 1);
+	delta = static_cast<int32>(value);
+	return true;
+}
+
+
+static uint32
+float_bits(float value)
+{
+	uint32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+
+static float
+bits_float(uint32 bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+
+size_t
+encode_history_block(const history_record* records, int32 count, uint8* block)
+{
+	if (count <= 0 || count > kHistoryBlockCount)
+		return 0;
+
+	history_block_header header;
+	memset(&header, 0, sizeof(header));
+	header.count = count;
+	header.flags = records[0].flags;
+	header.firstTime = records[0].time;
+	header.lastTime = records[count - 1].time;
+
+	bit_writer writer = {block, sizeof(header) * 8};
+
+	// the first time is in the header, then the first delta
+	int64 delta = 0;
+	for (int32 x = 1; x < count; x++) {
+		int64 next = records[x].time - records[x - 1].time;
+		if (x == 1)
+			writer.Write(static_cast<uint32>(next), 32);
+		else
+			write_delta(writer, static_cast<int32>(next - delta));
+		delta = next;
+	}
+	header.streamEnd[0] = writer.Align();
+
+	for (int32 column = 0; column < kHistoryColumnCount; column++) {
+		uint32 previous = float_bits(records[0].values[column]);
+		writer.Write(previous, 32);
+
+		int32 leading = -1;
+		int32 trailing = 0;
+		for (int32 x = 1; x < count; x++) {
+			uint32 value = float_bits(records[x].values[column]);
+			uint32 xored = value ^ previous;
+			previous = value;
+			if (xored == 0) {
+				writer.Write(0, 1);
+				continue;
+			}
+
+			int32 newLeading = __builtin_clz(xored);
+			int32 newTrailing = __builtin_ctz(xored);
+			if (leading >= 0 && newLeading >= leading && newTrailing >= trailing) {
+				// fits into the meaningful bits of the value before
+				writer.Write(2, 2);
+				writer.Write(xored >> trailing, 32 - leading - trailing);
+				continue;
+			}
+
+			leading = newLeading;
+			trailing = newTrailing;
+			int32 meaningful = 32 - leading - trailing;
+			writer.Write(3, 2);
+			writer.Write(leading, 5);
+			writer.Write(meaningful - 1, 5);
+			writer.Write(xored >> trailing, meaningful);
+		}
+		header.streamEnd[column + 1] = writer.Align();
+	}
+
+	header.size = header.streamEnd[kHistoryColumnCount];
+	memcpy(block, &header, sizeof(header));
+	return header.size;
+}
+
+
+int32
+decode_history_block(const uint8* block, size_t size, int32 column, int64* times, float* values)
+{
+	history_block_header header;
+	if (size < sizeof(header))
+		return -1;
+
+	memcpy(&header, block, sizeof(header));
+	if (header.size != size || header.count == 0 || header.count > kHistoryBlockCount
+		|| header.streamEnd[0] < sizeof(header) || column < 0 || column >= kHistoryColumnCount)
+		return -1;
+	for (int32 x = 1; x < kStreamCount; x++) {
+		if (header.streamEnd[x] < header.streamEnd[x - 1] || header.streamEnd[x] > size)
+			return -1;
+	}
+
+	int32 count = header.count;
+	if (times != NULL) {
+		bit_reader reader = {block, sizeof(header) * 8, header.streamEnd[0] * 8};
+		times[0] = header.firstTime;
+		int64 delta = 0;
+		for (int32 x = 1; x < count; x++) {
+			if (x == 1) {
+				uint32 first;
+				if (!reader.Read(first, 32))
+					return -1;
+				delta = static_cast<int32>(first);
+			} else {
+				int32 deltaOfDelta;
+				if (!read_delta(reader, deltaOfDelta))
+					return -1;
+				delta += deltaOfDelta;
+			}
+			times[x] = times[x - 1] + delta;
+		}
+	}
+
+	if (values != NULL) {
+		bit_reader reader = {block, header.streamEnd[column] * 8u, header.streamEnd[column + 1] * 8u};
+		uint32 previous;
+		if (!reader.Read(previous, 32))
+			return -1;
+		values[0] = bits_float(previous);
+
+		int32 leading = 0;
+		int32 trailing = 0;
+		for (int32 x = 1; x < count; x++) {
+			int32 control;
+			if (!reader.ReadPrefix(control, 2))
+				return -1;
+
+			if (control == 2) {
+				uint32 bits;
+				if (!reader.Read(bits, 5))
+					return -1;
+				leading = bits;
+				if (!reader.Read(bits, 5))
+					return -1;
+				trailing = 32 - leading - static_cast<int32>(bits + 1);
+				if (trailing < 0)
+					return -1;
+			}
+
+			if (control > 0) {
+				uint32 xored;
+				if (!reader.Read(xored, 32 - leading - trailing))
+					return -1;
+				previous ^= xored << trailing;
+			}
+			values[x] = bits_float(previous);
+		}
+	}
+
+	return count;
+}
+
+
+void
+make_history_record(const current_weather& current, bool imperial, history_record& record)
+{
+	record.time = current.time;
+	record.values[kHistoryTemperature] = current.temperature;
+	record.values[kHistoryFeelsLike] = current.apparentTemperature;
+	record.values[kHistoryHumidity] = current.humidity;
+	record.values[kHistoryWindSpeed] = current.windSpeed;
+	record.values[kHistoryWindDirection] = current.windDirection;
+	record.values[kHistoryCloudCover] = current.cloudCover;
+	record.values[kHistoryWeatherCode] = current.weatherCode;
+	record.flags = imperial ? kHistoryImperial : 0;
+}
+
+
+static float
+convert_value(int32 column, float value, bool imperial)
+{
+	switch (column) {
+		case kHistoryTemperature:
+		case kHistoryFeelsLike:
+			return imperial ? value * 9 / 5 + 32 : (value - 32) * 5 / 9;
+		case kHistoryWindSpeed:
+			return imperial ? value / 1.609344f : value * 1.609344f;
+		default:
+			return value;
+	}
+}
+
+
+ObservationHistory::ObservationHistory()
+	:
+	fFile(NULL),
+	fTailFile(NULL),
+	fFileSize(0),
+	fBlocks(NULL),
+	fBlockCount(0),
+	fBlockCapacity(0),
+	fObservationCount(0),
+	fTailCount(0),
+	fBlock(NULL),
+	fLoadedBlock(-1)
+{
+}
+
+
+ObservationHistory::~ObservationHistory()
+{
+	Close();
+	free(fBlock);
+}
+
+
+// creates the history when there's none
+status_t
+ObservationHistory::Open(const char* path)
+{
+	Close();
+
+	if (fBlock == NULL) {
+		fBlock = static_cast<uint8*>(malloc(kHistoryMaxBlockSize));
+		if (fBlock == NULL)
+			return B_NO_MEMORY;
+	}
+
+	char tailPath[PATH_MAX];
+	if (snprintf(tailPath, sizeof(tailPath), "%s.tail", path) >= static_cast<int>(sizeof(tailPath)))
+		return B_BAD_VALUE;
+
+	int64 tailSize;
+	status_t status = _OpenFile(fFile, path, kHistoryMagic, fFileSize);
+	if (status == B_OK)
+		status = _OpenFile(fTailFile, tailPath, kTailMagic, tailSize);
+	if (status == B_OK)
+		status = _ReadBlocks(fFileSize);
+	if (status == B_OK)
+		status = _ReadTail(tailSize);
+
+	if (status != B_OK)
+		Close();
+
+	return status;
+}
+
+
+void
+ObservationHistory::Close()
+{
+	if (fFile != NULL)
+		fclose(fFile);
+	if (fTailFile != NULL)
+		fclose(fTailFile);
+
+	free(fBlocks);
+	fFile = NULL;
+	fTailFile = NULL;
+	fFileSize = 0;
+	fBlocks = NULL;
+	fBlockCount = 0;
+	fBlockCapacity = 0;
+	fObservationCount = 0;
+	fTailCount = 0;
+	fLoadedBlock = -1;
+}
+
+
+status_t
+ObservationHistory::Append(const current_weather& current, bool imperial)
+{
+	history_record record;
+	make_history_record(current, imperial, record);
+	return Append(record);
+}
+
+
+status_t
+ObservationHistory::Append(const history_record& record)
+{
+	if (fFile == NULL)
+		return B_NO_INIT;
+
+	// the same observation again, or the clock went back
+	if (fObservationCount > 0 && record.time <= LastTime())
+		return B_OK;
+
+	// a block only has one kind of units
+	if (fTailCount > 0 && fTail[0].flags != record.flags) {
+		status_t status = _Seal();
+		if (status != B_OK)
+			return status;
+	}
+
+	// a block that couldn't be written before
+	if (fTailCount == kHistoryBlockCount) {
+		status_t status = _Seal();
+		if (status != B_OK)
+			return status;
+	}
+
+	if (fseek(fTailFile, 0, SEEK_END) != 0 || fwrite(&record, sizeof(record), 1, fTailFile) != 1
+		|| fflush(fTailFile) != 0)
+		return B_IO_ERROR;
+
+	fTail[fTailCount++] = record;
+	fObservationCount++;
+
+	if (fTailCount == kHistoryBlockCount)
+		return _Seal();
+
+	return B_OK;
+}
+
+
+int32
+ObservationHistory::Read(time_t start, time_t end, history_column column, bool imperial, time_t* times,
+	float* values, int32 maxCount)
+{
+	if (fFile == NULL || column < 0 || column >= kHistoryColumnCount || start > end)
+		return 0;
+
+	// the first block that ends at or after start
+	int32 low = 0;
+	int32 high = fBlockCount;
+	while (low < high) {
+		int32 middle = (low + high) / 2;
+		if (fBlocks[middle].lastTime < start)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	int32 count = 0;
+	int64 blockTimes[kHistoryBlockCount];
+	float blockValues[kHistoryBlockCount];
+	for (int32 x = low; x < fBlockCount && fBlocks[x].firstTime <= end && count < maxCount; x++) {
+		const uint8* block = _LoadBlock(x);
+		if (block == NULL
+			|| decode_history_block(block, fBlocks[x].size, column, blockTimes, blockValues) != fBlocks[x].count)
+			continue;
+
+		bool convert = ((fBlocks[x].flags & kHistoryImperial) != 0) != imperial;
+		for (int32 y = 0; y < fBlocks[x].count && count < maxCount; y++) {
+			if (blockTimes[y] < start || blockTimes[y] > end)
+				continue;
+
+			times[count] = blockTimes[y];
+			values[count] = convert ? convert_value(column, blockValues[y], imperial) : blockValues[y];
+			count++;
+		}
+	}
+
+	for (int32 x = 0; x < fTailCount && count < maxCount; x++) {
+		const history_record& record = fTail[x];
+		if (record.time < start || record.time > end)
+			continue;
+
+		bool convert = ((record.flags & kHistoryImperial) != 0) != imperial;
+		times[count] = record.time;
+		values[count] = convert ? convert_value(column, record.values[column], imperial)
+			: record.values[column];
+		count++;
+	}
+
+	return count;
+}
+
+
+int32
+ObservationHistory::CountObservations() const
+{
+	return fObservationCount;
+}
+
+
+time_t
+ObservationHistory::FirstTime() const
+{
+	if (fBlockCount > 0)
+		return fBlocks[0].firstTime;
+
+	return fTailCount > 0 ? fTail[0].time : 0;
+}
+
+
+time_t
+ObservationHistory::LastTime() const
+{
+	if (fTailCount > 0)
+		return fTail[fTailCount - 1].time;
+
+	return fBlockCount > 0 ? fBlocks[fBlockCount - 1].lastTime : 0;
+}
+
+
+int64
+ObservationHistory::DiskSize() const
+{
+	if (fFile == NULL)
+		return 0;
+
+	return fFileSize + kFileHeaderSize + fTailCount * sizeof(history_record);
+}
+
+
+// appends only, whatever is read
+status_t
+ObservationHistory::_OpenFile(FILE*& file, const char* path, const char* magic, int64& size)
+{
+	file = fopen(path, "a+b");
+	if (file == NULL)
+		return B_IO_ERROR;
+
+	long end = -1;
+	if (fseek(file, 0, SEEK_END) == 0)
+		end = ftell(file);
+	if (end < 0)
+		return B_IO_ERROR;
+
+	size = end;
+	if (size == 0) {
+		uint32 version = kHistoryVersion;
+		if (fwrite(magic, 4, 1, file) != 1 || fwrite(&version, sizeof(version), 1, file) != 1
+			|| fflush(file) != 0)
+			return B_IO_ERROR;
+
+		size = kFileHeaderSize;
+		return B_OK;
+	}
+
+	char header[kFileHeaderSize];
+	uint32 version;
+	if (size < static_cast<int64>(kFileHeaderSize) || fseek(file, 0, SEEK_SET) != 0
+		|| fread(header, kFileHeaderSize, 1, file) != 1)
+		return B_BAD_DATA;
+
+	memcpy(&version, header + 4, sizeof(version));
+	if (memcmp(header, magic, 4) != 0 || version != kHistoryVersion)
+		return B_BAD_DATA;
+
+	return B_OK;
+}
+
+
+// only the headers, a damaged block and everything behind it is cut off
+status_t
+ObservationHistory::_ReadBlocks(int64 size)
+{
+	int64 position = kFileHeaderSize;
+	while (size - position >= static_cast<int64>(sizeof(history_block_header))) {
+		history_block_header header;
+		if (fseek(fFile, position, SEEK_SET) != 0 || fread(&header, sizeof(header), 1, fFile) != 1)
+			break;
+
+		if (header.size < sizeof(header) || header.size > kHistoryMaxBlockSize || header.size > size - position
+			|| header.count == 0 || header.count > kHistoryBlockCount || header.lastTime < header.firstTime
+			|| (fBlockCount > 0 && header.firstTime <= fBlocks[fBlockCount - 1].lastTime))
+			break;
+
+		status_t status = _AddBlock(header, position);
+		if (status != B_OK)
+			return status;
+
+		position += header.size;
+	}
+
+	if (position != size) {
+		if (fflush(fFile) != 0 || ftruncate(fileno(fFile), position) != 0)
+			return B_IO_ERROR;
+	}
+
+	fFileSize = position;
+	return B_OK;
+}
+
+
+// observations that made it into a block before the tail was emptied are left out
+status_t
+ObservationHistory::_ReadTail(int64 size)
+{
+	if (fseek(fTailFile, kFileHeaderSize, SEEK_SET) != 0)
+		return B_IO_ERROR;
+
+	int32 records = (size - kFileHeaderSize) / sizeof(history_record);
+	int64 lastTime = fBlockCount > 0 ? fBlocks[fBlockCount - 1].lastTime : INT64_MIN;
+	for (int32 x = 0; x < records; x++) {
+		history_record record;
+		if (fread(&record, sizeof(record), 1, fTailFile) != 1)
+			break;
+
+		if (record.time <= lastTime || fTailCount == kHistoryBlockCount
+			|| (fTailCount > 0 && record.flags != fTail[0].flags))
+			continue;
+
+		fTail[fTailCount++] = record;
+		fObservationCount++;
+		lastTime = record.time;
+	}
+
+	int64 used = kFileHeaderSize + static_cast<int64>(records) * sizeof(history_record);
+	if (used != size) {
+		if (fflush(fTailFile) != 0 || ftruncate(fileno(fTailFile), used) != 0)
+			return B_IO_ERROR;
+	}
+
+	if (fTailCount == kHistoryBlockCount)
+		return _Seal();
+
+	return B_OK;
+}
+
+
+status_t
+ObservationHistory::_AddBlock(const history_block_header& header, int64 offset)
+{
+	if (fBlockCount == fBlockCapacity) {
+		int32 capacity = fBlockCapacity > 0 ? fBlockCapacity * 2 : 64;
+		block_entry* blocks = static_cast<block_entry*>(realloc(fBlocks, capacity * sizeof(block_entry)));
+		if (blocks == NULL)
+			return B_NO_MEMORY;
+
+		fBlocks = blocks;
+		fBlockCapacity = capacity;
+	}
+
+	block_entry& entry = fBlocks[fBlockCount++];
+	entry.firstTime = header.firstTime;
+	entry.lastTime = header.lastTime;
+	entry.offset = offset;
+	entry.size = header.size;
+	entry.count = header.count;
+	entry.flags = header.flags;
+	fObservationCount += header.count;
+
+	return B_OK;
+}
+
+
+// moves the tail into a block, then empties the tail file
+status_t
+ObservationHistory::_Seal()
+{
+	if (fTailCount == 0)
+		return B_OK;
+
+	size_t size = encode_history_block(fTail, fTailCount, fBlock);
+	fLoadedBlock = -1;
+	if (size == 0)
+		return B_ERROR;
+
+	int64 offset = fFileSize;
+	if (fseek(fFile, 0, SEEK_END) != 0 || fwrite(fBlock, size, 1, fFile) != 1 || fflush(fFile) != 0) {
+		// cut off whatever made it so the next block doesn't end up behind it
+		ftruncate(fileno(fFile), offset);
+		return B_IO_ERROR;
+	}
+
+	history_block_header header;
+	memcpy(&header, fBlock, sizeof(header));
+	fObservationCount -= fTailCount;
+	status_t status = _AddBlock(header, offset);
+	if (status != B_OK) {
+		fObservationCount += fTailCount;
+		return status;
+	}
+	fFileSize += size;
+	fLoadedBlock = fBlockCount - 1;
+	fTailCount = 0;
+
+	if (fflush(fTailFile) != 0 || ftruncate(fileno(fTailFile), kFileHeaderSize) != 0)
+		return B_IO_ERROR;
+
+	return B_OK;
+}
+
+
+const uint8*
+ObservationHistory::_LoadBlock(int32 index)
+{
+	if (index == fLoadedBlock)
+		return fBlock;
+
+	const block_entry& entry = fBlocks[index];
+	fLoadedBlock = -1;
+	if (fseek(fFile, entry.offset, SEEK_SET) != 0 || fread(fBlock, entry.size, 1, fFile) != 1)
+		return NULL;
+
+	fLoadedBlock = index;
+	return fBlock;
+}
+
+
+//	#pragma mark - HistoryRecorder
+
+
+HistoryRecorder::HistoryRecorder(int32 maxOpen)
+	:
+	fHistories(new open_history[maxOpen]),
+	fMaxOpen(maxOpen),
+	fNextOpen(0),
+	fReadIndex(0),
+	fUsed(0),
+	fRunning(false),
+	fQuit(false)
+{
+	fDirectory[0] = '\0';
+	for (int32 x = 0; x < fMaxOpen; x++) {
+		fHistories[x].history = NULL;
+		fHistories[x].name[0] = '\0';
+		fHistories[x].observations = 0;
+		fHistories[x].diskSize = 0;
+	}
+
+	pthread_mutex_init(&fLock, NULL);
+	pthread_cond_init(&fCondition, NULL);
+}
+
+
+HistoryRecorder::~HistoryRecorder()
+{
+	Close();
+	for (int32 x = 0; x < fMaxOpen; x++)
+		delete fHistories[x].history;
+	delete[] fHistories;
+	pthread_cond_destroy(&fCondition);
+	pthread_mutex_destroy(&fLock);
+}
+
+
+status_t
+HistoryRecorder::Open(const char* directory)
+{
+	Close();
+
+	if (snprintf(fDirectory, sizeof(fDirectory), "%s", directory) >= static_cast<int>(sizeof(fDirectory)))
+		return B_BAD_VALUE;
+
+	fReadIndex = 0;
+	fUsed = 0;
+	fQuit = false;
+
+	if (pthread_create(&fThread, NULL, &_WriterThread, this) != 0)
+		return B_ERROR;
+
+	fRunning = true;
+	return B_OK;
+}
+
+
+void
+HistoryRecorder::Close()
+{
+	if (!fRunning)
+		return;
+
+	pthread_mutex_lock(&fLock);
+	fQuit = true;
+	pthread_cond_signal(&fCondition);
+	pthread_mutex_unlock(&fLock);
+
+	pthread_join(fThread, NULL);
+	fRunning = false;
+}
+
+
+status_t
+HistoryRecorder::Record(const char* name, const history_record& record)
+{
+	if (strlen(name) >= kHistoryNameLength || strchr(name, '/') != NULL)
+		return B_BAD_VALUE;
+
+	pthread_mutex_lock(&fLock);
+	if (!fRunning || fQuit || fUsed == kHistoryQueueSize) {
+		pthread_mutex_unlock(&fLock);
+		return fRunning ? B_WOULD_BLOCK : B_NO_INIT;
+	}
+
+	pending_record& pending = fQueue[(fReadIndex + fUsed) % kHistoryQueueSize];
+	strcpy(pending.name, name);
+	pending.record = record;
+	fUsed++;
+
+	pthread_cond_signal(&fCondition);
+	pthread_mutex_unlock(&fLock);
+
+	return B_OK;
+}
+
+
+// of the histories that are open
+void
+HistoryRecorder::GetStats(int32& histories, int32& observations, int64& diskSize)
+{
+	histories = 0;
+	observations = 0;
+	diskSize = 0;
+
+	pthread_mutex_lock(&fLock);
+	for (int32 x = 0; x < fMaxOpen; x++) {
+		if (fHistories[x].name[0] == '\0')
+			continue;
+
+		histories++;
+		observations += fHistories[x].observations;
+		diskSize += fHistories[x].diskSize;
+	}
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void*
+HistoryRecorder::_WriterThread(void* data)
+{
+	static_cast<HistoryRecorder*>(data)->_Write();
+	return NULL;
+}
+
+
+void
+HistoryRecorder::_Write()
+{
+	// tried again for every observation when it fails
+	bool created = false;
+
+	pthread_mutex_lock(&fLock);
+	while (true) {
+		while (fUsed == 0 && !fQuit)
+			pthread_cond_wait(&fCondition, &fLock);
+
+		if (fUsed == 0)
+			break;
+
+		// Record() only adds behind the used part, so it can be written unlocked
+		const pending_record& pending = fQueue[fReadIndex];
+		pthread_mutex_unlock(&fLock);
+
+		if (!created)
+			created = mkdir(fDirectory, 0755) == 0 || errno == EEXIST;
+		if (created)
+			_Append(pending);
+
+		pthread_mutex_lock(&fLock);
+		fReadIndex = (fReadIndex + 1) % kHistoryQueueSize;
+		fUsed--;
+	}
+	pthread_mutex_unlock(&fLock);
+}
+
+
+// on the writer thread, the names and the stats are changed with the lock held
+void
+HistoryRecorder::_Append(const pending_record& pending)
+{
+	int32 index = 0;
+	while (index < fMaxOpen && strcmp(fHistories[index].name, pending.name) != 0)
+		index++;
+
+	if (index == fMaxOpen) {
+		index = fNextOpen;
+		fNextOpen = (fNextOpen + 1) % fMaxOpen;
+
+		pthread_mutex_lock(&fLock);
+		fHistories[index].name[0] = '\0';
+		pthread_mutex_unlock(&fLock);
+
+		if (fHistories[index].history == NULL)
+			fHistories[index].history = new ObservationHistory();
+
+		char path[PATH_MAX];
+		if (snprintf(path, sizeof(path), "%s/%s", fDirectory, pending.name) >= static_cast<int>(sizeof(path)))
+			return;
+
+		// tried again with the next observation
+		if (fHistories[index].history->Open(path) != B_OK)
+			return;
+	}
+
+	ObservationHistory* history = fHistories[index].history;
+	history->Append(pending.record);
+
+	pthread_mutex_lock(&fLock);
+	strcpy(fHistories[index].name, pending.name);
+	fHistories[index].observations = history->CountObservations();
+	fHistories[index].diskSize = history->DiskSize();
+	pthread_mutex_unlock(&fLock);
+}
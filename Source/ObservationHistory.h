@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _OBSERVATIONHISTORY_H_
+#define _OBSERVATIONHISTORY_H_
+
+
+#include <SupportDefs.h>
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+
+struct current_weather;
+
+
+// The history of one location is two files in host byte order, each starting
+// with 8 bytes of magic ("DWHS" and "DWHT") and a version.  The history itself
+// only ever grows by whole blocks of up to kHistoryBlockCount observations:
+//
+//	history_block_header
+//	the time stream and one stream for every column, each starting on a byte
+//
+// Times are stored as the delta of their deltas in 1 to 36 bits, values as the
+// XOR with the value before in 1 to 44 bits, so steady readings cost a bit
+// each.  Observations wait in the ".tail" file next to the history as
+// history_records until there are enough for a block.  Only the block headers
+// are read when a history is opened, a time range only decodes the blocks it
+// overlaps and of those only the times and the column asked for.
+
+static const uint32 kHistoryVersion = 1;
+static const int32 kHistoryBlockCount = 256;
+static const int32 kHistoryQueueSize = 16;
+static const size_t kHistoryNameLength = 32;
+
+enum history_column {
+	kHistoryTemperature = 0,
+	kHistoryFeelsLike,
+	kHistoryHumidity,
+	kHistoryWindSpeed,
+	kHistoryWindDirection,
+	kHistoryCloudCover,
+	kHistoryWeatherCode,
+	kHistoryColumnCount
+};
+
+enum {
+	kHistoryImperial = 0x0001	// temperatures in Fahrenheit and wind in mph
+};
+
+
+struct history_block_header {
+	uint32	size;			// the whole block
+	uint16	count;
+	uint16	flags;
+	int64	firstTime;
+	int64	lastTime;
+	uint32	streamEnd[kHistoryColumnCount + 1];	// from the start of the block, times first
+};
+
+
+struct history_record {
+	int64	time;
+	float	values[kHistoryColumnCount];	// missing values are NaN
+	uint32	flags;
+};
+
+
+// a block of count records can't be larger than this
+static const size_t kHistoryMaxBlockSize = sizeof(history_block_header)
+	+ (kHistoryColumnCount * 44 + 36) * kHistoryBlockCount / 8 + kHistoryColumnCount + 1;
+
+
+void make_history_record(const current_weather& current, bool imperial, history_record& record);
+
+// the size of the block, 0 when there are no records
+size_t encode_history_block(const history_record* records, int32 count, uint8* block);
+// the number of records, -1 when the block is damaged; times or values can be NULL
+int32 decode_history_block(const uint8* block, size_t size, int32 column, int64* times, float* values);
+
+
+// Appends the current conditions of one location and reads them back by
+// time range.  An observation with the time of one that is stored already is
+// left out, so refreshing more often than the weather changes costs nothing.
+class ObservationHistory {
+public:
+							ObservationHistory();
+							~ObservationHistory();
+
+			status_t		Open(const char* path);
+			void			Close();
+			bool			IsOpen() const { return fFile != NULL; }
+
+			status_t		Append(const current_weather& current, bool imperial);
+			status_t		Append(const history_record& record);
+
+			// the observations from start to end, both included, in the units asked for
+			int32			Read(time_t start, time_t end, history_column column, bool imperial,
+								time_t* times, float* values, int32 maxCount);
+
+			int32			CountObservations() const;
+			time_t			FirstTime() const;
+			time_t			LastTime() const;
+			int64			DiskSize() const;
+
+private:
+	struct block_entry {
+		int64		firstTime;
+		int64		lastTime;
+		int64		offset;
+		uint32		size;
+		uint16		count;
+		uint16		flags;
+	};
+
+			status_t		_OpenFile(FILE*& file, const char* path, const char* magic, int64& size);
+			status_t		_ReadBlocks(int64 size);
+			status_t		_ReadTail(int64 size);
+			status_t		_AddBlock(const history_block_header& header, int64 offset);
+			status_t		_Seal();
+			const uint8*	_LoadBlock(int32 index);
+
+			FILE*			fFile;
+			FILE*			fTailFile;
+			int64			fFileSize;
+			block_entry*	fBlocks;
+			int32			fBlockCount;
+			int32			fBlockCapacity;
+			int32			fObservationCount;
+			history_record	fTail[kHistoryBlockCount];
+			int32			fTailCount;
+			uint8*			fBlock;
+			int32			fLoadedBlock;	// the block in fBlock, -1 for none
+};
+
+// Appends observations to the histories in one directory without waiting for
+// the disk.  Record() copies the observation into a queue and a writer thread
+// appends it to the history of its name, the last few histories stay open.
+// When the queue is full the observation is dropped instead.
+class HistoryRecorder {
+public:
+								HistoryRecorder(int32 maxOpen);
+								~HistoryRecorder();
+
+			// the directory is created by the writer thread
+			status_t			Open(const char* directory);
+			// waits until everything recorded so far is written
+			void				Close();
+
+			status_t			Record(const char* name, const history_record& record);
+			void				GetStats(int32& histories, int32& observations, int64& diskSize);
+
+private:
+	struct pending_record {
+		char			name[kHistoryNameLength];
+		history_record	record;
+	};
+
+	struct open_history {
+		ObservationHistory*	history;
+		char				name[kHistoryNameLength];
+		int32				observations;
+		int64				diskSize;
+	};
+
+	static	void*				_WriterThread(void* data);
+			void				_Write();
+			void				_Append(const pending_record& pending);
+
+			char				fDirectory[PATH_MAX];
+			open_history*		fHistories;
+			int32				fMaxOpen;
+			int32				fNextOpen;	// the history to close for another name
+			pending_record		fQueue[kHistoryQueueSize];
+			int32				fReadIndex;
+			int32				fUsed;
+			bool				fRunning;
+			bool				fQuit;
+			pthread_t			fThread;
+			pthread_mutex_t		fLock;
+			pthread_cond_t		fCondition;
+};
+
+#endif // _OBSERVATIONHISTORY_H_
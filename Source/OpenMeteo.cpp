@@ -3,14 +3,18 @@
 
 #include "OpenMeteo.h"
 #include "Condition.h"
+#include "ForecastModel.h"
+#include "ForecastParser.h"
+#include "Formatters.h"
 #include "JsonRequest.h"
+#include "RequestStats.h"
+#include "Trace.h"
+#include "Transport.h"
 
-#include <DateTimeFormat.h>
-#include <File.h>
-#include <FindDirectory.h>
 #include <Invoker.h>
-#include <private/netservices/UrlProtocolRoster.h>
-#include <private/netservices/UrlRequest.h>
+#include <Url.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 const char* kOpenMeteoUrl = 
@@ -25,52 +29,69 @@ const char* kOpenMeteoUrl =
 	"&current=temperature_2m,apparent_temperature,relative_humidity_2m,wind_speed_10m,wind_direction_10m,cloud_cover,weathercode"
 	"&daily=temperature_2m_min,temperature_2m_max,weathercode";
 
+const char* kOpenMeteoHourlyUrl =
+	"&hourly=temperature_2m,precipitation_probability,wind_speed_10m,weathercode,apparent_temperature"
+	"&forecast_hours=%i";
 
-OpenMeteo::OpenMeteo(double latitude, double longitude, bool imperial, int32 forecastDays, BInvoker* invoker)
+
+OpenMeteo::OpenMeteo(double latitude, double longitude, bool imperial, int32 forecastDays, bool hourly,
+	BInvoker* invoker, Transport* transport, RequestStats* stats)
 	:
 	fCurrent(NULL),
-	fForecastList(NULL),
+	fForecast(new ForecastModel()),
+	fParser(new ForecastParser()),
+	fCurrentWeather(new current_weather),
+	fReply(NULL),
+	fReplySize(0),
+	fSpareForecast(new ForecastModel()),
+	fSpareParser(new ForecastParser()),
+	fSpareWeather(new current_weather),
+	fSpareReply(NULL),
+	fSpareReplySize(0),
 	fInvoker(invoker),
+	fListener(new JsonRequestListener(invoker, true, stats)),
+	fStats(stats),
+	fTransport(transport),
 	fLastUpdateTime(-1),
-	fApiUrl(NULL),
-	fOpenMeteoMessage(new BMessage()),
-	fUrlRequest(NULL)
+	fApiUrl(NULL)
 {
-	RebuildRequestUrl(latitude, longitude, imperial, forecastDays);
+	for (int32 x = 0; x < kConsumerCount; x++)
+		fFields[x] = 0;
+
+	RebuildRequestUrl(latitude, longitude, imperial, forecastDays, hourly);
 }
 
 
 OpenMeteo::~OpenMeteo()
 {
-	if (fUrlRequest != NULL) {
-		if (fUrlRequest->IsRunning())
-			fUrlRequest->Stop();
-
-		delete fUrlRequest->Output();
-		delete dynamic_cast<JsonRequestListener*>(fUrlRequest->Listener());
-	}
-	delete fUrlRequest;
+	fTransport->Cancel(fListener);
+	delete fListener;
 	delete fCurrent;
-	delete fForecastList;
+	delete fForecast;
+	delete fParser;
+	delete fCurrentWeather;
+	free(fReply);
+	delete fSpareForecast;
+	delete fSpareParser;
+	delete fSpareWeather;
+	free(fSpareReply);
 	delete fInvoker;
 	delete fApiUrl;
-	delete fOpenMeteoMessage;
 }
 
 
 void
-OpenMeteo::RebuildRequestUrl(double latitude, double longitude, bool imperial, int32 forecastDays)
+OpenMeteo::RebuildRequestUrl(double latitude, double longitude, bool imperial, int32 forecastDays, bool hourly)
 {
 	fImperial = imperial;
 	fForecastDays = forecastDays;
+	fHourly = hourly;
 
 	//TODO check if latitude/longitude is set
 
 	bool needRefresh = false;
 	BString urlStr;
-	// always request at least one forecast day so we can get the high/low temperature for the current day
-	urlStr.SetToFormat(kOpenMeteoUrl, latitude, longitude,
-					   imperial ? "fahrenheit" : "celsius", imperial ? "mph" : "kmh", imperial ? "inch" : "mm", fForecastDays > 0 ? fForecastDays : 1);
+	BuildRequestUrl(urlStr, latitude, longitude, imperial, forecastDays, hourly);
 
 	if (fApiUrl != NULL) {
 		if (fApiUrl->UrlString() == urlStr)
@@ -87,35 +108,46 @@ OpenMeteo::RebuildRequestUrl(double latitude, double longitude, bool imperial, i
 		new BUrl(urlStr);
 #endif
 
-	if (fUrlRequest == NULL)
-		fUrlRequest = BUrlProtocolRoster::MakeRequest(*fApiUrl, new BMallocIO(), new JsonRequestListener(fInvoker));
-	else
-		fUrlRequest->SetUrl(*fApiUrl);
-
-	if (needRefresh)
+	// a request for the old url that is still running isn't of any use
+	if (needRefresh) {
+		fTransport->Cancel(fListener);
 		Refresh();
+	}
 }
 
 
+void
+OpenMeteo::BuildRequestUrl(BString& url, double latitude, double longitude, bool imperial, int32 forecastDays,
+	bool hourly)
+{
+	// always request at least one forecast day so we can get the high/low temperature for the current day
+	url.SetToFormat(kOpenMeteoUrl, latitude, longitude,
+					imperial ? "fahrenheit" : "celsius", imperial ? "mph" : "kmh", imperial ? "inch" : "mm", forecastDays > 0 ? forecastDays : 1);
+
+	if (hourly) {
+		// cover the whole forecast, or at least the rest of today
+		BString hourlyStr;
+		int32 hours = forecastDays > 0 ? forecastDays * 24 : 24;
+		hourlyStr.SetToFormat(kOpenMeteoHourlyUrl, hours < kMaxForecastHours ? hours : kMaxForecastHours);
+		url << hourlyStr;
+	}
+}
+
+
+// B_BUSY while the last request is still running, its reply is as recent
 status_t
 OpenMeteo::Refresh()
 {
-	if (fUrlRequest->IsRunning())
-		return B_ERROR; //TODO stop and restart?
-
-	return fUrlRequest->Run() < B_OK ? B_ERROR : B_OK;
+	status_t status = fTransport->Fetch(fApiUrl->UrlString().String(), fListener);
+	return status == B_OK || status == B_BUSY ? status : B_ERROR;
 }
 
 
 status_t
 OpenMeteo::LastUpdate(BString& output, bool longFormat)
 {
-	if (longFormat)
-		BDateTimeFormat().Format(output, fLastUpdateTime, B_FULL_DATE_FORMAT, B_SHORT_TIME_FORMAT);
-	else
-		BDateTimeFormat().Format(output, fLastUpdateTime, B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT);
-
-	return B_OK;
+	return format_date_time(output, fLastUpdateTime, longFormat ? B_FULL_DATE_FORMAT : B_SHORT_DATE_FORMAT,
+		B_SHORT_TIME_FORMAT);
 }
 
 
@@ -126,6 +158,15 @@ OpenMeteo::Invoker()
 }
 
 
+// a request running on the old transport is dropped
+void
+OpenMeteo::SetTransport(Transport* transport)
+{
+	fTransport->Cancel(fListener);
+	fTransport = transport;
+}
+
+
 Condition*
 OpenMeteo::Current()
 {
@@ -133,10 +174,18 @@ OpenMeteo::Current()
 }
 
 
-BObjectList<Condition>*
+// the current conditions as they were in the last reply
+const current_weather*
+OpenMeteo::CurrentWeather()
+{
+	return fCurrent != NULL ? fCurrentWeather : NULL;
+}
+
+
+ForecastModel*
 OpenMeteo::Forecast()
 {
-	return fForecastList;
+	return fForecast;
 }
 
 
@@ -150,235 +199,101 @@ OpenMeteo::IsImperial()
 status_t
 OpenMeteo::ParseResult(BMessage& data)
 {
-	fOpenMeteoMessage->MakeEmpty();
-	*fOpenMeteoMessage = data;
-
-#if defined(DEBUG)
-	BPath prefsPath;
-	if (find_directory(B_USER_SETTINGS_DIRECTORY, &prefsPath) == B_OK) {
-		prefsPath.Append("DeskbarWeatherSettings.OW.msg");
-		BFile prefsFile;
-		if (prefsFile.SetTo(prefsPath.Path(), B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE) == B_OK)
-			fOpenMeteoMessage->Flatten(&prefsFile);
-	}
-#endif
-
-	BMessage message, unitsMessage;
-
-	if (fOpenMeteoMessage->FindMessage("current_units", &unitsMessage) != B_OK)
+	TRACE_SCOPE("ParseResult");
+	const void* body;
+	ssize_t size;
+	if (data.FindData("re:body", B_RAW_TYPE, &body, &size) != B_OK || size <= 0)
 		return B_ERROR;
 
-	if (fOpenMeteoMessage->FindMessage("current", &message) != B_OK)
-		return B_ERROR;
+	// the parser refers to the reply for everything it doesn't decode right away,
+	// a bad reply leaves the last one, its parser and its forecast alone
+	if (static_cast<size_t>(size) > fSpareReplySize) {
+		char* reply = static_cast<char*>(realloc(fSpareReply, size));
+		if (reply == NULL)
+			return B_NO_MEMORY;
 
-	if (_ParseCurrent(message) != B_OK)
-		return B_ERROR;
+		fSpareReply = reply;
+		fSpareReplySize = size;
+	}
+	memcpy(fSpareReply, body, size);
 
-	message.MakeEmpty();
-	if (fOpenMeteoMessage->FindMessage("daily", &message) != B_OK)
-		return B_ERROR;
+	uint32 fields = 0;
+	for (int32 x = 0; x < kConsumerCount; x++)
+		fields |= fFields[x];
 
-	if (_ParseForecast(message) != B_OK)
+	bigtime_t start = system_time();
+	if (fSpareParser->Parse(fSpareReply, size, fForecastDays, fHourly, fields, *fSpareWeather,
+			*fSpareForecast) != B_OK)
 		return B_ERROR;
 
+	_SwapSpare();
+	_UpdateCurrent();
 	fLastUpdateTime = fCurrent->Day();
 
+	if (fStats != NULL)
+		fStats->AddPhase(kPhaseParse, system_time() - start);
+
 	return B_OK;
 }
 
 
 void
-OpenMeteo::_ResetConditions()
+OpenMeteo::SetFields(weather_consumer consumer, uint32 fields)
 {
-	delete fCurrent;
-	delete fForecastList;
-
-	fCurrent = new Condition();
-	fForecastList =
-#if B_HAIKU_VERSION > B_HAIKU_VERSION_1_BETA_5
-		new BObjectList<Condition>(6);
-#else
-		new BObjectList<Condition>(6, true);
-#endif
+	if (consumer < kConsumerCount)
+		fFields[consumer] = fields;
 }
 
 
+// decodes what a consumer registered after the last reply was parsed
 status_t
-OpenMeteo::_ParseCurrent(BMessage& data)
+OpenMeteo::Require(weather_consumer consumer)
 {
-	fCurrent = new Condition();
-	fCurrent->SetTemp(data.GetDouble("temperature_2m", -99.0));
-	fCurrent->SetTemp(data.GetDouble("apparent_temperature", -99.0), true);
-	fCurrent->SetHumidity(data.GetDouble("relative_humidity_2m", -99.0) / 100);
-	fCurrent->SetWind(data.GetDouble("wind_speed_10m", -99.0));
-	fCurrent->SetWindDirection(data.GetDouble("wind_direction_10m", -99.0));
-	fCurrent->SetCloudCover(data.GetDouble("cloud_cover", -99.0));
-	fCurrent->SetDay(data.GetDouble("time", -9999));
-
-	int32 weathercode = static_cast<int32>(data.GetDouble("weathercode", -99.0));
-	return _ParseWeatherCode(*fCurrent, weathercode);
+	if (consumer >= kConsumerCount)
+		return B_BAD_VALUE;
+
+	uint32 decoded = fParser->DecodedFields();
+	if ((fFields[consumer] & ~decoded) == 0)
+		return B_OK;
+
+	status_t status = fParser->Decode(fFields[consumer], *fCurrentWeather, *fForecast);
+	if (fParser->DecodedFields() != decoded)
+		_UpdateCurrent();
+
+	return status;
 }
 
 
-status_t
-OpenMeteo::_ParseForecast(BMessage& data)
+void
+OpenMeteo::_SwapSpare()
 {
-	fForecastList =
-#if B_HAIKU_VERSION > B_HAIKU_VERSION_1_BETA_5
-		new BObjectList<Condition>(6);
-#else
-		new BObjectList<Condition>(6, true);
-#endif
-
-	BMessage timeMessage, tempMinMessage, tempMaxMessage, codeMessage;
-	if (data.FindMessage("time", &timeMessage) != B_OK
-		|| data.FindMessage("temperature_2m_min", &tempMinMessage)
-		|| data.FindMessage("temperature_2m_max", &tempMaxMessage)
-		|| data.FindMessage("weathercode", &codeMessage))
-		return B_ERROR;
+	ForecastModel* forecast = fForecast;
+	fForecast = fSpareForecast;
+	fSpareForecast = forecast;
 
-	fCurrent->SetLow(tempMinMessage.GetDouble("0", -99));
-	fCurrent->SetHigh(tempMaxMessage.GetDouble("0", -99));
+	ForecastParser* parser = fParser;
+	fParser = fSpareParser;
+	fSpareParser = parser;
 
-	// return now if we only needed the daily high/low
-	if (fForecastDays == 0)
-		return B_OK;
+	current_weather* current = fCurrentWeather;
+	fCurrentWeather = fSpareWeather;
+	fSpareWeather = current;
 
-	BString dayStr("0");
-	for (int32 idx = 0; timeMessage.HasDouble(dayStr); idx++) {
-		Condition* condition = new Condition();
-		condition->SetDay(timeMessage.GetDouble(dayStr, -99999));
-		condition->SetLow(tempMinMessage.GetDouble(dayStr, -999.0));
-		condition->SetHigh(tempMaxMessage.GetDouble(dayStr, -999.0));
-		int32 weathercode = static_cast<int32>(codeMessage.GetDouble(dayStr, -99.0));
-		_ParseWeatherCode(*condition, weathercode);
-		fForecastList->AddItem(condition);
-
-		dayStr.Truncate(0);
-		dayStr << idx + 1;
-	}
+	char* reply = fReply;
+	fReply = fSpareReply;
+	fSpareReply = reply;
 
-	return B_OK;
+	size_t replySize = fReplySize;
+	fReplySize = fSpareReplySize;
+	fSpareReplySize = replySize;
 }
 
 
-status_t
-OpenMeteo::_ParseWeatherCode(Condition& condition, int32 weathercode)
+void
+OpenMeteo::_UpdateCurrent()
 {
-	switch (weathercode) {
-		case 0:
-			condition.SetForecast("Clear sky");
-			condition.SetIcon("sunny");
-			break;
-		case 1:
-			condition.SetForecast("Mainly clear");
-			condition.SetIcon("partlycloudy");
-			break;
-		case 2:
-			condition.SetForecast("Partly cloudy");
-			condition.SetIcon("partlycloudy");
-			break;
-		case 3:
-			condition.SetForecast("Overcast");
-			condition.SetIcon("cloudy");
-			break;
-		case 45:
-			condition.SetForecast("Fog");
-			condition.SetIcon("cloudy");
-			break;
-		case 48:
-			condition.SetForecast("Rime fog");
-			condition.SetIcon("cloudy");
-			break;
-		case 51:
-			condition.SetForecast("Light drizzle");
-			condition.SetIcon("rain");
-			break;
-		case 53:
-			condition.SetForecast("Drizzle");
-			condition.SetIcon("rain");
-			break;
-		case 55:
-			condition.SetForecast("Dense drizzle");
-			condition.SetIcon("rain");
-			break;
-		case 56:
-			condition.SetForecast("Light Freezing drizzle");
-			condition.SetIcon("rain");
-			break;
-		case 57:
-			condition.SetForecast("Dense Freezing drizzle");
-			condition.SetIcon("rain");
-			break;
-		case 61:
-			condition.SetForecast("Slight rain");
-			condition.SetIcon("rain");
-			break;
-		case 63:
-			condition.SetForecast("Rain");
-			condition.SetIcon("rain");
-			break;
-		case 65:
-			condition.SetForecast("Heavy rain");
-			condition.SetIcon("rain");
-			break;
-		case 66:
-			condition.SetForecast("Light freezing rain");
-			condition.SetIcon("rain");
-			break;
-		case 67:
-			condition.SetForecast("Heavy freezing rain");
-			condition.SetIcon("rain");
-			break;
-		case 71:
-			condition.SetForecast("Slight snow");
-			condition.SetIcon("snow");
-			break;
-		case 73:
-			condition.SetForecast("Snow");
-			condition.SetIcon("snow");
-			break;
-		case 75:
-			condition.SetForecast("Heavy snow");
-			condition.SetIcon("snow");
-			break;
-		case 77:
-			condition.SetForecast("Snow grains");
-			condition.SetIcon("snow");
-			break;
-		case 80:
-			condition.SetForecast("Slight rain showers");
-			condition.SetIcon("rain");
-			break;
-		case 81:
-			condition.SetForecast("Rain showers");
-			condition.SetIcon("rain");
-			break;
-		case 82:
-			condition.SetForecast("Violent rain showers");
-			condition.SetIcon("rain");
-			break;
-		case 85:
-			condition.SetForecast("Slight snow showers");
-			condition.SetIcon("snow");
-			break;
-		case 86:
-			condition.SetForecast("Heavy snow showers");
-			condition.SetIcon("snow");
-			break;
-		case 95:
-			condition.SetForecast("Thunderstorm");
-			condition.SetIcon("thunderstorm");
-			break;
-		case 96:
-			condition.SetForecast("Thunderstorm with slight hail");
-			condition.SetIcon("thunderstorm");
-			break;
-		case 99:
-			condition.SetForecast("Thunderstorm with heavy hail");
-			condition.SetIcon("thunderstorm");
-			break;
-	}
+	if (fCurrent == NULL)
+		fCurrent = new Condition();
 
-	return B_OK;
+	fCurrent->SetTo(*fCurrentWeather);
 }
@@ -4,59 +4,85 @@
 #ifndef _OPENMETEO_H_
 #define _OPENMETEO_H_
 
-#include <ObjectList.h>
 #include <kernel/OS.h>
 
 class Condition;
+class ForecastModel;
+class ForecastParser;
+class JsonRequestListener;
+class RequestStats;
+class Transport;
+struct current_weather;
 
 class BInvoker;
 class BMessage;
 class BString;
 class BUrl;
-namespace BPrivate
-{
-namespace Network
-{
-	class BUrlRequest;
-}
-} // namespace BPrivate
 
 
-using namespace BPrivate::Network;
+// everything that shows weather registers the forecast fields it uses
+enum weather_consumer {
+	kConsumerReplicant = 0,
+	kConsumerToolTip,
+	kConsumerNotification,
+	kConsumerForecastWindow,
+	kConsumerHistory,
+	kConsumerCount
+};
 
 
 class OpenMeteo {
 public:
 
-						OpenMeteo(double latitude, double longitude, bool imperial, int32 forecastDays, BInvoker* invoker);
+						OpenMeteo(double latitude, double longitude, bool imperial, int32 forecastDays, bool hourly,
+							BInvoker* invoker, Transport* transport, RequestStats* stats = NULL);
 						~OpenMeteo();
 
 	status_t			Refresh();
-	void				RebuildRequestUrl(double latitude, double longitude, bool imperial, int32 forecastDays);
+	void				RebuildRequestUrl(double latitude, double longitude, bool imperial, int32 forecastDays,
+							bool hourly);
+	static void			BuildRequestUrl(BString& url, double latitude, double longitude, bool imperial,
+							int32 forecastDays, bool hourly);
 	BInvoker*			Invoker();
+	void				SetTransport(Transport* transport);
 	Condition*			Current();
+	const current_weather*	CurrentWeather();
 	status_t			LastUpdate(BString& output, bool longFormat = false);
-	BObjectList<Condition>*	Forecast();
+	ForecastModel*		Forecast();
 	status_t			ParseResult(BMessage& data);
 	bool				IsImperial();
 
+	void				SetFields(weather_consumer consumer, uint32 fields);
+	status_t			Require(weather_consumer consumer);
+
 private:
 
-	status_t			_ParseCurrent(BMessage& data);
-	status_t			_ParseForecast(BMessage& data);
-	status_t			_ParseWeatherCode(Condition& condition, int32 weathercode);
-	void				_ResetConditions();
 	void				_SetUpdateTime(bigtime_t);
+	void				_UpdateCurrent();
+	void				_SwapSpare();
 
 	Condition*				fCurrent;
-	BObjectList<Condition>*	fForecastList;
+	ForecastModel*			fForecast;
+	ForecastParser*			fParser;
+	current_weather*		fCurrentWeather;
+	char*					fReply;
+	size_t					fReplySize;
+	// a reply is parsed into these and only swapped in when it was good
+	ForecastModel*			fSpareForecast;
+	ForecastParser*			fSpareParser;
+	current_weather*		fSpareWeather;
+	char*					fSpareReply;
+	size_t					fSpareReplySize;
+	uint32					fFields[kConsumerCount];
 	BInvoker*				fInvoker;
+	JsonRequestListener*	fListener;
+	RequestStats*			fStats;
+	Transport*				fTransport;
 	time_t					fLastUpdateTime;
 	BUrl*					fApiUrl;
-	BMessage*				fOpenMeteoMessage;
-	BUrlRequest*			fUrlRequest;
 	bool					fImperial;
 	int32					fForecastDays;
+	bool					fHourly;
 };
 
 
@@ -0,0 +1,426 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "PlaceIndex.h"
+#include "AppImage.h"
+
+#include <Path.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <private/shared/AutoLocker.h>
+
+
+const double kEarthRadius = 6371.0088;
+
+
+PlaceIndex::PlaceIndex(const char* path)
+	:
+	fPath(path),
+	fLock("place index lock"),
+	fStatus(B_NO_INIT),
+	fArea(NULL),
+	fAreaSize(0),
+	fHeader(NULL),
+	fPlaces(NULL),
+	fNames(NULL),
+	fNamesSize(0),
+	fTree(NULL),
+	fKeys(NULL),
+	fKeyBlocks(NULL),
+	fTrie(NULL),
+	fTrieCount(0)
+{}
+
+
+PlaceIndex::~PlaceIndex()
+{
+	if (fArea != NULL)
+		munmap(fArea, fAreaSize);
+}
+
+
+PlaceIndex*
+PlaceIndex::Default()
+{
+	// nothing is mapped until the first lookup
+	static PlaceIndex sDefaultIndex;
+	return &sDefaultIndex;
+}
+
+
+int32
+PlaceIndex::CountPlaces()
+{
+	if (_Map() != B_OK)
+		return 0;
+
+	return fHeader->place_count;
+}
+
+
+status_t
+PlaceIndex::FindNearest(double latitude, double longitude, place_info& place, double* distance)
+{
+	if (_Map() != B_OK)
+		return fStatus;
+
+	if (fHeader->place_count == 0)
+		return B_ENTRY_NOT_FOUND;
+
+	double radLatitude = latitude * M_PI / 180.0;
+	double radLongitude = longitude * M_PI / 180.0;
+	float query[3] = {
+		static_cast<float>(cos(radLatitude) * cos(radLongitude)),
+		static_cast<float>(cos(radLatitude) * sin(radLongitude)),
+		static_cast<float>(sin(radLatitude))
+	};
+
+	int32 best = -1;
+	float bestDistance = 5.0f; // larger than any squared chord on the unit sphere
+	_SearchTree(0, fHeader->place_count, 0, query, best, bestDistance);
+	if (best < 0)
+		return B_ENTRY_NOT_FOUND;
+
+	_GetPlace(fTree[best].place, place);
+
+	if (distance != NULL) {
+		double chord = sqrt(bestDistance);
+		*distance = 2.0 * asin(chord > 2.0 ? 1.0 : chord / 2.0) * kEarthRadius;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+PlaceIndex::GetPlaceName(double latitude, double longitude, BString& name, double maxDistance)
+{
+	place_info place;
+	double distance;
+	status_t status = FindNearest(latitude, longitude, place, &distance);
+	if (status != B_OK)
+		return status;
+
+	if (distance > maxDistance)
+		return B_ENTRY_NOT_FOUND;
+
+	GetDisplayName(place, name);
+	return B_OK;
+}
+
+
+void
+PlaceIndex::GetDisplayName(const place_info& place, BString& name)
+{
+	// match the "city, region" style of the geolocation lookup
+	name = place.name;
+	if (place.region[0] != '\0' && strcmp(place.region, place.name) != 0)
+		name << ", " << place.region;
+}
+
+
+int32
+PlaceIndex::Search(const char* text, place_info* places, int32 maxCount)
+{
+	if (text == NULL || places == NULL || maxCount <= 0 || _Map() != B_OK)
+		return 0;
+
+	// the search sections are optional, only the nearest place lookup needs the others
+	if (fKeys == NULL || fKeyBlocks == NULL || fTrie == NULL)
+		return 0;
+
+	char key[256];
+	int32 length = 0;
+	for (; text[length] != '\0' && length < (int32)sizeof(key) - 1; length++)
+		key[length] = place_key_fold(text[length]);
+	key[length] = '\0';
+
+	if (length == 0)
+		return 0;
+
+	// walk the trie as far as it goes, short prefixes are answered from it directly
+	const place_trie_node* node = fTrie;
+	for (int32 depth = 0; depth < length && depth < kPlaceTrieDepth; depth++) {
+		const place_trie_node* child = NULL;
+		for (uint32 x = 0; x < node->child_count; x++) {
+			const place_trie_node* candidate = fTrie + node->first_child + x;
+			if (node->first_child + x < fTrieCount && candidate->character == key[depth]) {
+				child = candidate;
+				break;
+			}
+		}
+
+		if (child == NULL)
+			return 0;
+
+		node = child;
+	}
+
+	int32 count = 0;
+	if (length <= kPlaceTrieDepth) {
+		for (; count < node->top_count && count < maxCount; count++)
+			_GetPlace(node->top[count], places[count]);
+
+		return count;
+	}
+
+	uint32 low = _FindKey(key, length, node->low, node->high, false);
+	uint32 high = _FindKey(key, length, low, node->high, true);
+
+	// keep the most populous matches, the result list is short so insertion is fine
+	uint32 ranked[kPlaceTrieTopCount * 4];
+	int32 rankedMax = maxCount < (int32)(sizeof(ranked) / sizeof(ranked[0]))
+		? maxCount : sizeof(ranked) / sizeof(ranked[0]);
+	for (uint32 x = low; x < high; x++) {
+		uint32 population = fPlaces[x].population;
+		if (count == rankedMax && fPlaces[ranked[count - 1]].population >= population)
+			continue;
+
+		int32 position = count < rankedMax ? count++ : count - 1;
+		while (position > 0 && fPlaces[ranked[position - 1]].population < population) {
+			ranked[position] = ranked[position - 1];
+			position--;
+		}
+		ranked[position] = x;
+	}
+
+	for (int32 x = 0; x < count; x++)
+		_GetPlace(ranked[x], places[x]);
+
+	return count;
+}
+
+
+status_t
+PlaceIndex::_Map()
+{
+	AutoLocker<BLocker> locker(fLock);
+	if (fStatus != B_NO_INIT)
+		return fStatus;
+
+	fStatus = B_ERROR;
+
+	if (fPath.IsEmpty()) {
+		BPath dataPath;
+#if defined(PACKAGE_DATA_DIR)
+		dataPath.SetTo(PACKAGE_DATA_DIR);
+#else
+		image_info image;
+		if (get_app_image(image) != B_OK)
+			return fStatus;
+
+		BPath exePath(image.name);
+		exePath.GetParent(&dataPath);
+		dataPath.Append("Data");
+#endif
+		dataPath.Append("Places.idx");
+		fPath = dataPath.Path();
+	}
+
+	int fd = open(fPath.String(), O_RDONLY);
+	if (fd < 0)
+		return fStatus;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(place_index_header)) {
+		close(fd);
+		return fStatus;
+	}
+
+	fAreaSize = info.st_size;
+	fArea = mmap(NULL, fAreaSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (fArea == MAP_FAILED) {
+		fArea = NULL;
+		return fStatus;
+	}
+
+	fHeader = static_cast<const place_index_header*>(fArea);
+	if (fHeader->magic != kPlaceIndexMagic || fHeader->version != kPlaceIndexVersion
+		|| fHeader->section_count > (uint32)kPlaceIndexMaxSections)
+		return fStatus;
+
+	fPlaces = static_cast<const place_record*>(_FindSection(kPlaceSection, sizeof(place_record)));
+	fTree = static_cast<const place_tree_node*>(_FindSection(kPlaceTreeSection, sizeof(place_tree_node)));
+	fNames = static_cast<const char*>(_FindSection(kPlaceNameSection, 0));
+	if (fPlaces == NULL || fTree == NULL || fNames == NULL)
+		return fStatus;
+
+	uint32 blockCount = (fHeader->place_count + kPlaceKeyBlockSize - 1) / kPlaceKeyBlockSize;
+	fKeys = static_cast<const char*>(_FindSection(kPlaceKeySection, 0));
+	fKeyBlocks = static_cast<const uint32*>(_FindSection(kPlaceKeyBlockSection, 0));
+	fTrie = static_cast<const place_trie_node*>(_FindSection(kPlaceTrieSection, 0));
+	for (uint32 x = 0; x < fHeader->section_count; x++) {
+		if (fHeader->sections[x].type == kPlaceTrieSection)
+			fTrieCount = fHeader->sections[x].size / sizeof(place_trie_node);
+		else if (fHeader->sections[x].type == kPlaceKeyBlockSection
+			&& fHeader->sections[x].size < blockCount * sizeof(uint32))
+			fKeyBlocks = NULL;
+	}
+	if (fTrieCount == 0)
+		fTrie = NULL;
+
+	// every string has to end inside the name section and every place index must exist
+	uint32 count = fHeader->place_count;
+	if (fNamesSize == 0 || fNames[fNamesSize - 1] != '\0')
+		return fStatus;
+	for (uint32 x = 0; x < count; x++) {
+		if (fTree[x].place >= count)
+			return fStatus;
+	}
+	for (uint32 x = 0; x < fTrieCount; x++) {
+		const place_trie_node& node = fTrie[x];
+		if (node.low > node.high || node.high > count || node.top_count > kPlaceTrieTopCount)
+			return fStatus;
+		for (uint32 y = 0; y < node.top_count; y++) {
+			if (node.top[y] >= count)
+				return fStatus;
+		}
+	}
+
+	fStatus = B_OK;
+	return fStatus;
+}
+
+
+const void*
+PlaceIndex::_FindSection(uint32 type, size_t elementSize)
+{
+	for (uint32 x = 0; x < fHeader->section_count; x++) {
+		const place_index_section& section = fHeader->sections[x];
+		if (section.type != type)
+			continue;
+
+		if ((uint64)section.offset + section.size > fAreaSize)
+			return NULL;
+
+		// sections holding one entry per place must be complete
+		if (elementSize != 0 && section.size < (uint64)elementSize * fHeader->place_count)
+			return NULL;
+
+		if (type == kPlaceNameSection)
+			fNamesSize = section.size;
+
+		return static_cast<const uint8*>(fArea) + section.offset;
+	}
+
+	return NULL;
+}
+
+
+void
+PlaceIndex::_GetPlace(uint32 index, place_info& place)
+{
+	place.name = place.region = place.country = "";
+	if (index >= fHeader->place_count) {
+		place.latitude = place.longitude = 0;
+		place.population = 0;
+		return;
+	}
+
+	const place_record& record = fPlaces[index];
+	place.latitude = record.latitude;
+	place.longitude = record.longitude;
+	place.population = record.population;
+
+	// the generator writes three strings per place, _Map() checked the section ends with a NUL
+	size_t offset = record.name;
+	if (offset >= fNamesSize)
+		return;
+	place.name = fNames + offset;
+
+	offset += strlen(place.name) + 1;
+	if (offset >= fNamesSize)
+		return;
+	place.region = fNames + offset;
+
+	offset += strlen(place.region) + 1;
+	if (offset < fNamesSize)
+		place.country = fNames + offset;
+}
+
+
+uint32
+PlaceIndex::_FindKey(const char* key, int32 length, uint32 low, uint32 high, bool upper)
+{
+	// first place in [low, high) whose key is not before the prefix, or after it when upper is set
+	uint32 firstBlock = low / kPlaceKeyBlockSize;
+	uint32 lastBlock = (high + kPlaceKeyBlockSize - 1) / kPlaceKeyBlockSize;
+
+	// binary search the complete keys at the start of each block
+	while (lastBlock - firstBlock > 1) {
+		uint32 middle = (firstBlock + lastBlock) / 2;
+		int compare = strncmp(fKeys + fKeyBlocks[middle], key, length);
+		if (compare < 0 || (upper && compare == 0))
+			firstBlock = middle;
+		else
+			lastBlock = middle;
+	}
+
+	// then decode the front coded keys of that block
+	char current[256];
+	const char* data = fKeys + fKeyBlocks[firstBlock];
+	uint32 index = firstBlock * kPlaceKeyBlockSize;
+	uint32 end = index + kPlaceKeyBlockSize;
+	if (end > high)
+		end = high;
+
+	strlcpy(current, data, sizeof(current));
+	data += strlen(data) + 1;
+	for (; index < end; index++) {
+		if (index > firstBlock * kPlaceKeyBlockSize) {
+			uint8 shared = *data++;
+			strlcpy(current + shared, data, sizeof(current) - shared);
+			data += strlen(data) + 1;
+		}
+
+		if (index < low)
+			continue;
+
+		int compare = strncmp(current, key, length);
+		if (compare > 0 || (!upper && compare == 0))
+			return index;
+	}
+
+	return end;
+}
+
+
+void
+PlaceIndex::_SearchTree(int32 low, int32 high, int32 depth, const float query[3], int32& best,
+	float& bestDistance)
+{
+	if (low >= high)
+		return;
+
+	int32 middle = (low + high) / 2;
+	const place_tree_node& node = fTree[middle];
+
+	float dx = query[0] - node.x;
+	float dy = query[1] - node.y;
+	float dz = query[2] - node.z;
+	float distance = dx * dx + dy * dy + dz * dz;
+	if (distance < bestDistance) {
+		bestDistance = distance;
+		best = middle;
+	}
+
+	int32 axis = depth % 3;
+	float split = axis == 0 ? dx : (axis == 1 ? dy : dz);
+
+	// descend into the side containing the query first, the far side only if it can be closer
+	if (split < 0) {
+		_SearchTree(low, middle, depth + 1, query, best, bestDistance);
+		if (split * split < bestDistance)
+			_SearchTree(middle + 1, high, depth + 1, query, best, bestDistance);
+	} else {
+		_SearchTree(middle + 1, high, depth + 1, query, best, bestDistance);
+		if (split * split < bestDistance)
+			_SearchTree(low, middle, depth + 1, query, best, bestDistance);
+	}
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _PLACEINDEX_H_
+#define _PLACEINDEX_H_
+
+#include <Locker.h>
+#include <String.h>
+
+#include "PlaceIndexFormat.h"
+
+
+// strings point into the mapped index and stay valid as long as the index does
+struct place_info {
+	const char*	name;
+	const char*	region;
+	const char*	country;
+	float		latitude;
+	float		longitude;
+	uint32		population;
+};
+
+
+class PlaceIndex {
+public:
+							PlaceIndex(const char* path = NULL);
+							~PlaceIndex();
+
+	static	PlaceIndex*		Default();
+	static	void			GetDisplayName(const place_info& place, BString& name);
+
+			status_t		FindNearest(double latitude, double longitude, place_info& place,
+								double* distance = NULL);
+			status_t		GetPlaceName(double latitude, double longitude, BString& name,
+								double maxDistance = 150.0);
+			int32			Search(const char* text, place_info* places, int32 maxCount);
+			int32			CountPlaces();
+
+private:
+			status_t		_Map();
+			const void*		_FindSection(uint32 type, size_t elementSize);
+			void			_GetPlace(uint32 index, place_info& place);
+			void			_SearchTree(int32 low, int32 high, int32 depth, const float query[3],
+								int32& best, float& bestDistance);
+			uint32			_FindKey(const char* key, int32 length, uint32 low, uint32 high, bool upper);
+
+			BString			fPath;
+			BLocker			fLock;
+			status_t		fStatus;
+			void*			fArea;
+			size_t			fAreaSize;
+			const place_index_header*	fHeader;
+			const place_record*			fPlaces;
+			const char*					fNames;
+			size_t						fNamesSize;
+			const place_tree_node*		fTree;
+			const char*					fKeys;
+			const uint32*				fKeyBlocks;
+			const place_trie_node*		fTrie;
+			uint32						fTrieCount;
+};
+
+#endif // _PLACEINDEX_H_
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _PLACEINDEXFORMAT_H_
+#define _PLACEINDEXFORMAT_H_
+
+#include <SupportDefs.h>
+
+
+// The place index is memory mapped and used in place, so every structure is
+// naturally aligned and stored in host byte order.  It is generated at build
+// time by Tools/MakePlaceIndex.
+
+static const uint32 kPlaceIndexMagic = 'DWpi';
+static const uint32 kPlaceIndexVersion = 1;
+static const int32 kPlaceIndexMaxSections = 8;
+static const int32 kPlaceKeyBlockSize = 16;
+static const int32 kPlaceTrieDepth = 3;
+static const int32 kPlaceTrieTopCount = 8;
+
+enum {
+	kPlaceSection = 'plce',		// place_record[place_count], sorted by search key
+	kPlaceNameSection = 'name',	// "name\0region\0country\0" for each place
+	kPlaceTreeSection = 'kdtr',	// place_tree_node[place_count]
+	kPlaceKeySection = 'keys',	// front coded search keys
+	kPlaceKeyBlockSection = 'kblk',	// uint32 offset of every key block
+	kPlaceTrieSection = 'trie'	// place_trie_node[], root first
+};
+
+
+struct place_index_section {
+	uint32	type;
+	uint32	offset;
+	uint32	size;
+};
+
+
+struct place_index_header {
+	uint32				magic;
+	uint32				version;
+	uint32				place_count;
+	uint32				section_count;
+	place_index_section	sections[kPlaceIndexMaxSections];
+};
+
+
+struct place_record {
+	float	latitude;
+	float	longitude;
+	uint32	population;
+	uint32	name;		// offset into the name section
+};
+
+
+// Implicit balanced k-d tree over unit sphere coordinates.  The node for the
+// range [low, high) is stored at (low + high) / 2 and splits on x, y and z
+// in turn, so the tree needs no child pointers.
+struct place_tree_node {
+	float	x;
+	float	y;
+	float	z;
+	uint32	place;
+};
+
+
+// Search keys are the folded place names in sorted order.  They are stored in
+// blocks of kPlaceKeyBlockSize keys where the first key is complete and every
+// following key is a shared prefix length byte plus the remaining suffix.
+
+
+// Prefix trie over the first kPlaceTrieDepth key characters.  Every node knows
+// the range of places sharing its prefix and the most populous of them.
+struct place_trie_node {
+	uint32	first_child;
+	uint32	low;
+	uint32	high;
+	uint16	child_count;
+	char	character;
+	uint8	top_count;
+	uint32	top[kPlaceTrieTopCount];
+};
+
+
+static inline char
+place_key_fold(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+
+#endif // _PLACEINDEXFORMAT_H_
@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "ReplayTransport.h"
+#include "Trace.h"
+
+#include <OS.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+// the endpoint is everything in front of the query
+static size_t
+endpoint_length(const char* url)
+{
+	const char* query = strchr(url, '?');
+	return query != NULL ? static_cast<size_t>(query - url) : strlen(url);
+}
+
+
+ReplayTransport::ReplayTransport()
+	:
+	fReplayCount(NULL),
+	fLatency(-1),
+	fBandwidth(0),
+	fLinkFree(0),
+	fPending(NULL),
+	fPendingCount(0),
+	fPendingCapacity(0),
+	fDelivering(NULL),
+	fRunning(false),
+	fQuit(false)
+{
+	pthread_mutex_init(&fLock, NULL);
+	pthread_cond_init(&fCondition, NULL);
+}
+
+
+ReplayTransport::~ReplayTransport()
+{
+	if (fRunning) {
+		pthread_mutex_lock(&fLock);
+		fQuit = true;
+		pthread_cond_broadcast(&fCondition);
+		pthread_mutex_unlock(&fLock);
+
+		pthread_join(fThread, NULL);
+	}
+
+	free(fPending);
+	free(fReplayCount);
+	pthread_cond_destroy(&fCondition);
+	pthread_mutex_destroy(&fLock);
+}
+
+
+status_t
+ReplayTransport::Load(const char* path)
+{
+	pthread_mutex_lock(&fLock);
+	if (fPendingCount > 0 || fDelivering != NULL) {
+		pthread_mutex_unlock(&fLock);
+		return B_BUSY;
+	}
+
+	free(fReplayCount);
+	fReplayCount = NULL;
+
+	status_t status = fArchive.Load(path);
+	if (status == B_OK && fArchive.CountExchanges() > 0) {
+		fReplayCount = static_cast<uint32*>(calloc(fArchive.CountExchanges(), sizeof(uint32)));
+		if (fReplayCount == NULL) {
+			fArchive.Unset();
+			status = B_NO_MEMORY;
+		}
+	}
+
+	fLinkFree = 0;
+	pthread_mutex_unlock(&fLock);
+
+	return status;
+}
+
+
+void
+ReplayTransport::SetLatency(bigtime_t latency)
+{
+	pthread_mutex_lock(&fLock);
+	fLatency = latency;
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+ReplayTransport::SetBandwidth(int64 bandwidth)
+{
+	pthread_mutex_lock(&fLock);
+	fBandwidth = bandwidth > 0 ? bandwidth : 0;
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+ReplayTransport::Rewind()
+{
+	pthread_mutex_lock(&fLock);
+	if (fReplayCount != NULL)
+		memset(fReplayCount, 0, fArchive.CountExchanges() * sizeof(uint32));
+	pthread_mutex_unlock(&fLock);
+}
+
+
+status_t
+ReplayTransport::Fetch(const char* url, TransportListener* listener)
+{
+	if (url == NULL || listener == NULL)
+		return B_BAD_VALUE;
+
+	pthread_mutex_lock(&fLock);
+
+	status_t status = B_OK;
+	for (int32 x = 0; x < fPendingCount; x++) {
+		if (fPending[x].listener == listener)
+			status = B_BUSY;
+	}
+
+	int32 exchange = -1;
+	if (status == B_OK) {
+		exchange = _FindExchange(url);
+		if (exchange < 0)
+			status = B_NAME_NOT_FOUND;
+	}
+
+	if (status == B_OK && fPendingCount == fPendingCapacity) {
+		int32 capacity = fPendingCapacity > 0 ? fPendingCapacity * 2 : 8;
+		pending_reply* pending = static_cast<pending_reply*>(realloc(fPending, capacity * sizeof(pending_reply)));
+		if (pending == NULL)
+			status = B_NO_MEMORY;
+		else {
+			fPending = pending;
+			fPendingCapacity = capacity;
+		}
+	}
+
+	if (status == B_OK && !fRunning) {
+		fQuit = false;
+		if (pthread_create(&fThread, NULL, &_DeliveryThread, this) == 0)
+			fRunning = true;
+		else
+			status = B_ERROR;
+	}
+
+	if (status != B_OK) {
+		pthread_mutex_unlock(&fLock);
+		return status;
+	}
+
+	// the reply waits for the latency, then for the link to be free
+	const transport_exchange& reply = fArchive.ExchangeAt(exchange);
+	bigtime_t requested = system_time();
+	bigtime_t due = requested + (fLatency >= 0 ? fLatency : reply.duration);
+	bigtime_t transfer = 0;
+	if (fBandwidth > 0) {
+		if (due < fLinkFree)
+			due = fLinkFree;
+		transfer = static_cast<bigtime_t>(reply.bodySize) * 1000000 / fBandwidth;
+		due += transfer;
+		fLinkFree = due;
+	}
+
+	pending_reply& pending = fPending[fPendingCount++];
+	pending.listener = listener;
+	pending.exchange = exchange;
+	pending.due = due;
+	pending.requested = requested;
+	pending.transfer = transfer;
+
+	pthread_cond_broadcast(&fCondition);
+	pthread_mutex_unlock(&fLock);
+
+	return B_OK;
+}
+
+
+void
+ReplayTransport::Cancel(TransportListener* listener)
+{
+	pthread_mutex_lock(&fLock);
+
+	int32 count = 0;
+	for (int32 x = 0; x < fPendingCount; x++) {
+		if (fPending[x].listener != listener)
+			fPending[count++] = fPending[x];
+	}
+	fPendingCount = count;
+
+	// the delivery thread mustn't cancel its own listener
+	while (fDelivering == listener && !pthread_equal(pthread_self(), fThread))
+		pthread_cond_wait(&fCondition, &fLock);
+
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void*
+ReplayTransport::_DeliveryThread(void* data)
+{
+	static_cast<ReplayTransport*>(data)->_Deliver();
+	return NULL;
+}
+
+
+void
+ReplayTransport::_Deliver()
+{
+	pthread_mutex_lock(&fLock);
+	while (!fQuit) {
+		if (fPendingCount == 0) {
+			pthread_cond_wait(&fCondition, &fLock);
+			continue;
+		}
+
+		// earliest first, in the order of the requests when they are due together
+		int32 next = 0;
+		for (int32 x = 1; x < fPendingCount; x++) {
+			if (fPending[x].due < fPending[next].due)
+				next = x;
+		}
+
+		bigtime_t wait = fPending[next].due - system_time();
+		if (wait > 0) {
+			struct timespec until;
+			clock_gettime(CLOCK_REALTIME, &until);
+			until.tv_sec += wait / 1000000;
+			until.tv_nsec += (wait % 1000000) * 1000;
+			if (until.tv_nsec >= 1000000000) {
+				until.tv_sec++;
+				until.tv_nsec -= 1000000000;
+			}
+			pthread_cond_timedwait(&fCondition, &fLock, &until);
+			continue;
+		}
+
+		pending_reply reply = fPending[next];
+		memmove(fPending + next, fPending + next + 1, (fPendingCount - next - 1) * sizeof(pending_reply));
+		fPendingCount--;
+
+		fDelivering = reply.listener;
+		pthread_mutex_unlock(&fLock);
+
+		// the latency and waiting for the link count as waiting for the reply
+		transport_exchange exchange = fArchive.ExchangeAt(reply.exchange);
+		exchange.waitTime = reply.due - reply.transfer - reply.requested;
+		exchange.transferTime = reply.transfer;
+		Trace::Complete("request", reply.requested, system_time() - reply.requested);
+		reply.listener->ExchangeCompleted(exchange);
+
+		pthread_mutex_lock(&fLock);
+		fDelivering = NULL;
+		pthread_cond_broadcast(&fCondition);
+	}
+	pthread_mutex_unlock(&fLock);
+}
+
+
+int32
+ReplayTransport::_FindExchange(const char* url)
+{
+	int32 count = fArchive.CountExchanges();
+	int32 first = -1;
+	int32 matches = 0;
+
+	for (int32 x = 0; x < count; x++) {
+		if (strcmp(fArchive.ExchangeAt(x).url, url) == 0) {
+			if (first < 0)
+				first = x;
+			matches++;
+		}
+	}
+
+	// the same endpoint with other parameters, like another location
+	size_t length = endpoint_length(url);
+	bool sameEndpoint = matches == 0;
+	if (sameEndpoint) {
+		for (int32 x = 0; x < count; x++) {
+			const char* recorded = fArchive.ExchangeAt(x).url;
+			if (endpoint_length(recorded) == length && strncmp(recorded, url, length) == 0) {
+				if (first < 0)
+					first = x;
+				matches++;
+			}
+		}
+	}
+
+	if (matches == 0)
+		return -1;
+
+	uint32 replay = fReplayCount[first]++ % matches;
+	for (int32 x = first; x < count; x++) {
+		const char* recorded = fArchive.ExchangeAt(x).url;
+		bool match = sameEndpoint
+			? endpoint_length(recorded) == length && strncmp(recorded, url, length) == 0
+			: strcmp(recorded, url) == 0;
+		if (match && replay-- == 0)
+			return x;
+	}
+
+	return -1;
+}
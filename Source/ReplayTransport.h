@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _REPLAYTRANSPORT_H_
+#define _REPLAYTRANSPORT_H_
+
+
+#include "CaptureArchive.h"
+#include "Transport.h"
+
+
+// Answers requests from a capture archive instead of the network.  A url gets
+// its recorded replies in the order they were captured, over and over, and
+// urls that weren't captured get the replies of the same endpoint.  Every
+// reply waits for the latency and then shares a link of the given bandwidth
+// with the other replies, so a replay always takes the same time.
+class ReplayTransport : public Transport {
+public:
+								ReplayTransport();
+	virtual						~ReplayTransport();
+
+			status_t			Load(const char* path);
+			const CaptureArchive& Archive() const { return fArchive; }
+
+			// below zero replays the recorded durations
+			void				SetLatency(bigtime_t latency);
+			// bytes per second, zero doesn't limit the bandwidth
+			void				SetBandwidth(int64 bandwidth);
+			// start every url with its first reply again
+			void				Rewind();
+
+	virtual	status_t			Fetch(const char* url, TransportListener* listener);
+	virtual	void				Cancel(TransportListener* listener);
+
+private:
+	struct pending_reply {
+		TransportListener*	listener;
+		int32				exchange;
+		bigtime_t			due;
+		bigtime_t			requested;
+		bigtime_t			transfer;	// the part of due spent on the link
+	};
+
+	static	void*				_DeliveryThread(void* data);
+			void				_Deliver();
+			int32				_FindExchange(const char* url);
+
+			CaptureArchive		fArchive;
+			uint32*				fReplayCount;
+			bigtime_t			fLatency;
+			int64				fBandwidth;
+			bigtime_t			fLinkFree;
+
+			pending_reply*		fPending;
+			int32				fPendingCount;
+			int32				fPendingCapacity;
+			TransportListener*	fDelivering;
+
+			bool				fRunning;
+			bool				fQuit;
+			pthread_t			fThread;
+			pthread_mutex_t		fLock;
+			pthread_cond_t		fCondition;
+};
+
+#endif // _REPLAYTRANSPORT_H_
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "RequestStats.h"
+#include "Transport.h"
+
+#include <string.h>
+
+
+static const char* kPhaseNames[kPhaseCount] = {
+	"resolve",
+	"connect",
+	"wait",
+	"transfer",
+	"parse",
+	"apply"
+};
+
+
+Histogram::Histogram()
+{
+	Reset();
+}
+
+
+void
+Histogram::Add(uint64 value)
+{
+	int32 bucket = 0;
+	while (bucket < kHistogramBuckets - 1 && (value >> bucket) != 0)
+		bucket++;
+
+	fBuckets[bucket]++;
+	fCount++;
+	fSum += value;
+	if (value > fMax)
+		fMax = value;
+}
+
+
+void
+Histogram::Reset()
+{
+	memset(fBuckets, 0, sizeof(fBuckets));
+	fCount = 0;
+	fSum = 0;
+	fMax = 0;
+}
+
+
+// the upper end of the bucket the percentile falls into
+uint64
+Histogram::Percentile(int32 percent) const
+{
+	if (fCount == 0)
+		return 0;
+
+	uint64 rank = (static_cast<uint64>(fCount) * percent + 99) / 100;
+	if (rank == 0)
+		rank = 1;
+
+	uint64 counted = 0;
+	for (int32 x = 0; x < kHistogramBuckets; x++) {
+		counted += fBuckets[x];
+		if (counted >= rank) {
+			uint64 upper = x == 0 ? 0 : (static_cast<uint64>(1) << x) - 1;
+			return upper < fMax ? upper : fMax;
+		}
+	}
+
+	return fMax;
+}
+
+
+RequestStats::RequestStats()
+{
+	pthread_mutex_init(&fLock, NULL);
+	Reset();
+}
+
+
+RequestStats::~RequestStats()
+{
+	pthread_mutex_destroy(&fLock);
+}
+
+
+void
+RequestStats::AddExchange(const transport_exchange& exchange)
+{
+	pthread_mutex_lock(&fLock);
+
+	fStats.requests++;
+	if (exchange.status < 200 || exchange.status > 299)
+		fStats.failed++;
+	else {
+		// failed requests would only blur the phases
+		const bigtime_t times[] = {exchange.resolveTime, exchange.connectTime, exchange.waitTime,
+			exchange.transferTime};
+		for (int32 x = 0; x <= kPhaseTransfer; x++) {
+			if (times[x] >= 0)
+				fStats.phases[x].Add(times[x]);
+		}
+		fStats.bytes.Add(exchange.bodySize);
+	}
+
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+RequestStats::AddPhase(request_phase phase, bigtime_t duration)
+{
+	if (phase < 0 || phase >= kPhaseCount || duration < 0)
+		return;
+
+	pthread_mutex_lock(&fLock);
+	fStats.phases[phase].Add(duration);
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+RequestStats::Reset()
+{
+	pthread_mutex_lock(&fLock);
+	fStats.requests = 0;
+	fStats.failed = 0;
+	for (int32 x = 0; x < kPhaseCount; x++)
+		fStats.phases[x].Reset();
+	fStats.bytes.Reset();
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+RequestStats::Get(request_stats& stats)
+{
+	pthread_mutex_lock(&fLock);
+	stats = fStats;
+	pthread_mutex_unlock(&fLock);
+}
+
+
+const char*
+RequestStats::PhaseName(request_phase phase)
+{
+	if (phase < 0 || phase >= kPhaseCount)
+		return NULL;
+
+	return kPhaseNames[phase];
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _REQUESTSTATS_H_
+#define _REQUESTSTATS_H_
+
+
+#include <SupportDefs.h>
+
+#include <pthread.h>
+
+
+struct transport_exchange;
+
+
+enum request_phase {
+	kPhaseResolve = 0,
+	kPhaseConnect,
+	kPhaseWait,
+	kPhaseTransfer,
+	kPhaseParse,
+	kPhaseApply,
+	kPhaseCount
+};
+
+static const int32 kHistogramBuckets = 32;
+
+
+// Counts values in power of two buckets, bucket x holds the values with x
+// significant bits.  Percentiles are only as exact as the buckets.
+class Histogram {
+public:
+								Histogram();
+
+			void				Add(uint64 value);
+			void				Reset();
+
+			uint32				Count() const { return fCount; }
+			uint64				Sum() const { return fSum; }
+			uint64				Max() const { return fMax; }
+			uint64				Percentile(int32 percent) const;
+
+private:
+			uint32				fBuckets[kHistogramBuckets];
+			uint32				fCount;
+			uint64				fSum;
+			uint64				fMax;
+};
+
+
+// a copy of the statistics of one kind of request
+struct request_stats {
+	uint32		requests;
+	uint32		failed;
+	Histogram	phases[kPhaseCount];	// in microseconds
+	Histogram	bytes;
+};
+
+
+// Collects the timings of the requests of one provider.  The network phases
+// come from the transport thread, parse and apply from the window thread.
+class RequestStats {
+public:
+								RequestStats();
+								~RequestStats();
+
+			void				AddExchange(const transport_exchange& exchange);
+			void				AddPhase(request_phase phase, bigtime_t duration);
+			void				Reset();
+
+			void				Get(request_stats& stats);
+
+	static	const char*			PhaseName(request_phase phase);
+
+private:
+			pthread_mutex_t		fLock;
+			request_stats		fStats;
+};
+
+#endif // _REQUESTSTATS_H_
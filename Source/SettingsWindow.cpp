@@ -2,6 +2,8 @@
 // SPDX-FileCopyrightText: 2021 Chris Roberts
 
 #include "SettingsWindow.h"
+#include "FontMenu.h"
+#include "PlaceIndex.h"
 #include "WeatherSettings.h"
 
 #include <Alert.h>
@@ -9,9 +11,12 @@
 #include <CheckBox.h>
 #include <ControlLook.h>
 #include <LayoutBuilder.h>
+#include <ListView.h>
 #include <MenuField.h>
+#include <MenuItem.h>
 #include <PopUpMenu.h>
 #include <RadioButton.h>
+#include <ScrollView.h>
 #include <StringView.h>
 #include <private/shared/AutoLocker.h>
 
@@ -27,8 +32,48 @@ enum {
 	kResetFontMessage				= 'GcRf',
 	kRevertButtonMessage			= 'GcRv',
 	kShowFeelsLikeCheckboxMessage	= 'DwFl',
+	kDisplayModeMessage				= 'DwDm',
+	kTickerCheckboxMessage			= 'DwTk',
+	kSaveLocationMessage			= 'DwSv',
+	kRemoveLocationMessage			= 'DwRm',
+	kSavedSelectMessage				= 'DwSs',
 	kCompactCheckboxMessage			= 'DwCc',
-	kForecastDaysMessage			= 'DwFd'
+	kKeepForecastCheckboxMessage	= 'DwKf',
+	kForecastDaysMessage			= 'DwFd',
+	kGeoCacheMessage				= 'GcCl',
+	kHourlyCheckboxMessage			= 'DwHf',
+	kLocationSearchMessage			= 'GcLs',
+	kLocationSelectMessage			= 'GcLp'
+};
+
+
+const int32 kMaxSearchResults = 8;
+
+
+class PlaceItem : public BStringItem {
+public:
+	PlaceItem(const place_info& place)
+		:
+		BStringItem(NULL),
+		fLatitude(place.latitude),
+		fLongitude(place.longitude)
+	{
+		PlaceIndex::GetDisplayName(place, fName);
+
+		BString label(fName);
+		if (place.country[0] != '\0')
+			label << " (" << place.country << ")";
+		SetText(label);
+	}
+
+	const char*	Name() const { return fName.String(); }
+	double		Latitude() const { return fLatitude; }
+	double		Longitude() const { return fLongitude; }
+
+private:
+	BString		fName;
+	double		fLatitude;
+	double		fLongitude;
 };
 
 
@@ -37,19 +82,29 @@ SettingsWindow::SettingsWindow(WeatherSettings* settings, BInvoker* invoker, BRe
 	BWindow(frame, "DeskbarWeather Preferences", B_TITLED_WINDOW_LOOK, B_NORMAL_WINDOW_FEEL,
 		B_NOT_ZOOMABLE | B_NOT_MINIMIZABLE | B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS | B_CLOSE_ON_ESCAPE),
 	fCompactBox(NULL),
+	fDisplayMenuField(NULL),
+	fGeoCacheMenuField(NULL),
 	fGeoNotificationBox(NULL),
+	fHourlyBox(NULL),
+	fKeepForecastBox(NULL),
 	fImperialButton(NULL),
 	fIntervalMenuField(NULL),
 	fDaysMenuField(NULL),
+	fFontMenu(NULL),
 	fInvoker(invoker),
 	fLocationBox(NULL),
 	fLocationControl(NULL),
+	fLocationListView(NULL),
+	fLocationScrollView(NULL),
 	fMetricButton(NULL),
 	fNotificationBox(NULL),
+	fRemoveLocationButton(NULL),
+	fSavedListView(NULL),
 	fSettings(settings),
 	fSettingsCache(new WeatherSettings(dynamic_cast<const WeatherSettings&>(*settings))),
 	fShowFeelsLikeBox(NULL),
-	fShowForecastBox(NULL)
+	fShowForecastBox(NULL),
+	fTickerBox(NULL)
 {
 	AutoLocker<WeatherSettings> slocker(fSettings);
 
@@ -64,9 +119,17 @@ SettingsWindow::SettingsWindow(WeatherSettings* settings, BInvoker* invoker, BRe
 
 	fLocationControl = new BTextControl("LocationControl", "Location:", fSettings->Location(), NULL);
 	fLocationControl->TextView()->SetExplicitMinSize(BSize(200.0, B_SIZE_UNSET));
+	fLocationControl->SetModificationMessage(new BMessage(kLocationSearchMessage));
+
+	// search results are shown below the location while typing
+	fLocationListView = new BListView("LocationListView");
+	fLocationListView->SetSelectionMessage(new BMessage(kLocationSelectMessage));
+	fLocationScrollView = new BScrollView("LocationScrollView", fLocationListView, 0, false, true);
+	fLocationScrollView->SetExplicitPreferredSize(BSize(B_SIZE_UNSET,
+		be_plain_font->Size() * 1.4 * kMaxSearchResults / 2));
+	fLocationScrollView->Hide();
 
 	fLocationBox = new BCheckBox("GeoLocationCheckBox", "Use GeoLocation lookup", new BMessage(kGeoCheckboxMessage));
-	fLocationBox->SetEnabled(false); // disable until we have working geocoding
 
 	BStringView* unitsView = new BStringView("UnitStringView", "Units:");
 
@@ -79,6 +142,16 @@ SettingsWindow::SettingsWindow(WeatherSettings* settings, BInvoker* invoker, BRe
 
 	fGeoNotificationBox = new BCheckBox("GeoNotificationCheckBox", "Show notification after lookup", new BMessage(kGeoNotificationCheckboxMessage));
 
+	BPopUpMenu* geoCacheMenu = new BPopUpMenu("GeoCacheMenu");
+	const int32 cacheHours[] = {1, 6, 24, 168};
+	const char* cacheLabels[] = {"1 hour", "6 hours", "1 day", "1 week"};
+	for (int32 x = 0; x < 4; x++) {
+		BMessage* message = new BMessage(kGeoCacheMessage);
+		message->AddInt32("hours", cacheHours[x]);
+		geoCacheMenu->AddItem(new BMenuItem(cacheLabels[x], message));
+	}
+	fGeoCacheMenuField = new BMenuField("GeoCacheMenuField", "Keep location for:", geoCacheMenu);
+
 	fShowForecastBox = new BCheckBox("ShowForecastCheckBox", "Clicking the notification opens the forecast", new BMessage(kShowForecastCheckboxMessage));
 
 	BPopUpMenu* forecastDaysMenu = new BPopUpMenu("ForecastDaysMenu");
@@ -92,10 +165,33 @@ SettingsWindow::SettingsWindow(WeatherSettings* settings, BInvoker* invoker, BRe
 	}
 	fDaysMenuField = new BMenuField("DaysMenuField", "Forecast length:", forecastDaysMenu);
 
+	fHourlyBox = new BCheckBox("HourlyForecastBox", "Include hourly forecast", new BMessage(kHourlyCheckboxMessage));
+
 	fCompactBox = new BCheckBox("CompactForecastBox", "Use compact forecast window", new BMessage(kCompactCheckboxMessage));
 
+	fKeepForecastBox = new BCheckBox("KeepForecastBox", "Keep forecast window ready in the background", new BMessage(kKeepForecastCheckboxMessage));
+
 	fShowFeelsLikeBox = new BCheckBox("ShowFeelsLikeBox", "Show \"Feels Like\" temperature in the Deskbar", new BMessage(kShowFeelsLikeCheckboxMessage));
 
+	BPopUpMenu* displayMenu = new BPopUpMenu("DisplayMenu");
+	const char* displayLabels[kDisplayModeCount] = {"Temperature", "Temperature, high and low",
+		"Temperature and chance of rain"};
+	for (int32 x = 0; x < kDisplayModeCount; x++) {
+		BMessage* message = new BMessage(kDisplayModeMessage);
+		message->AddInt32("mode", x);
+		displayMenu->AddItem(new BMenuItem(displayLabels[x], message));
+	}
+	fDisplayMenuField = new BMenuField("DisplayMenuField", "Deskbar shows:", displayMenu);
+
+	fTickerBox = new BCheckBox("TickerBox", "Cycle through saved locations in the Deskbar", new BMessage(kTickerCheckboxMessage));
+
+	fSavedListView = new BListView("SavedListView");
+	fSavedListView->SetSelectionMessage(new BMessage(kSavedSelectMessage));
+	BScrollView* savedScrollView = new BScrollView("SavedScrollView", fSavedListView, 0, false, true);
+	savedScrollView->SetExplicitPreferredSize(BSize(B_SIZE_UNSET, be_plain_font->Size() * 1.4 * 4));
+
+	fRemoveLocationButton = new BButton("RemoveLocationButton", "Remove", new BMessage(kRemoveLocationMessage));
+
 	BButton* closeButton = new BButton("CloseButton", "Close", new BMessage(B_QUIT_REQUESTED));
 	closeButton->MakeDefault(true);
 
@@ -107,24 +203,36 @@ SettingsWindow::SettingsWindow(WeatherSettings* settings, BInvoker* invoker, BRe
 			.Add(fNotificationBox, 1, 1)
 			.Add(fShowForecastBox, 1, 2)
 			.AddTextControl(fLocationControl, 0, 3, B_ALIGN_RIGHT)
-			.Add(fLocationBox, 1, 4)
-			.Add(fGeoNotificationBox, 1, 5)
-			.AddGroup(B_HORIZONTAL, 0.0, 0, 6, 1, 1)
+			.Add(fLocationScrollView, 1, 4)
+			.Add(fLocationBox, 1, 5)
+			.Add(fGeoNotificationBox, 1, 6)
+			.AddMenuField(fGeoCacheMenuField, 0, 7, B_ALIGN_RIGHT)
+			.AddGroup(B_HORIZONTAL, 0.0, 0, 8, 1, 1)
 				.SetExplicitAlignment(BAlignment(B_ALIGN_RIGHT, B_ALIGN_MIDDLE))
 				.Add(unitsView)
 				.AddStrut(be_control_look->DefaultLabelSpacing())
 			.End()
-			.AddGroup(B_HORIZONTAL, B_USE_HALF_ITEM_SPACING, 1, 6, 1, 1)
+			.AddGroup(B_HORIZONTAL, B_USE_HALF_ITEM_SPACING, 1, 8, 1, 1)
 				.SetExplicitAlignment(BAlignment(B_ALIGN_LEFT, B_ALIGN_TOP))
 				.Add(fImperialButton)
 				.AddStrut(be_control_look->DefaultItemSpacing())
 				.Add(fMetricButton)
 			.End()
-			.AddMenuField(fontMenuField, 0, 7, B_ALIGN_RIGHT)
-			.Add(new BButton("ResetFontButton", "Reset font to default", new BMessage(kResetFontMessage)), 1, 8)
-			.AddMenuField(fDaysMenuField, 0, 9, B_ALIGN_RIGHT)
-			.Add(fCompactBox, 1, 10)
-			.Add(fShowFeelsLikeBox, 1, 11)
+			.AddMenuField(fontMenuField, 0, 9, B_ALIGN_RIGHT)
+			.Add(new BButton("ResetFontButton", "Reset font to default", new BMessage(kResetFontMessage)), 1, 10)
+			.AddMenuField(fDaysMenuField, 0, 11, B_ALIGN_RIGHT)
+			.Add(fHourlyBox, 1, 12)
+			.Add(fCompactBox, 1, 13)
+			.Add(fKeepForecastBox, 1, 14)
+			.Add(fShowFeelsLikeBox, 1, 15)
+			.AddMenuField(fDisplayMenuField, 0, 16, B_ALIGN_RIGHT)
+			.Add(fTickerBox, 1, 17)
+			.Add(savedScrollView, 1, 18)
+			.AddGroup(B_HORIZONTAL, B_USE_HALF_ITEM_SPACING, 1, 19, 1, 1)
+				.Add(new BButton("SaveLocationButton", "Save current location", new BMessage(kSaveLocationMessage)))
+				.Add(fRemoveLocationButton)
+				.AddGlue()
+			.End()
 		.End()
 		.Add(new BStringView("InfoStringView", "Changing font or units may require the app to be restarted to display properly"))
 		.AddGlue()
@@ -146,6 +254,7 @@ SettingsWindow::SettingsWindow(WeatherSettings* settings, BInvoker* invoker, BRe
 
 SettingsWindow::~SettingsWindow()
 {
+	_ClearSearchResults();
 	delete fInvoker;
 	delete fSettingsCache;
 }
@@ -177,6 +286,20 @@ SettingsWindow::MessageReceived(BMessage* message)
 
 			break;
 		}
+		case kHourlyCheckboxMessage:
+		{
+			AutoLocker<WeatherSettings> slocker(fSettings);
+			int32 value = message->GetInt32("be:value", -1);
+			if (value == -1)
+				break;
+
+			if (fSettings->HourlyForecast() != value) {
+				fSettings->SetHourlyForecast(value);
+				fInvoker->Invoke();
+			}
+
+			break;
+		}
 		case kCompactCheckboxMessage:
 		{
 			AutoLocker<WeatherSettings> slocker(fSettings);
@@ -189,6 +312,18 @@ SettingsWindow::MessageReceived(BMessage* message)
 
 			break;
 		}
+		case kKeepForecastCheckboxMessage:
+		{
+			AutoLocker<WeatherSettings> slocker(fSettings);
+			int32 value = message->GetInt32("be:value", -1);
+			if (value == -1)
+				break;
+
+			if (fSettings->KeepForecastWindow() != value)
+				fSettings->SetKeepForecastWindow(value);
+
+			break;
+		}
 		case kShowFeelsLikeCheckboxMessage:
 		{
 			AutoLocker<WeatherSettings> slocker(fSettings);
@@ -205,6 +340,62 @@ SettingsWindow::MessageReceived(BMessage* message)
 
 			break;
 		}
+		case kDisplayModeMessage:
+		{
+			AutoLocker<WeatherSettings> slocker(fSettings);
+			int32 mode = message->GetInt32("mode", -1);
+			if (mode < 0 || mode >= kDisplayModeCount || fSettings->DisplayMode() == mode)
+				break;
+
+			// the chance of rain needs the hourly forecast, even when it's turned off
+			bool rain = mode == kDisplayRain || fSettings->DisplayMode() == kDisplayRain;
+			fSettings->SetDisplayMode(static_cast<display_mode>(mode));
+
+			BMessage copy(*fInvoker->Message());
+			if (!rain || fSettings->HourlyForecast())
+				copy.AddBool("skiprefresh", true); // the reply that is shown has everything
+			fInvoker->Invoke(&copy);
+			break;
+		}
+		case kTickerCheckboxMessage:
+		{
+			AutoLocker<WeatherSettings> slocker(fSettings);
+			int32 value = message->GetInt32("be:value", -1);
+			if (value == -1)
+				break;
+
+			if (fSettings->Ticker() != value) {
+				fSettings->SetTicker(value);
+
+				BMessage copy(*fInvoker->Message());
+				copy.AddBool("skiprefresh", true); // the ticker fetches its locations itself
+				fInvoker->Invoke(&copy);
+			}
+			break;
+		}
+		case kSaveLocationMessage:
+		case kRemoveLocationMessage:
+		{
+			AutoLocker<WeatherSettings> slocker(fSettings);
+			status_t status;
+			if (message->what == kSaveLocationMessage)
+				status = fSettings->AddSavedLocation(fSettings->Location(), fSettings->Latitude(), fSettings->Longitude());
+			else
+				status = fSettings->RemoveSavedLocation(fSavedListView->CurrentSelection());
+
+			if (status != B_OK)
+				break;
+
+			_UpdateSavedList();
+
+			BMessage copy(*fInvoker->Message());
+			copy.AddBool("skiprefresh", true);
+			fInvoker->Invoke(&copy);
+			break;
+		}
+		case kSavedSelectMessage:
+			fRemoveLocationButton->SetEnabled(fSavedListView->CurrentSelection() >= 0);
+			break;
 		case kGeoCheckboxMessage:
 		{
 			AutoLocker<WeatherSettings> slocker(fSettings);
@@ -217,7 +408,10 @@ SettingsWindow::MessageReceived(BMessage* message)
 				return;
 
 			locationControl->SetEnabled(!useGeoCheckbox->Value());
+			if (useGeoCheckbox->Value())
+				_ClearSearchResults();
 			fGeoNotificationBox->SetEnabled(useGeoCheckbox->Value());
+			fGeoCacheMenuField->SetEnabled(useGeoCheckbox->Value());
 
 			if (fSettings->UseGeoLocation() != useGeoCheckbox->Value()) {
 				fSettings->SetUseGeoLocation(useGeoCheckbox->Value());
@@ -225,6 +419,28 @@ SettingsWindow::MessageReceived(BMessage* message)
 			}
 			break;
 		}
+		case kLocationSearchMessage:
+			_SearchLocation();
+			break;
+		case kLocationSelectMessage:
+		{
+			AutoLocker<WeatherSettings> slocker(fSettings);
+			_SelectLocation();
+			break;
+		}
+		case kGeoCacheMessage:
+		{
+			AutoLocker<WeatherSettings> slocker(fSettings);
+			int32 hours = message->GetInt32("hours", -1);
+			if (hours > 0 && fSettings->GeoCacheLifetime() != hours) {
+				fSettings->SetGeoCacheLifetime(hours);
+
+				BMessage copy(*fInvoker->Message());
+				copy.AddBool("skiprefresh", true); // the new lifetime applies to the next lookup
+				fInvoker->Invoke(&copy);
+			}
+			break;
+		}
 		case kGeoNotificationCheckboxMessage:
 		{
 			AutoLocker<WeatherSettings> slocker(fSettings);
@@ -340,21 +556,47 @@ SettingsWindow::_RevertSettings()
 		needRefresh = true;
 	}
 
+	if (fSettings->Latitude() != fSettingsCache->Latitude()
+		|| fSettings->Longitude() != fSettingsCache->Longitude()) {
+		fSettings->SetLocation(fSettingsCache->Latitude(), fSettingsCache->Longitude());
+		needRefresh = true;
+	}
+
 	if (fSettings->RefreshInterval() != fSettingsCache->RefreshInterval()) {
 		fSettings->SetRefreshInterval(fSettingsCache->RefreshInterval());
 		needRefresh = true;
 	}
 
+	if (fSettings->HourlyForecast() != fSettingsCache->HourlyForecast()) {
+		fSettings->SetHourlyForecast(fSettingsCache->HourlyForecast());
+		needRefresh = true;
+	}
+
 	if (fSettings->ShowFeelsLike() != fSettingsCache->ShowFeelsLike()) {
 		fSettings->SetShowFeelsLike(fSettingsCache->ShowFeelsLike());
 		needRefresh = true;
 	}
 
+	if (fSettings->DisplayMode() != fSettingsCache->DisplayMode()) {
+		fSettings->SetDisplayMode(fSettingsCache->DisplayMode());
+		needRefresh = true;
+	}
+
+	if (fSettings->Ticker() != fSettingsCache->Ticker()) {
+		fSettings->SetTicker(fSettingsCache->Ticker());
+		needRefresh = true;
+	}
+
+	if (_RevertSavedLocations())
+		needRefresh = true;
+
 	// no need to refresh immediately for these
+	fSettings->SetGeoCacheLifetime(fSettingsCache->GeoCacheLifetime());
 	fSettings->SetForecastDays(fSettingsCache->ForecastDays());
 	fSettings->SetUseNotification(fSettingsCache->UseNotification());
 	fSettings->SetNotificationClick(fSettingsCache->NotificationClick());
 	fSettings->SetCompactForecast(fSettingsCache->CompactForecast());
+	fSettings->SetKeepForecastWindow(fSettingsCache->KeepForecastWindow());
 
 	BFont font;
 	if (fSettingsCache->GetFont(font) == B_OK)
@@ -377,10 +619,21 @@ SettingsWindow::_InitControls()
 	fGeoNotificationBox->SetEnabled(fSettings->UseGeoLocation());
 	fGeoNotificationBox->SetValue(fSettings->UseGeoNotification());
 
+	fGeoCacheMenuField->SetEnabled(fSettings->UseGeoLocation());
+	BMenu* geoCacheMenu = fGeoCacheMenuField->Menu();
+	for (int32 x = 0; x < geoCacheMenu->CountItems(); x++) {
+		BMenuItem* menuItem = geoCacheMenu->ItemAt(x);
+		if (menuItem->Message()->GetInt32("hours", -1) == fSettings->GeoCacheLifetime()) {
+			menuItem->SetMarked(true);
+			break;
+		}
+	}
+
 	fLocationBox->SetValue(fSettings->UseGeoLocation());
 
 	fLocationControl->SetEnabled(!fSettings->UseGeoLocation());
 	fLocationControl->SetText(fSettings->Location());
+	_ClearSearchResults();
 
 	fNotificationBox->SetValue(fSettings->UseNotification());
 
@@ -389,10 +642,21 @@ SettingsWindow::_InitControls()
 	fShowForecastBox->SetEnabled(fSettings->UseNotification());
 	fShowForecastBox->SetValue(fSettings->NotificationClick());
 
+	fHourlyBox->SetValue(fSettings->HourlyForecast());
+
 	fCompactBox->SetValue(fSettings->CompactForecast());
 
+	fKeepForecastBox->SetValue(fSettings->KeepForecastWindow());
+
 	fShowFeelsLikeBox->SetValue(fSettings->ShowFeelsLike());
 
+	BMenuItem* displayItem = fDisplayMenuField->Menu()->ItemAt(fSettings->DisplayMode());
+	if (displayItem != NULL)
+		displayItem->SetMarked(true);
+
+	fTickerBox->SetValue(fSettings->Ticker());
+	_UpdateSavedList();
+
 	BMenu* daysMenu = fDaysMenuField->Menu();
 	for (int32 x = 0; x < daysMenu->CountItems(); x++) {
 		BMenuItem* menuItem = daysMenu->ItemAt(x);
@@ -417,20 +681,126 @@ SettingsWindow::_InitControls()
 void
 SettingsWindow::_SaveSettings()
 {
-	//TODO a geolocation request might have changed our location name while the window was open (on first run)
-	//this should be enabled/fixed whenever manual location selection is implemented
-//	bool needRefresh = false;
-//	if (strcmp(fSettings->Location(), fLocationControl->Text()) != 0) {
-//		fSettings->SetLocation(fLocationControl->Text());
-//		needRefresh = true;
-//	}
-
-	if (fSettings->ForecastDays() != fSettingsCache->ForecastDays()
+	// a manual location can be renamed without picking a search result, the coordinates stay the same
+	bool needRefresh = false;
+	if (!fSettings->UseGeoLocation() && fLocationControl->Text()[0] != '\0'
+		&& strcmp(fSettings->Location(), fLocationControl->Text()) != 0) {
+		fSettings->SetLocation(fLocationControl->Text());
+		needRefresh = true;
+	}
+
+	if (needRefresh || fSettings->ForecastDays() != fSettingsCache->ForecastDays()
 		|| fSettings->RefreshInterval() != fSettingsCache->RefreshInterval())
 		fInvoker->Invoke();
 }
 
 
+void
+SettingsWindow::_SearchLocation()
+{
+	AutoLocker<WeatherSettings> slocker(fSettings);
+	const char* text = fLocationControl->Text();
+
+	// nothing to look up when the text was set by us rather than typed
+	if (!fLocationControl->IsEnabled() || strcmp(text, fSettings->Location()) == 0) {
+		_ClearSearchResults();
+		return;
+	}
+	slocker.Unlock();
+
+	place_info places[kMaxSearchResults];
+	int32 count = PlaceIndex::Default()->Search(text, places, kMaxSearchResults);
+
+	_ClearSearchResults();
+	for (int32 x = 0; x < count; x++)
+		fLocationListView->AddItem(new PlaceItem(places[x]));
+
+	if (count > 0 && fLocationScrollView->IsHidden())
+		fLocationScrollView->Show();
+}
+
+
+void
+SettingsWindow::_SelectLocation()
+{
+	PlaceItem* item = dynamic_cast<PlaceItem*>(fLocationListView->ItemAt(fLocationListView->CurrentSelection()));
+	if (item == NULL)
+		return;
+
+	fSettings->SetLocation(item->Latitude(), item->Longitude());
+	fSettings->SetLocation(item->Name());
+	fLocationControl->SetText(item->Name());
+
+	// the list owns the item, so clear it last
+	_ClearSearchResults();
+
+	BMessage copy(*fInvoker->Message());
+	copy.AddBool("forcerefresh", true); // new coordinates, fetch the weather right away
+	fInvoker->Invoke(&copy);
+}
+
+
+void
+SettingsWindow::_ClearSearchResults()
+{
+	if (fLocationListView == NULL)
+		return;
+
+	for (int32 x = fLocationListView->CountItems() - 1; x >= 0; x--)
+		delete fLocationListView->RemoveItem(x);
+
+	if (!fLocationScrollView->IsHidden())
+		fLocationScrollView->Hide();
+}
+
+
+void
+SettingsWindow::_UpdateSavedList()
+{
+	for (int32 x = fSavedListView->CountItems() - 1; x >= 0; x--)
+		delete fSavedListView->RemoveItem(x);
+
+	BString name;
+	double latitude, longitude;
+	for (int32 x = 0; x < fSettings->CountSavedLocations(); x++) {
+		if (fSettings->GetSavedLocation(x, name, latitude, longitude) == B_OK)
+			fSavedListView->AddItem(new BStringItem(name));
+	}
+
+	fRemoveLocationButton->SetEnabled(false);
+}
+
+
+// puts back the saved locations when they changed, returns if they did
+bool
+SettingsWindow::_RevertSavedLocations()
+{
+	int32 count = fSettingsCache->CountSavedLocations();
+	bool changed = fSettings->CountSavedLocations() != count;
+
+	BString name, savedName;
+	double latitude, longitude, savedLatitude, savedLongitude;
+	for (int32 x = 0; x < count && !changed; x++) {
+		fSettingsCache->GetSavedLocation(x, name, latitude, longitude);
+		fSettings->GetSavedLocation(x, savedName, savedLatitude, savedLongitude);
+		changed = name != savedName || latitude != savedLatitude || longitude != savedLongitude;
+	}
+
+	if (!changed)
+		return false;
+
+	while (fSettings->CountSavedLocations() > 0)
+		fSettings->RemoveSavedLocation(0);
+
+	for (int32 x = 0; x < count; x++) {
+		if (fSettingsCache->GetSavedLocation(x, name, latitude, longitude) == B_OK)
+			fSettings->AddSavedLocation(name, latitude, longitude);
+	}
+
+	return true;
+}
+
+
 BMenu*
 SettingsWindow::_BuildFontMenu()
 {
@@ -441,64 +811,12 @@ SettingsWindow::_BuildFontMenu()
 	origFont.GetFamilyAndStyle(&origFamily, &origStyle);
 	BString menuLabelStr;
 	menuLabelStr.SetToFormat("%s - %s - %g", origFamily, origStyle, origFont.Size());
-	BPopUpMenu* menu = new BPopUpMenu(menuLabelStr, false);
-	menu->SetLabelFromMarked(false);
 
-	int32 numFamilies = count_font_families();
-	font_family family;
-	for (int32 i = 0; i < numFamilies; i++) {
-		bool inFamily = false;
-		if (get_font_family(i, &family, NULL) != B_OK)
-			continue;
-
-		BMenu* familyMenu = new BMenu(family);
-		menu->AddItem(familyMenu);
-		familyMenu->SetRadioMode(false);
-		if (strcmp(family, origFamily) == 0) {
-			BMenuItem* item = menu->FindItem(family);
-			item->SetMarked(true);
-			inFamily = true;
-		}
+	// styles and sizes are only added when their menus are opened
+	fFontMenu = new FontMenu(menuLabelStr, kFontMessage);
+	fFontMenu->Select(origFamily, origStyle, origFont.Size());
 
-		font_style style;
-		int32 numStyles = count_font_styles(family);
-		for (int32 j = 0; j < numStyles; j++) {
-			bool inStyle = false;
-			if (get_font_style(family, j, &style) != B_OK)
-				continue;
-
-			BMenu* styleMenu = new BMenu(style);
-			familyMenu->AddItem(styleMenu);
-			styleMenu->SetRadioMode(false);
-			if (inFamily && strcmp(style, origStyle) == 0) {
-				BMenuItem* item = familyMenu->FindItem(style);
-				item->SetMarked(true);
-				inStyle = true;
-			}
-
-			float baseSize = be_plain_font->Size();
-			for (double k = baseSize - 4; k < baseSize + 4.5; k += 0.5) {
-				BString itemStr;
-				itemStr.SetToFormat("%g", k);
-				BMessage* message = new BMessage(kFontMessage);
-				message->AddString("FontFamily", family);
-				message->AddString("FontStyle", style);
-				message->AddDouble("FontSize", k);
-				BMenuItem* sizeItem = new BMenuItem(itemStr, message);
-				styleMenu->AddItem(sizeItem);
-				if (inStyle && k == origFont.Size())
-					sizeItem->SetMarked(true);
-			}
-		}
-	}
-
-	//TODO ensure we found at least one item to mark
-//	if (menu->FindMarked() == NULL)
-//		menu->ItemAt(0)->SetMarked(true);
-
-	menu->SetTargetForItems(this);
-
-	return menu;
+	return fFontMenu;
 }
 
 
@@ -544,32 +862,8 @@ SettingsWindow::_UpdateFontMenu(const char* family, const char* style, double si
 	if (menuField == NULL)
 		return B_ERROR;
 
-	BMenu* menu = menuField->Menu();
-	for (int32 i = 0; i < menu->CountItems(); i++) {
-		bool inFamily = false;
-		BMenuItem* familyItem = menu->ItemAt(i);
-		if (strcmp(family, familyItem->Label()) == 0)
-			inFamily = true;
-
-		familyItem->SetMarked(inFamily);
-
-		BMenu* familyMenu = menu->SubmenuAt(i);
-		for (int32 j = 0; j < familyMenu->CountItems(); j++) {
-			bool inStyle = false;
-			BMenuItem* styleItem = familyMenu->ItemAt(j);
-			if (inFamily && strcmp(style, styleItem->Label()) == 0)
-				inStyle = true;
-
-			styleItem->SetMarked(inStyle);
-
-			BMenu* styleMenu = familyMenu->SubmenuAt(j);
-			for (int32 k = 0; k < styleMenu->CountItems(); k++) {
-				BMenuItem* sizeItem = styleMenu->ItemAt(k);
-				sizeItem->SetMarked(inStyle && atof(sizeItem->Label()) == size);
-				//TODO ensure we found at least one item to mark
-			}
-		}
-	}
+	//TODO ensure we found at least one item to mark
+	fFontMenu->Select(family, style, size);
 
 	BString menuLabelStr;
 	menuLabelStr.SetToFormat("%s - %s - %g", family, style, size);
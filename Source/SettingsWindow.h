@@ -8,13 +8,17 @@
 #include <Window.h>
 
 
+class BButton;
 class BCheckBox;
 class BInvoker;
+class BListView;
 class BMenu;
 class BMenuField;
 class BRadioButton;
+class BScrollView;
 class BTextControl;
 
+class FontMenu;
 class WeatherSettings;
 
 
@@ -31,25 +35,40 @@ private:
 			void		_InitControls();
 			void		_RevertSettings();
 			void		_SaveSettings();
+			void		_SearchLocation();
+			void		_SelectLocation();
+			void		_ClearSearchResults();
+			void		_UpdateSavedList();
+			bool		_RevertSavedLocations();
 			BMenu*		_BuildFontMenu();
 			status_t	_ResetFontMenu();
 			status_t	_HandleFontChange(BMessage* message);
 			status_t	_UpdateFontMenu(const char* family, const char* style, double size);
 
 	BCheckBox*			fCompactBox;
+	BMenuField*			fDisplayMenuField;
+	BMenuField*			fGeoCacheMenuField;
 	BCheckBox*			fGeoNotificationBox;
+	BCheckBox*			fHourlyBox;
+	BCheckBox*			fKeepForecastBox;
 	BRadioButton*		fImperialButton;
 	BMenuField*			fIntervalMenuField;
 	BMenuField*			fDaysMenuField;
+	FontMenu*			fFontMenu;
 	BInvoker*			fInvoker;
 	BCheckBox*			fLocationBox;
 	BTextControl*		fLocationControl;
+	BListView*			fLocationListView;
+	BScrollView*		fLocationScrollView;
 	BRadioButton*		fMetricButton;
+	BButton*			fRemoveLocationButton;
+	BListView*			fSavedListView;
 	BCheckBox*			fNotificationBox;
 	WeatherSettings*	fSettings;
 	WeatherSettings*	fSettingsCache;
 	BCheckBox*			fShowFeelsLikeBox;
 	BCheckBox*			fShowForecastBox;
+	BCheckBox*			fTickerBox;
 
 };
 
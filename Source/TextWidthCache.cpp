@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "TextWidthCache.h"
+
+#include <string.h>
+
+
+TextWidthCache::TextWidthCache()
+	:
+	fClock(0)
+{
+	MakeEmpty();
+}
+
+
+float
+TextWidthCache::Width(const BFont& font, const char* text)
+{
+	char shape[kMaxTextShapeLength];
+	size_t length = strlen(text);
+	if (length >= sizeof(shape))
+		return font.StringWidth(text);
+
+	for (size_t x = 0; x <= length; x++)
+		shape[x] = text[x] >= '0' && text[x] <= '9' ? '8' : text[x];
+
+	entry* oldest = &fEntries[0];
+	for (int32 x = 0; x < kTextWidthCacheSize; x++) {
+		entry& current = fEntries[x];
+		if (current.used != 0 && strcmp(current.shape, shape) == 0 && current.font == font) {
+			current.used = ++fClock;
+			return current.width;
+		}
+
+		if (current.used < oldest->used)
+			oldest = &current;
+	}
+
+	oldest->font = font;
+	strcpy(oldest->shape, shape);
+	oldest->width = font.StringWidth(shape);
+	oldest->used = ++fClock;
+	return oldest->width;
+}
+
+
+void
+TextWidthCache::MakeEmpty()
+{
+	for (int32 x = 0; x < kTextWidthCacheSize; x++)
+		fEntries[x].used = 0;
+}
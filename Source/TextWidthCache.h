@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _TEXTWIDTHCACHE_H_
+#define _TEXTWIDTHCACHE_H_
+
+
+#include <Font.h>
+
+
+static const int32 kTextWidthCacheSize = 16;
+static const int32 kMaxTextShapeLength = 32;
+
+
+// Remembers how wide texts are in a font, so a new temperature or another
+// display mode doesn't ask the font engine again.  Texts are kept by their
+// shape, every digit counts as an 8, so "12.3°" and "45.6°" share an entry
+// and the width is the one of the widest text with that shape.  The entry
+// used least recently makes room for a new one.
+class TextWidthCache {
+public:
+						TextWidthCache();
+
+			float		Width(const BFont& font, const char* text);
+			void		MakeEmpty();
+
+private:
+	struct entry {
+		BFont		font;
+		char		shape[kMaxTextShapeLength];
+		float		width;
+		uint32		used;	// 0 when the entry is free
+	};
+
+			entry		fEntries[kTextWidthCacheSize];
+			uint32		fClock;
+};
+
+
+#endif // _TEXTWIDTHCACHE_H_
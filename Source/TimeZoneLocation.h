@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _TIMEZONELOCATION_H_
+#define _TIMEZONELOCATION_H_
+
+
+#include <String.h>
+
+
+// Coarse offline location taken from the configured time zone, good enough
+// for a first weather request until a real location is known.
+status_t	get_time_zone_location(const char* zoneID, BString& name, double& latitude,
+				double& longitude);
+status_t	get_default_time_zone_location(BString& name, double& latitude, double& longitude);
+
+#endif // _TIMEZONELOCATION_H_
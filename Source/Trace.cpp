@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "Trace.h"
+
+#include <OS.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static const int32 kMaxTraceThreads = 256;
+static const int32 kThreadNameLength = 32;
+
+
+struct trace_event {
+	const char*	name;
+	bigtime_t	time;
+	bigtime_t	duration;	// only for complete events
+	int32		thread;
+	char		phase;		// 'B'egin, 'E'nd or 'X' for complete
+};
+
+
+struct trace_ring {
+	trace_event	events[kTraceRingSize];
+	uint32		head;		// the number of events ever written, only the owner writes it
+	bool		inUse;
+};
+
+
+struct trace_thread {
+	int32		id;
+	char		name[kThreadNameLength];
+};
+
+
+bool Trace::sEnabled = false;
+
+static pthread_mutex_t sLock = PTHREAD_MUTEX_INITIALIZER;
+static trace_ring* sRings[kMaxTraceRings];
+static int32 sRingCount = 0;
+// the names of the last threads that recorded something, for the timeline
+static trace_thread sThreads[kMaxTraceThreads];
+static int32 sThreadCount = 0;
+
+
+static void
+current_thread(int32& id, char* name)
+{
+#ifdef __HAIKU__
+	thread_info info;
+	id = find_thread(NULL);
+	if (get_thread_info(id, &info) == B_OK)
+		strlcpy(name, info.name, kThreadNameLength);
+	else
+		snprintf(name, kThreadNameLength, "thread %d", static_cast<int>(id));
+#else
+	id = sThreadCount + 1;
+#if defined(__linux__)
+	if (pthread_getname_np(pthread_self(), name, kThreadNameLength) != 0)
+#endif
+		snprintf(name, kThreadNameLength, "thread %d", static_cast<int>(id));
+#endif
+}
+
+
+// hands the ring back when the thread ends
+class TraceThread {
+public:
+	TraceThread()
+		:
+		fRing(NULL),
+		fThread(-1),
+		fRegistered(false)
+	{}
+
+
+	~TraceThread()
+	{
+		if (fRing == NULL)
+			return;
+
+		pthread_mutex_lock(&sLock);
+		fRing->inUse = false;
+		pthread_mutex_unlock(&sLock);
+	}
+
+
+	trace_ring*
+	Ring()
+	{
+		if (!fRegistered)
+			_Register();
+
+		return fRing;
+	}
+
+
+	int32
+	Thread() const
+	{
+		return fThread;
+	}
+
+private:
+	void
+	_Register()
+	{
+		pthread_mutex_lock(&sLock);
+		fRegistered = true;
+
+		for (int32 x = 0; x < sRingCount && fRing == NULL; x++) {
+			if (!sRings[x]->inUse)
+				fRing = sRings[x];
+		}
+
+		if (fRing == NULL && sRingCount < kMaxTraceRings) {
+			fRing = static_cast<trace_ring*>(calloc(1, sizeof(trace_ring)));
+			if (fRing != NULL)
+				sRings[sRingCount++] = fRing;
+		}
+
+		// without a ring this thread isn't traced
+		if (fRing != NULL) {
+			fRing->inUse = true;
+
+			trace_thread& thread = sThreads[sThreadCount % kMaxTraceThreads];
+			current_thread(thread.id, thread.name);
+			fThread = thread.id;
+			sThreadCount++;
+		}
+
+		pthread_mutex_unlock(&sLock);
+	}
+
+			trace_ring*			fRing;
+			int32				fThread;
+			bool				fRegistered;
+};
+
+
+static thread_local TraceThread sThread;
+
+
+static void
+record(char phase, const char* name, bigtime_t time, bigtime_t duration)
+{
+	trace_ring* ring = sThread.Ring();
+	if (ring == NULL)
+		return;
+
+	uint32 head = ring->head;
+	trace_event& event = ring->events[head % kTraceRingSize];
+	event.name = name;
+	event.time = time;
+	event.duration = duration;
+	event.thread = sThread.Thread();
+	event.phase = phase;
+
+	// the event has to be complete before a dump can see it
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+
+static void
+write_string(FILE* file, const char* string)
+{
+	fputc('"', file);
+	for (; *string != '\0'; string++) {
+		if (*string == '"' || *string == '\\')
+			fputc('\\', file);
+		if (static_cast<unsigned char>(*string) >= 0x20)
+			fputc(*string, file);
+	}
+	fputc('"', file);
+}
+
+
+void
+Trace::Start()
+{
+	sEnabled = true;
+}
+
+
+void
+Trace::Stop()
+{
+	sEnabled = false;
+}
+
+
+void
+Trace::Begin(const char* name)
+{
+	record('B', name, system_time(), 0);
+}
+
+
+void
+Trace::End(const char* name)
+{
+	record('E', name, system_time(), 0);
+}
+
+
+void
+Trace::Complete(const char* name, bigtime_t start, bigtime_t duration)
+{
+	if (sEnabled)
+		record('X', name, start, duration);
+}
+
+
+status_t
+Trace::Dump(const char* path)
+{
+	trace_event* events = static_cast<trace_event*>(malloc(kTraceRingSize * sizeof(trace_event)));
+	if (events == NULL)
+		return B_NO_MEMORY;
+
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		free(events);
+		return B_ERROR;
+	}
+
+	int pid = getpid();
+	bool first = true;
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+
+	pthread_mutex_lock(&sLock);
+
+	int32 threads = sThreadCount < kMaxTraceThreads ? sThreadCount : kMaxTraceThreads;
+	for (int32 x = 0; x < threads; x++) {
+		fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+			first ? "" : ",", pid, static_cast<int>(sThreads[x].id));
+		write_string(file, sThreads[x].name);
+		fputs("}}", file);
+		first = false;
+	}
+
+	for (int32 x = 0; x < sRingCount; x++) {
+		trace_ring* ring = sRings[x];
+
+		// the owner keeps writing, everything it could have overwritten while
+		// copying is left out
+		uint32 head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		uint32 start = head > static_cast<uint32>(kTraceRingSize) ? head - kTraceRingSize : 0;
+		for (uint32 index = start; index < head; index++)
+			events[index - start] = ring->events[index % kTraceRingSize];
+
+		uint32 newHead = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		uint32 valid = newHead >= static_cast<uint32>(kTraceRingSize) ? newHead - kTraceRingSize + 1 : 0;
+		if (valid < start)
+			valid = start;
+
+		for (uint32 index = valid; index < head; index++) {
+			const trace_event& event = events[index - start];
+			fprintf(file, "%s\n{\"name\":", first ? "" : ",");
+			write_string(file, event.name);
+			fprintf(file, ",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%d,\"tid\":%d", event.phase,
+				static_cast<long long>(event.time), pid, static_cast<int>(event.thread));
+			if (event.phase == 'X')
+				fprintf(file, ",\"dur\":%lld", static_cast<long long>(event.duration));
+			fputc('}', file);
+			first = false;
+		}
+	}
+
+	pthread_mutex_unlock(&sLock);
+
+	fputs("\n]}\n", file);
+	status_t status = ferror(file) ? B_IO_ERROR : B_OK;
+	if (fclose(file) != 0)
+		status = B_IO_ERROR;
+
+	free(events);
+	return status;
+}
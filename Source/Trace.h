@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+
+#include <SupportDefs.h>
+
+
+static const int32 kTraceRingSize = 2048;
+static const int32 kMaxTraceRings = 32;
+
+
+// Records begin and end events into a ring buffer of the calling thread.  Only
+// that thread writes to its ring, so recording doesn't take a lock.  The rings
+// of threads that ended are handed to new threads, the events stay until they
+// are overwritten.  Dump() writes everything in the Chrome trace format, which
+// Perfetto opens as well.
+//
+// Event names have to be string literals, only the pointer is recorded.
+class Trace {
+public:
+	static	void				Start();
+	static	void				Stop();
+	static	bool				IsEnabled() { return sEnabled; }
+
+	static	void				Begin(const char* name);
+	static	void				End(const char* name);
+	// an event that started earlier, for timings collected by someone else
+	static	void				Complete(const char* name, bigtime_t start, bigtime_t duration);
+
+	static	status_t			Dump(const char* path);
+
+private:
+	static	bool				sEnabled;
+};
+
+
+// traces the rest of the scope, costs a single branch while tracing is off
+class TraceScope {
+public:
+	TraceScope(const char* name)
+		:
+		fName(NULL)
+	{
+		if (__builtin_expect(Trace::IsEnabled(), 0)) {
+			fName = name;
+			Trace::Begin(name);
+		}
+	}
+
+
+	~TraceScope()
+	{
+		if (fName != NULL)
+			Trace::End(fName);
+	}
+
+private:
+			const char*			fName;
+};
+
+
+#define TRACE_SCOPE_NAME(line) _traceScope ## line
+#define TRACE_SCOPE_LINE(name, line) TraceScope TRACE_SCOPE_NAME(line)(name)
+#define TRACE_SCOPE(name) TRACE_SCOPE_LINE(name, __LINE__)
+
+#endif // _TRACE_H_
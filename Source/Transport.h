@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _TRANSPORT_H_
+#define _TRANSPORT_H_
+
+
+#include <SupportDefs.h>
+
+#include <stddef.h>
+
+
+// one finished HTTP request, everything only stays valid during the callback
+struct transport_exchange {
+	const char*	url;
+	int32		status;			// the HTTP status code, 0 when the request failed
+	const char*	statusText;
+	const void*	body;
+	size_t		bodySize;
+	bigtime_t	time;			// when the request was started, in microseconds since the epoch
+	bigtime_t	duration;		// from the start of the request until the reply was complete
+
+	// where the duration went, -1 for phases the transport doesn't know about
+	bigtime_t	resolveTime;	// looking up the host name
+	bigtime_t	connectTime;	// opening the connection, including the TLS handshake
+	bigtime_t	waitTime;		// from sending the request until the reply started
+	bigtime_t	transferTime;	// receiving the rest of the reply
+};
+
+
+class TransportListener {
+public:
+	virtual				~TransportListener() {}
+
+	// called from the thread of the transport
+	virtual	void		ExchangeCompleted(const transport_exchange& exchange) = 0;
+};
+
+
+// Gets the weather and location replies, either from the network or from a
+// capture archive.  A listener has at most one request running at a time.
+class Transport {
+public:
+	virtual				~Transport() {}
+
+	// B_BUSY while the last request of the listener is still running
+	virtual	status_t	Fetch(const char* url, TransportListener* listener) = 0;
+	// the listener isn't called anymore once this returns
+	virtual	void		Cancel(TransportListener* listener) = 0;
+};
+
+#endif // _TRANSPORT_H_
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#include "WeatherCode.h"
+
+#include <Catalog.h>
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "WeatherCode"
+
+
+#if __cplusplus >= 201103L
+#define WEATHER_TABLE_CONST constexpr
+#else
+#define WEATHER_TABLE_CONST const
+#endif
+
+
+struct weather_code_info {
+	uint8		icon;			// index into kWeatherIconNames
+	uint8		severity;
+	uint8		precipitation;	// precipitation_class
+	const char*	description;	// also the catalog key, NULL for unused codes
+};
+
+
+#include "WeatherCodeTable.h"
+
+
+static inline const weather_code_info*
+find_weather_code(int32 code)
+{
+	if (code < 0 || code >= kWeatherCodeCount || kWeatherCodes[code].description == NULL)
+		return NULL;
+
+	return &kWeatherCodes[code];
+}
+
+
+weather_code
+to_weather_code(int32 code)
+{
+	return find_weather_code(code) != NULL ? static_cast<weather_code>(code) : kWeatherUnknown;
+}
+
+
+const char*
+weather_code_description(weather_code code)
+{
+	const weather_code_info* info = find_weather_code(code);
+	const char* description = info != NULL ? info->description : B_TRANSLATE_MARK("Unknown conditions");
+
+#ifdef HAIKU_ENABLE_I18N
+	return B_TRANSLATE_NOCOLLECT(description);
+#else
+	return description;
+#endif
+}
+
+
+const char*
+weather_code_icon(weather_code code)
+{
+	const weather_code_info* info = find_weather_code(code);
+	return kWeatherIconNames[info != NULL ? info->icon : 0];
+}
+
+
+int32
+count_weather_icons()
+{
+	return sizeof(kWeatherIconNames) / sizeof(kWeatherIconNames[0]);
+}
+
+
+const char*
+weather_icon_name(int32 index)
+{
+	if (index < 0 || index >= count_weather_icons())
+		return NULL;
+
+	return kWeatherIconNames[index];
+}
+
+
+uint8
+weather_code_severity(weather_code code)
+{
+	const weather_code_info* info = find_weather_code(code);
+	return info != NULL ? info->severity : 0;
+}
+
+
+precipitation_class
+weather_code_precipitation(weather_code code)
+{
+	const weather_code_info* info = find_weather_code(code);
+	if (info == NULL)
+		return kPrecipitationNone;
+
+	return static_cast<precipitation_class>(info->precipitation);
+}
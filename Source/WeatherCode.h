@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+#ifndef _WEATHERCODE_H_
+#define _WEATHERCODE_H_
+
+
+#include <SupportDefs.h>
+
+
+// WMO weather interpretation codes as used by Open-Meteo
+enum weather_code {
+	kWeatherUnknown					= -1,
+	kWeatherClearSky				= 0,
+	kWeatherMainlyClear				= 1,
+	kWeatherPartlyCloudy			= 2,
+	kWeatherOvercast				= 3,
+	kWeatherFog						= 45,
+	kWeatherRimeFog					= 48,
+	kWeatherLightDrizzle			= 51,
+	kWeatherDrizzle					= 53,
+	kWeatherDenseDrizzle			= 55,
+	kWeatherLightFreezingDrizzle	= 56,
+	kWeatherDenseFreezingDrizzle	= 57,
+	kWeatherSlightRain				= 61,
+	kWeatherRain					= 63,
+	kWeatherHeavyRain				= 65,
+	kWeatherLightFreezingRain		= 66,
+	kWeatherHeavyFreezingRain		= 67,
+	kWeatherSlightSnow				= 71,
+	kWeatherSnow					= 73,
+	kWeatherHeavySnow				= 75,
+	kWeatherSnowGrains				= 77,
+	kWeatherSlightRainShowers		= 80,
+	kWeatherRainShowers				= 81,
+	kWeatherViolentRainShowers		= 82,
+	kWeatherSlightSnowShowers		= 85,
+	kWeatherHeavySnowShowers		= 86,
+	kWeatherThunderstorm			= 95,
+	kWeatherThunderstormSlightHail	= 96,
+	kWeatherThunderstormHeavyHail	= 99
+};
+
+
+enum precipitation_class {
+	kPrecipitationNone,
+	kPrecipitationDrizzle,
+	kPrecipitationRain,
+	kPrecipitationFreezing,
+	kPrecipitationSnow,
+	kPrecipitationHail
+};
+
+
+// The code table is generated from WeatherCodes.txt, add new codes there.
+weather_code	to_weather_code(int32 code);
+const char*		weather_code_description(weather_code code);
+const char*		weather_code_icon(weather_code code);
+// every icon weather_code_icon() can return
+int32			count_weather_icons();
+const char*		weather_icon_name(int32 index);
+uint8			weather_code_severity(weather_code code);
+precipitation_class	weather_code_precipitation(weather_code code);
+
+#endif // _WEATHERCODE_H_
@@ -7,6 +7,7 @@
 #include <FindDirectory.h>
 #include <Font.h>
 #include <Path.h>
+#include <String.h>
 
 
 const char* kPrefsFileName = "DeskbarWeatherSettings";
@@ -16,6 +17,7 @@ const char* kIntervalKey = "dw:RefreshInterval";
 const char* kUseImperialKey = "dw:UseImperial";
 const char* kUseGeoLocationKey = "dw:UseGeoLocation";
 const char* kUseGeoNotificationKey = "dw:UseGeoNotification";
+const char* kGeoCacheLifetimeKey = "dw:GeoCacheLifetime";
 const char* kUseNotificationKey = "dw:UseNotification";
 const char* kNotificationClickKey = "dw:NotificationClick";
 const char* kLatitudeKey = "dw:Latitude";
@@ -24,8 +26,16 @@ const char* kFontFamilyKey = "dw:FontFamily";
 const char* kFontStyleKey = "dw:FontStyle";
 const char* kFontSizeKey = "dw:FontSize";
 const char* kCompactForecastKey = "dw:CompactForecast";
+const char* kKeepForecastWindowKey = "dw:KeepForecastWindow";
 const char* kShowFeelsLikeKey = "dw:ShowFeelsLike";
+const char* kDisplayModeKey = "dw:DisplayMode";
+const char* kSavedNameKey = "dw:SavedLocation";
+const char* kSavedLatitudeKey = "dw:SavedLatitude";
+const char* kSavedLongitudeKey = "dw:SavedLongitude";
+const char* kTickerKey = "dw:Ticker";
 const char* kForecastDaysKey = "dw:ForecastDays";
+const char* kHourlyForecastKey = "dw:HourlyForecast";
+const char* kHandlerBudgetKey = "dw:HandlerBudget";
 
 const char* kDefaultLocation = "Rapa Nui";
 const double kDefaultLatitude = -27.116667;
@@ -37,9 +47,15 @@ const bool kUseGeoLocationDefault = true;
 const bool kUseNotificationDefault = true;
 const bool kNotificationClickDefault = false;
 const bool kUseGeoNotificationDefault = true;
+const int32 kGeoCacheLifetimeDefault = 24;
 const bool kCompactForecastDefault = false;
+const bool kKeepForecastWindowDefault = false;
 const bool kShowFeelsLikeDefault = false;
+const int32 kDisplayModeDefault = kDisplayTemperature;
+const bool kTickerDefault = false;
 const int32 kForecastDaysDefault = 7;
+const bool kHourlyForecastDefault = true;
+const int32 kHandlerBudgetDefault = 4;
 
 
 WeatherSettings::WeatherSettings()
@@ -113,6 +129,21 @@ WeatherSettings::SetCompactForecast(bool enabled)
 }
 
 
+// keeps a hidden forecast window around, so it opens without building it
+bool
+WeatherSettings::KeepForecastWindow()
+{
+	return GetBool(kKeepForecastWindowKey, kKeepForecastWindowDefault);
+}
+
+
+void
+WeatherSettings::SetKeepForecastWindow(bool enabled)
+{
+	SetBool(kKeepForecastWindowKey, enabled);
+}
+
+
 bool
 WeatherSettings::ShowFeelsLike()
 {
@@ -127,6 +158,96 @@ WeatherSettings::SetShowFeelsLike(bool enabled)
 }
 
 
+display_mode
+WeatherSettings::DisplayMode()
+{
+	int32 mode = GetInt32(kDisplayModeKey, kDisplayModeDefault);
+	if (mode < 0 || mode >= kDisplayModeCount)
+		return kDisplayTemperature;
+
+	return static_cast<display_mode>(mode);
+}
+
+
+void
+WeatherSettings::SetDisplayMode(display_mode mode)
+{
+	SetInt32(kDisplayModeKey, mode);
+}
+
+
+// the saved locations are kept as three lists of the same length
+int32
+WeatherSettings::CountSavedLocations()
+{
+	type_code type;
+	int32 count;
+	if (GetInfo(kSavedNameKey, &type, &count) != B_OK)
+		return 0;
+
+	return count;
+}
+
+
+status_t
+WeatherSettings::GetSavedLocation(int32 index, BString& name, double& latitude, double& longitude)
+{
+	if (FindString(kSavedNameKey, index, &name) != B_OK
+		|| FindDouble(kSavedLatitudeKey, index, &latitude) != B_OK
+		|| FindDouble(kSavedLongitudeKey, index, &longitude) != B_OK)
+		return B_BAD_INDEX;
+
+	return B_OK;
+}
+
+
+status_t
+WeatherSettings::AddSavedLocation(const char* name, double latitude, double longitude)
+{
+	int32 count = CountSavedLocations();
+	if (count >= kMaxSavedLocations)
+		return B_NO_MEMORY;
+
+	// the same place twice would only show up twice in the ticker
+	for (int32 x = 0; x < count; x++) {
+		if (GetDouble(kSavedLatitudeKey, x, 0) == latitude && GetDouble(kSavedLongitudeKey, x, 0) == longitude)
+			return B_NAME_IN_USE;
+	}
+
+	AddString(kSavedNameKey, name);
+	AddDouble(kSavedLatitudeKey, latitude);
+	AddDouble(kSavedLongitudeKey, longitude);
+	return B_OK;
+}
+
+
+status_t
+WeatherSettings::RemoveSavedLocation(int32 index)
+{
+	if (index < 0 || index >= CountSavedLocations())
+		return B_BAD_INDEX;
+
+	RemoveData(kSavedNameKey, index);
+	RemoveData(kSavedLatitudeKey, index);
+	RemoveData(kSavedLongitudeKey, index);
+	return B_OK;
+}
+
+
+bool
+WeatherSettings::Ticker()
+{
+	return GetBool(kTickerKey, kTickerDefault);
+}
+
+
+void
+WeatherSettings::SetTicker(bool enabled)
+{
+	SetBool(kTickerKey, enabled);
+}
+
+
 int32
 WeatherSettings::ForecastDays()
 {
@@ -141,6 +262,38 @@ WeatherSettings::SetForecastDays(int32 days)
 }
 
 
+bool
+WeatherSettings::HourlyForecast()
+{
+	return GetBool(kHourlyForecastKey, kHourlyForecastDefault);
+}
+
+
+void
+WeatherSettings::SetHourlyForecast(bool enabled)
+{
+	SetBool(kHourlyForecastKey, enabled);
+}
+
+
+// how long the replicant may block the Deskbar for one message
+int32
+WeatherSettings::HandlerBudget()
+{
+	return GetInt32(kHandlerBudgetKey, kHandlerBudgetDefault);
+}
+
+
+void
+WeatherSettings::SetHandlerBudget(int32 milliseconds)
+{
+	if (milliseconds <= 0)
+		return;
+
+	SetInt32(kHandlerBudgetKey, milliseconds);
+}
+
+
 const char*
 WeatherSettings::Location()
 {
@@ -152,6 +305,13 @@ WeatherSettings::Location()
 }
 
 
+bool
+WeatherSettings::HasLocation()
+{
+	return HasString(kLocationKey);
+}
+
+
 void
 WeatherSettings::SetLocation(const char* location)
 {
@@ -167,6 +327,13 @@ WeatherSettings::SetLocation(double latitude, double longitude)
 }
 
 
+bool
+WeatherSettings::HasCoordinates()
+{
+	return HasDouble(kLatitudeKey) && HasDouble(kLongitudeKey);
+}
+
+
 double
 WeatherSettings::Latitude()
 {
@@ -223,6 +390,23 @@ WeatherSettings::SetUseGeoNotification(bool useNotificaton)
 }
 
 
+int32
+WeatherSettings::GeoCacheLifetime()
+{
+	return GetInt32(kGeoCacheLifetimeKey, kGeoCacheLifetimeDefault);
+}
+
+
+void
+WeatherSettings::SetGeoCacheLifetime(int32 hours)
+{
+	if (hours <= 0)
+		return;
+
+	SetInt32(kGeoCacheLifetimeKey, hours);
+}
+
+
 bool
 WeatherSettings::NotificationClick()
 {
@@ -10,6 +10,18 @@
 
 
 class BFont;
+class BString;
+
+static const int32 kMaxSavedLocations = 8;
+
+
+// what the replicant shows next to its icon
+enum display_mode {
+	kDisplayTemperature = 0,
+	kDisplayHighLow,		// and today's high and low
+	kDisplayRain,			// and the chance of rain this hour, needs the hourly forecast
+	kDisplayModeCount
+};
 
 
 class WeatherSettings : public BMessage, public BLocker {
@@ -22,8 +34,10 @@ public:
 	status_t	Save();
 
 	const char*	Location();
+	bool		HasLocation();
 	void		SetLocation(const char* location);
 	void		SetLocation(double latitude, double longitude);
+	bool		HasCoordinates();
 	double		Latitude();
 	double		Longitude();
 	bool		ImperialUnits();
@@ -34,6 +48,8 @@ public:
 	bool		UseGeoLocation();
 	void		SetUseGeoNotification(bool enabled);
 	bool		UseGeoNotification();
+	void		SetGeoCacheLifetime(int32 hours);
+	int32		GeoCacheLifetime();
 	void		SetUseNotification(bool enabled);
 	bool		UseNotification();
 	void		SetNotificationClick(bool enabled);
@@ -44,10 +60,24 @@ public:
 	void		ResetFont();
 	void		SetCompactForecast(bool enabled);
 	bool		CompactForecast();
+	void		SetKeepForecastWindow(bool enabled);
+	bool		KeepForecastWindow();
 	void		SetShowFeelsLike(bool enabled);
 	bool		ShowFeelsLike();
+	void		SetDisplayMode(display_mode mode);
+	display_mode	DisplayMode();
+	int32		CountSavedLocations();
+	status_t	GetSavedLocation(int32 index, BString& name, double& latitude, double& longitude);
+	status_t	AddSavedLocation(const char* name, double latitude, double longitude);
+	status_t	RemoveSavedLocation(int32 index);
+	void		SetTicker(bool enabled);
+	bool		Ticker();
 	void		SetForecastDays(int32 days);
 	int32		ForecastDays();
+	void		SetHourlyForecast(bool enabled);
+	bool		HourlyForecast();
+	void		SetHandlerBudget(int32 milliseconds);
+	int32		HandlerBudget();
 };
 
 #endif // _WEATHERSETTINGS_H_
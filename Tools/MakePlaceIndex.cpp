@@ -0,0 +1,368 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2021 Chris Roberts
+
+// Build time generator for the place index used by PlaceIndex.
+//
+// Input is either the bundled tab separated format
+//		name	region	country	latitude	longitude	population
+// or a GeoNames cities file (cities15000.txt etc) when --geonames is given.
+
+#include "PlaceIndexFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+struct Place {
+	std::string	name;
+	std::string	region;
+	std::string	country;
+	float		latitude;
+	float		longitude;
+	uint32		population;
+};
+
+
+struct TreeBuilder {
+	std::vector<place_tree_node>& nodes;
+
+	void
+	Build(int32 low, int32 high, int32 depth)
+	{
+		if (low >= high)
+			return;
+
+		int32 axis = depth % 3;
+		int32 middle = (low + high) / 2;
+		std::nth_element(nodes.begin() + low, nodes.begin() + middle, nodes.begin() + high,
+			[axis](const place_tree_node& a, const place_tree_node& b) {
+				return Axis(a, axis) < Axis(b, axis);
+			});
+
+		Build(low, middle, depth + 1);
+		Build(middle + 1, high, depth + 1);
+	}
+
+	static float
+	Axis(const place_tree_node& node, int32 axis)
+	{
+		return axis == 0 ? node.x : (axis == 1 ? node.y : node.z);
+	}
+};
+
+
+struct TrieBuilder {
+	const std::vector<std::string>&		keys;
+	const std::vector<place_record>&	records;
+	std::vector<place_trie_node>		nodes;
+
+	void
+	Build()
+	{
+		std::vector<int32> depths;
+		nodes.push_back(Node(0, 0, keys.size()));
+		depths.push_back(0);
+
+		// breadth first so the children of every node are stored next to each other
+		for (size_t current = 0; current < nodes.size(); current++) {
+			int32 depth = depths[current];
+			if (depth == kPlaceTrieDepth)
+				continue;
+
+			uint32 firstChild = nodes.size();
+			uint32 x = nodes[current].low;
+			uint32 high = nodes[current].high;
+			while (x < high) {
+				// shorter keys sort first and have no child for this position
+				if (keys[x].size() <= (size_t)depth) {
+					x++;
+					continue;
+				}
+
+				char character = keys[x][depth];
+				uint32 end = x;
+				while (end < high && keys[end].size() > (size_t)depth && keys[end][depth] == character)
+					end++;
+
+				nodes.push_back(Node(character, x, end));
+				depths.push_back(depth + 1);
+				x = end;
+			}
+
+			nodes[current].first_child = firstChild;
+			nodes[current].child_count = nodes.size() - firstChild;
+		}
+	}
+
+	place_trie_node
+	Node(char character, uint32 low, uint32 high)
+	{
+		place_trie_node node;
+		memset(&node, 0, sizeof(node));
+		node.character = character;
+		node.low = low;
+		node.high = high;
+
+		std::vector<uint32> ranked;
+		for (uint32 x = low; x < high; x++)
+			ranked.push_back(x);
+
+		size_t count = std::min(ranked.size(), (size_t)kPlaceTrieTopCount);
+		std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+			[this](uint32 a, uint32 b) { return records[a].population > records[b].population; });
+
+		node.top_count = count;
+		for (size_t x = 0; x < count; x++)
+			node.top[x] = ranked[x];
+
+		return node;
+	}
+};
+
+
+static std::vector<std::string>
+split_line(const std::string& line)
+{
+	std::vector<std::string> fields;
+	std::stringstream stream(line);
+	std::string field;
+	while (std::getline(stream, field, '\t'))
+		fields.push_back(field);
+
+	return fields;
+}
+
+
+static std::string
+sort_key(const std::string& name)
+{
+	std::string key(name);
+	for (size_t x = 0; x < key.size(); x++)
+		key[x] = place_key_fold(key[x]);
+
+	return key;
+}
+
+
+static bool
+load_admin1(const char* path, std::map<std::string, std::string>& names)
+{
+	std::ifstream input(path);
+	if (!input)
+		return false;
+
+	// CC.code	name	asciiname	geonameid
+	std::string line;
+	while (std::getline(input, line)) {
+		std::vector<std::string> fields = split_line(line);
+		if (fields.size() >= 3)
+			names[fields[0]] = fields[2];
+	}
+
+	return true;
+}
+
+
+static bool
+load_places(const char* path, bool geonames, uint32 minPopulation,
+	const std::map<std::string, std::string>& admin1, std::vector<Place>& places)
+{
+	std::ifstream input(path);
+	if (!input)
+		return false;
+
+	std::string line;
+	while (std::getline(input, line)) {
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::vector<std::string> fields = split_line(line);
+		Place place;
+		if (geonames) {
+			if (fields.size() < 15)
+				continue;
+
+			place.name = fields[2].empty() ? fields[1] : fields[2];
+			place.country = fields[8];
+			std::map<std::string, std::string>::const_iterator region
+				= admin1.find(fields[8] + "." + fields[10]);
+			if (region != admin1.end())
+				place.region = region->second;
+			place.latitude = strtof(fields[4].c_str(), NULL);
+			place.longitude = strtof(fields[5].c_str(), NULL);
+			place.population = strtoul(fields[14].c_str(), NULL, 10);
+		} else {
+			if (fields.size() < 6)
+				continue;
+
+			place.name = fields[0];
+			place.region = fields[1];
+			place.country = fields[2];
+			place.latitude = strtof(fields[3].c_str(), NULL);
+			place.longitude = strtof(fields[4].c_str(), NULL);
+			place.population = strtoul(fields[5].c_str(), NULL, 10);
+		}
+
+		if (place.name.empty() || place.population < minPopulation)
+			continue;
+
+		places.push_back(place);
+	}
+
+	return true;
+}
+
+
+static void
+add_section(place_index_header& header, std::string& body, uint32 type, const void* data, size_t size)
+{
+	// keep every section 8 byte aligned so it can be used straight from the mapping
+	while ((sizeof(place_index_header) + body.size()) % 8 != 0)
+		body.push_back('\0');
+
+	place_index_section& section = header.sections[header.section_count++];
+	section.type = type;
+	section.offset = sizeof(place_index_header) + body.size();
+	section.size = size;
+	body.append(static_cast<const char*>(data), size);
+}
+
+
+static void
+usage(const char* name)
+{
+	std::cerr << "Usage: " << name << " [--geonames] [--admin1 file] [--min-population count] -o output input..."
+		<< std::endl;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const char* output = NULL;
+	const char* admin1Path = NULL;
+	bool geonames = false;
+	uint32 minPopulation = 0;
+	std::vector<const char*> inputs;
+
+	for (int x = 1; x < argc; x++) {
+		if (strcmp(argv[x], "-o") == 0 && x + 1 < argc)
+			output = argv[++x];
+		else if (strcmp(argv[x], "--geonames") == 0)
+			geonames = true;
+		else if (strcmp(argv[x], "--admin1") == 0 && x + 1 < argc)
+			admin1Path = argv[++x];
+		else if (strcmp(argv[x], "--min-population") == 0 && x + 1 < argc)
+			minPopulation = strtoul(argv[++x], NULL, 10);
+		else if (argv[x][0] == '-') {
+			usage(argv[0]);
+			return 1;
+		} else
+			inputs.push_back(argv[x]);
+	}
+
+	if (output == NULL || inputs.empty()) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	std::map<std::string, std::string> admin1;
+	if (admin1Path != NULL && !load_admin1(admin1Path, admin1)) {
+		std::cerr << "Error: couldn't read " << admin1Path << std::endl;
+		return 1;
+	}
+
+	std::vector<Place> places;
+	for (size_t x = 0; x < inputs.size(); x++) {
+		if (!load_places(inputs[x], geonames, minPopulation, admin1, places)) {
+			std::cerr << "Error: couldn't read " << inputs[x] << std::endl;
+			return 1;
+		}
+	}
+
+	std::stable_sort(places.begin(), places.end(), [](const Place& a, const Place& b) {
+		return sort_key(a.name) < sort_key(b.name);
+	});
+
+	std::vector<place_record> records(places.size());
+	std::vector<place_tree_node> nodes(places.size());
+	std::vector<std::string> keys(places.size());
+	std::string names;
+	for (size_t x = 0; x < places.size(); x++) {
+		keys[x] = sort_key(places[x].name);
+
+		records[x].latitude = places[x].latitude;
+		records[x].longitude = places[x].longitude;
+		records[x].population = places[x].population;
+		records[x].name = names.size();
+		names.append(places[x].name).push_back('\0');
+		names.append(places[x].region).push_back('\0');
+		names.append(places[x].country).push_back('\0');
+
+		double latitude = places[x].latitude * M_PI / 180.0;
+		double longitude = places[x].longitude * M_PI / 180.0;
+		nodes[x].x = cos(latitude) * cos(longitude);
+		nodes[x].y = cos(latitude) * sin(longitude);
+		nodes[x].z = sin(latitude);
+		nodes[x].place = x;
+	}
+
+	TreeBuilder builder = {nodes};
+	builder.Build(0, nodes.size(), 0);
+
+	std::string keyData;
+	std::vector<uint32> keyBlocks;
+	for (size_t x = 0; x < keys.size(); x++) {
+		if (x % kPlaceKeyBlockSize == 0) {
+			keyBlocks.push_back(keyData.size());
+			keyData.append(keys[x]).push_back('\0');
+			continue;
+		}
+
+		size_t shared = 0;
+		while (shared < 255 && shared < keys[x].size() && shared < keys[x - 1].size()
+			&& keys[x][shared] == keys[x - 1][shared])
+			shared++;
+
+		keyData.push_back(static_cast<char>(shared));
+		keyData.append(keys[x], shared, std::string::npos).push_back('\0');
+	}
+
+	TrieBuilder trie = {keys, records, std::vector<place_trie_node>()};
+	trie.Build();
+
+	place_index_header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = kPlaceIndexMagic;
+	header.version = kPlaceIndexVersion;
+	header.place_count = places.size();
+
+	std::string body;
+	add_section(header, body, kPlaceSection, records.data(), records.size() * sizeof(place_record));
+	add_section(header, body, kPlaceNameSection, names.data(), names.size());
+	add_section(header, body, kPlaceTreeSection, nodes.data(), nodes.size() * sizeof(place_tree_node));
+	add_section(header, body, kPlaceKeySection, keyData.data(), keyData.size());
+	add_section(header, body, kPlaceKeyBlockSection, keyBlocks.data(), keyBlocks.size() * sizeof(uint32));
+	add_section(header, body, kPlaceTrieSection, trie.nodes.data(), trie.nodes.size() * sizeof(place_trie_node));
+
+	std::ofstream file(output, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(body.data(), body.size());
+	if (!file) {
+		std::cerr << "Error: couldn't write " << output << std::endl;
+		return 1;
+	}
+
+	std::cout << "Wrote " << places.size() << " places to " << output << std::endl;
+
+	return 0;
+}